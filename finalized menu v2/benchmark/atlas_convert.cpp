@@ -0,0 +1,112 @@
+#include "common.h"
+#include "../renderer/render/convert.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+/*
+* atlas conversion microbenchmark.
+* checks every simd kernel against the scalar reference bit for bit (all 256 coverage values, unaligned
+* starts and odd tails), then times each kernel converting a full 2048x2048 page.
+* exits non-zero when a kernel disagrees with the scalar path.
+* build: g++ -O2 atlas_convert.cpp ../renderer/render/convert.cpp
+*/
+
+static const atlas_format formats[] = { atlas_format::a4r4g4b4, atlas_format::a8, atlas_format::a8r8g8b8 };
+static const convert_kernel kernels[] = { convert_kernel::scalar, convert_kernel::sse2, convert_kernel::avx2 };
+
+static bool matches_scalar(atlas_format format, convert_kernel kernel, const std::vector<std::uint8_t>& source, std::size_t offset, std::size_t count)
+{
+	const std::size_t size = std::size_t(atlas_format_size(format));
+	std::vector<std::uint8_t> expected(count * size), result(count * size);
+
+	convert_coverage(format, source.data() + offset, expected.data(), count, convert_kernel::scalar);
+	convert_coverage(format, source.data() + offset, result.data(), count, kernel);
+
+	// empty vectors have no data to compare, and memcmp doesn't take their null pointers.
+	if (count == 0)
+		return true;
+
+	return std::memcmp(expected.data(), result.data(), expected.size()) == 0;
+}
+
+int main()
+{
+	const int page = 2048;
+	const int iterations = 20;
+
+	// every coverage value, followed by random page contents.
+	std::vector<std::uint8_t> source(std::size_t(page) * page + 64);
+
+	for (std::size_t i = 0; i < 256; i++)
+		source[i] = std::uint8_t(i);
+
+	std::mt19937 random(1337);
+
+	for (std::size_t i = 256; i < source.size(); i++)
+	{
+		// glyph pages are mostly empty, keep about as many zeros as a real one.
+		const unsigned value = random() & 0x1ff;
+		source[i] = value < 256 ? std::uint8_t(value) : 0;
+	}
+
+	for (auto format : formats)
+	{
+		for (auto kernel : kernels)
+		{
+			if (kernel == convert_kernel::scalar || !simd_supported(kernel))
+				continue;
+
+			bool exact = matches_scalar(format, kernel, source, 0, 256);
+
+			// misaligned starts and lengths that leave a scalar tail.
+			for (std::size_t offset = 0; offset < 33 && exact; offset++)
+			{
+				for (std::size_t count : { std::size_t(0), std::size_t(1), std::size_t(15), std::size_t(31), std::size_t(33), std::size_t(1000) + offset })
+					exact = exact && matches_scalar(format, kernel, source, offset, count);
+			}
+
+			exact = exact && matches_scalar(format, kernel, source, 0, std::size_t(page) * page);
+
+			char check[32];
+			std::snprintf(check, sizeof(check), "%-9s %s", atlas_format_name(format), simd_name(kernel));
+			bench::report(check, exact);
+		}
+	}
+
+	std::printf("\n%-9s %-7s %10s %12s %8s\n", "format", "kernel", "ms/page", "mpixels/s", "speedup");
+
+	for (auto format : formats)
+	{
+		std::vector<std::uint8_t> destination(std::size_t(page) * page * atlas_format_size(format));
+		double scalar_ms = 0.0;
+
+		for (auto kernel : kernels)
+		{
+			if (!simd_supported(kernel))
+				continue;
+
+			// warm up once so page faults on the destination aren't timed.
+			convert_coverage(format, source.data(), destination.data(), std::size_t(page) * page, kernel);
+
+			const auto start = std::chrono::steady_clock::now();
+
+			for (int i = 0; i < iterations; i++)
+				convert_coverage(format, source.data(), destination.data(), std::size_t(page) * page, kernel);
+
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+			if (kernel == convert_kernel::scalar)
+				scalar_ms = ms;
+
+			std::printf("%-9s %-7s %10.3f %12.1f %7.2fx\n", atlas_format_name(format), simd_name(kernel),
+				ms, double(page) * page / (ms * 1000.0), scalar_ms / ms);
+		}
+	}
+
+	std::printf("\nbest kernel on this cpu: %s\n", simd_name(simd_best()));
+
+	return bench::exit_code();
+}
@@ -0,0 +1,212 @@
+#include "common.h"
+#include "../renderer/other/color.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+/*
+* color batch kernel checks and microbenchmark.
+* every simd level is compared against the scalar reference: the integer kernels (premultiply, unpremultiply,
+* pack, unpack, lerp) must match exactly, hsv -> rgb may differ by one 8-bit step and rgb -> hsv by 1e-5.
+* the inputs cover every alpha/channel pair, hues outside 0..1 (nan included) plus random data with odd lengths
+* so the tails are exercised.
+* exits non-zero when a kernel is out of tolerance.
+* build: g++ -O2 color_kernels.cpp ../renderer/other/color.cpp
+*/
+
+// color is packed and constexpr, these fold at compile time.
+static_assert(color(0x12, 0x34, 0x56, 0x78).argb() == 0x78123456, "color must pack to d3dcolor argb");
+static_assert(color::from_argb(0x78123456) == color(0x12, 0x34, 0x56, 0x78), "from_argb must invert argb");
+
+static const simd_level levels[] = { simd_level::sse2, simd_level::avx2 };
+
+static void report(const char* kernel, simd_level level, bool passed, const char* detail)
+{
+	char check[96];
+	std::snprintf(check, sizeof(check), "%-13s %-5s%s", kernel, simd_name(level), detail);
+	bench::report(check, passed);
+}
+
+// largest per channel difference between two packed colors.
+static int channel_error(std::uint32_t a, std::uint32_t b)
+{
+	int worst = 0;
+
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		const int difference = std::abs(int((a >> shift) & 0xff) - int((b >> shift) & 0xff));
+		worst = difference > worst ? difference : worst;
+	}
+
+	return worst;
+}
+
+static double time_ms(int iterations, const std::function<void()>& body)
+{
+	body();
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < iterations; i++)
+		body();
+
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main()
+{
+	// every (alpha, channel) pair in the low bytes, random pixels after, and an odd length.
+	const std::size_t count = 65536 + 4093;
+	std::mt19937 random(1337);
+
+	const float out_of_range[] = { -0.25f, -INFINITY, NAN, 1.5f, INFINITY, -0.f };
+
+	std::vector<std::uint32_t> pixels(count), targets(count);
+	std::vector<float> hue(count), saturation(count), value(count);
+	std::vector<color> colors(count);
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		if (i < 65536)
+			pixels[i] = std::uint32_t(i >> 8) << 24 | std::uint32_t(i & 0xff) * 0x010101u;
+		else
+			pixels[i] = random();
+
+		targets[i] = random();
+
+		// exact sextant edges first, hues out of range next (clamped to 0..1 by every kernel), then random hsv.
+		hue[i]			= i < 7 ? i / 6.f : i < 13 ? out_of_range[i - 7] : (random() % 100001) / 100000.f;
+		saturation[i]	= (random() % 100001) / 100000.f;
+		value[i]		= (random() % 100001) / 100000.f;
+
+		colors[i] = color(int(random() % 256), int(random() % 256), int(random() % 256), int(random() % 256));
+	}
+
+	std::vector<std::uint32_t> expected(count), result(count);
+	std::vector<float> expected_h(count), expected_s(count), expected_v(count), result_h(count), result_s(count), result_v(count);
+	std::vector<color> expected_colors(count), result_colors(count);
+
+	for (auto level : levels)
+	{
+		if (!simd_supported(level))
+			continue;
+
+		char detail[64];
+
+		// hsv -> rgb, one step of rounding.
+		color_batch::hsv_to_rgb(hue.data(), saturation.data(), value.data(), expected.data(), count, simd_level::scalar);
+		color_batch::hsv_to_rgb(hue.data(), saturation.data(), value.data(), result.data(), count, level);
+
+		int worst = 0;
+
+		for (std::size_t i = 0; i < count; i++)
+			worst = std::max<int>(worst, channel_error(expected[i], result[i]));
+
+		std::snprintf(detail, sizeof(detail), " (max channel error %d)", worst);
+		report("hsv_to_rgb", level, worst <= 1, detail);
+
+		// rgb -> hsv.
+		color_batch::rgb_to_hsv(pixels.data(), expected_h.data(), expected_s.data(), expected_v.data(), count, simd_level::scalar);
+		color_batch::rgb_to_hsv(pixels.data(), result_h.data(), result_s.data(), result_v.data(), count, level);
+
+		double worst_hsv = 0.0;
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			worst_hsv = std::max<double>(worst_hsv, std::fabs(expected_h[i] - result_h[i]));
+			worst_hsv = std::max<double>(worst_hsv, std::fabs(expected_s[i] - result_s[i]));
+			worst_hsv = std::max<double>(worst_hsv, std::fabs(expected_v[i] - result_v[i]));
+		}
+
+		std::snprintf(detail, sizeof(detail), " (max error %.2e)", worst_hsv);
+		report("rgb_to_hsv", level, worst_hsv <= 1e-5, detail);
+
+		// integer kernels, exact.
+		color_batch::premultiply(pixels.data(), expected.data(), count, simd_level::scalar);
+		color_batch::premultiply(pixels.data(), result.data(), count, level);
+		report("premultiply", level, expected == result, "");
+
+		color_batch::unpremultiply(pixels.data(), expected.data(), count, simd_level::scalar);
+		color_batch::unpremultiply(pixels.data(), result.data(), count, level);
+		report("unpremultiply", level, expected == result, "");
+
+		color_batch::pack(colors.data(), expected.data(), count, simd_level::scalar);
+		color_batch::pack(colors.data(), result.data(), count, level);
+		report("pack", level, expected == result, "");
+
+		color_batch::unpack(pixels.data(), expected_colors.data(), count, simd_level::scalar);
+		color_batch::unpack(pixels.data(), result_colors.data(), count, level);
+		report("unpack", level, std::memcmp(expected_colors.data(), result_colors.data(), count * sizeof(color)) == 0, "");
+
+		bool lerp_exact = true;
+
+		for (float t : { 0.f, 0.25f, 0.3f, 0.5f, 0.999f, 1.f })
+		{
+			color_batch::lerp(pixels.data(), targets.data(), t, expected.data(), count, simd_level::scalar);
+			color_batch::lerp(pixels.data(), targets.data(), t, result.data(), count, level);
+			lerp_exact = lerp_exact && expected == result;
+		}
+
+		report("lerp", level, lerp_exact, "");
+	}
+
+	// the scalar round trip itself, rgb -> hsv -> rgb must land within one step.
+	{
+		color_batch::rgb_to_hsv(pixels.data(), expected_h.data(), expected_s.data(), expected_v.data(), count, simd_level::scalar);
+		color_batch::hsv_to_rgb(expected_h.data(), expected_s.data(), expected_v.data(), result.data(), count, simd_level::scalar);
+
+		int worst = 0;
+
+		for (std::size_t i = 0; i < count; i++)
+			worst = std::max<int>(worst, channel_error(pixels[i] | 0xff000000, result[i]));
+
+		char detail[64];
+		std::snprintf(detail, sizeof(detail), " (max channel error %d)", worst);
+		report("hsv_roundtrip", simd_level::scalar, worst <= 1, detail);
+	}
+
+	// timings.
+	const int iterations = 50;
+	std::printf("\n%-13s %8s %8s %8s   (ns per pixel)\n", "kernel", "scalar", "sse2", "avx2");
+
+	struct benchmark
+	{
+		const char*						name;
+		std::function<void(simd_level)>	run;
+	};
+
+	const benchmark benchmarks[] = {
+		{ "hsv_to_rgb",		[&](simd_level level) { color_batch::hsv_to_rgb(hue.data(), saturation.data(), value.data(), result.data(), count, level); } },
+		{ "rgb_to_hsv",		[&](simd_level level) { color_batch::rgb_to_hsv(pixels.data(), result_h.data(), result_s.data(), result_v.data(), count, level); } },
+		{ "premultiply",	[&](simd_level level) { color_batch::premultiply(pixels.data(), result.data(), count, level); } },
+		{ "unpremultiply",	[&](simd_level level) { color_batch::unpremultiply(pixels.data(), result.data(), count, level); } },
+		{ "pack",			[&](simd_level level) { color_batch::pack(colors.data(), result.data(), count, level); } },
+		{ "unpack",			[&](simd_level level) { color_batch::unpack(pixels.data(), result_colors.data(), count, level); } },
+		{ "lerp",			[&](simd_level level) { color_batch::lerp(pixels.data(), targets.data(), 0.3f, result.data(), count, level); } },
+	};
+
+	for (const auto& handle : benchmarks)
+	{
+		std::printf("%-13s", handle.name);
+
+		for (auto level : { simd_level::scalar, simd_level::sse2, simd_level::avx2 })
+		{
+			if (!simd_supported(level))
+			{
+				std::printf(" %8s", "-");
+				continue;
+			}
+
+			const double ms = time_ms(iterations, [&]() { handle.run(level); });
+			std::printf(" %8.3f", ms * 1e6 / count);
+		}
+
+		std::printf("\n");
+	}
+
+	return bench::exit_code();
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "../renderer/gui/gui.h"
+#include "../renderer/render/truetype.h"
+#include <cstdio>
+#include <cstring>
+
+/*
+* what the benchmarks share.
+* every benchmark checks its results before timing anything and exits non-zero when a check failed, so it
+* doubles as a test. checks are reported on stderr, stdout is left to the timings and json lines.
+* the ones that draw run on the null device with the demo's two fonts loaded from truetype files, so text
+* widths and with them the layout are the same on every machine. when the files aren't there they exit
+* with skipped, which ctest reports as a skipped test rather than a pass with the text left out.
+*/
+
+namespace bench
+{
+	// exit code ctest counts as skipped, see SKIP_RETURN_CODE in CMakeLists.txt.
+	constexpr int skipped = 77;
+
+	inline int failures = 0;
+
+	inline void report(const char* check, bool passed)
+	{
+		std::fprintf(stderr, "check %-24s %s\n", check, passed ? "ok" : "FAILED");
+
+		if (!passed)
+			failures++;
+	}
+
+	inline int exit_code()
+	{
+		return failures ? 1 : 0;
+	}
+
+	// checks that ran before the skip still fail the run.
+	inline int skip()
+	{
+		return failures ? 1 : skipped;
+	}
+
+	// the null device and the renderer on it, with segoe_ui and segoe_ui_bold rasterized from files.
+	class headless
+	{
+	public:
+		const char* regular	= "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+		const char* bold	= "/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf";
+
+		IDirect3DDevice9 device{ 1920, 1080 };
+
+		// --font and --bold, true when argv[i] was one of them.
+		bool option(int argc, char** argv, int& i)
+		{
+			if (std::strcmp(argv[i], "--font") == 0 && i + 1 < argc)
+				this->regular = argv[++i];
+			else if (std::strcmp(argv[i], "--bold") == 0 && i + 1 < argc)
+				this->bold = argv[++i];
+			else
+				return false;
+
+			return true;
+		}
+
+		// false when a font file can't be loaded, the caller exits through skip().
+		bool setup()
+		{
+			render->setup(&this->device);
+
+			if (!this->regular_face.load_file(this->regular) || !this->bold_face.load_file(this->bold))
+			{
+				std::fprintf(stderr, "fonts not found (%s, %s), skipping\n", this->regular, this->bold);
+				return false;
+			}
+
+			fonts->segoe_ui.setup_glyphs(this->regular_face);
+			fonts->segoe_ui_bold.setup_glyphs(this->bold_face);
+			atlas->add(&fonts->segoe_ui);
+			atlas->add(&fonts->segoe_ui_bold);
+			atlas->build(2048);
+
+			// the menu key the demo uses, gui_instance::think polls it every frame.
+			gui::events->set_key(VK_INSERT);
+			return true;
+		}
+
+	private:
+		truetype_font regular_face, bold_face;
+	};
+}
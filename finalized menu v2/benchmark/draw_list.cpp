@@ -0,0 +1,277 @@
+#include "common.h"
+#include "../renderer/render/draw_list.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+/*
+* retained draw list checks and benchmark, runs without a device.
+* records a window's worth of rects, lines, text runs, clipped groups and shapes the way environment_render
+* does while capturing, then checks that consecutive primitives merged into few commands, that merged
+* geometry keeps its indices in range and that translating a list moves every vertex, glyph, clip and hover
+* test. then times recording the window again against translating the recorded list, which is what a
+* window that was only dragged costs now, and what hashing a frame for the skip_identical present mode costs.
+* exits non-zero when a check fails.
+* build: g++ -O2 draw_list.cpp ../renderer/render/draw_list.cpp ../renderer/render/batch.cpp
+*/
+
+// what filled_rect records: 4 vertices in strip order.
+static void record_rect(draw_list& list, int x, int y, int w, int h, color colour)
+{
+	const vertex quad[4] = {
+		vertex({ x - 0.5f, y - 0.5f }, { 0.f, 1.f }, colour.argb()),
+		vertex({ x + w - 0.5f, y - 0.5f }, { 0.f, 1.f }, colour.argb()),
+		vertex({ x - 0.5f, y + h - 0.5f }, { 0.f, 1.f }, colour.argb()),
+		vertex({ x + w - 0.5f, y + h - 0.5f }, { 0.f, 1.f }, colour.argb())
+	};
+
+	list.add_quad(quad);
+}
+
+// a text run of a few glyphs, 6 vertices each like the fonts emit.
+static void record_text(draw_list& list, int page, int x, int y, int glyphs)
+{
+	FONT2DVERTEX vertices[6 * 16];
+
+	for (int i = 0; i < glyphs * 6; i++)
+		vertices[i] = InitFont2DVertex(float(x + (i / 6) * 7 + (i % 2) * 6), float(y + (i % 3) * 5), 0xffffffff, 0.f, 0.f);
+
+	list.add_text(page, false, vertices, glyphs * 6);
+}
+
+// roughly what the demo window records: background, tab bar, four groups of widgets with labels and a knob.
+static void record_window(draw_list& list, int x, int y, std::vector<vertex>& geometry, std::vector<std::uint16_t>& indices)
+{
+	record_rect(list, x, y, 660, 560, color(20, 20, 20));
+	record_rect(list, x, y + 1, 100, 559, color(12, 12, 12));
+
+	const vertex line[2] = { vertex({ float(x + 100), float(y) }, { 0.f, 1.f }, 0xff232323), vertex({ float(x + 100), float(y + 560) }, { 0.f, 1.f }, 0xff232323) };
+	list.add_line(line);
+
+	for (int tab = 0; tab < 5; tab++)
+		record_text(list, 1, x + 30, y + 40 + tab * 95, 2);
+
+	for (int group = 0; group < 4; group++)
+	{
+		const rect area(x + 125 + (group % 2) * 265, y + 20 + (group / 2) * 270, 250, 250);
+
+		record_rect(list, area.x, area.y, area.w, area.h, color(12, 12, 12));
+		list.start_clip(area);
+
+		for (int widget = 0; widget < 10; widget++)
+		{
+			const int row = area.y + 10 + widget * 24;
+
+			record_rect(list, area.x + 20, row, 9, 9, color(25, 25, 25));
+			record_rect(list, area.x + 20, row, 9, 1, color(35, 35, 35));
+			record_rect(list, area.x + 20, row, 1, 9, color(35, 35, 35));
+			record_rect(list, area.x + 28, row, 1, 9, color(35, 35, 35));
+			record_rect(list, area.x + 20, row + 8, 9, 1, color(35, 35, 35));
+			record_text(list, 0, area.x + 40, row, 12);
+			list.add_probe(rect(area.x + 20, row, 200, 9), false);
+		}
+
+		geometry.clear();
+		indices.clear();
+		const vector_2d knob[4] = { { float(area.x + 200), float(area.y + 200) }, { float(area.x + 220), float(area.y + 200) }, { float(area.x + 220), float(area.y + 220) }, { float(area.x + 200), float(area.y + 220) } };
+		fill_batch::convex(knob, 4, color(99, 160, 200), geometry, indices);
+		list.add_geometry(geometry, indices);
+
+		geometry.clear();
+		indices.clear();
+		line_batch::polyline(knob, 4, 0, 4, 2.f, color(255, 255, 255), true, geometry, indices);
+		list.add_geometry(geometry, indices);
+
+		list.end_clip();
+	}
+}
+
+static std::size_t count_type(const draw_list& list, draw_command_type type)
+{
+	std::size_t count = 0;
+
+	for (const auto& command : list.commands)
+	{
+		if (command.type == type)
+			count++;
+	}
+
+	return count;
+}
+
+int main()
+{
+	draw_list list;
+	std::vector<vertex> geometry;
+	std::vector<std::uint16_t> indices;
+
+	record_window(list, 100, 100, geometry, indices);
+
+	// merging: inside a group the rects and the text interleave, so each widget costs a quad and a text
+	// command, but runs of the same kind collapse and the two shapes per group share one geometry command.
+	{
+		const std::size_t quads = list.vertices.size();
+		bool ok = count_type(list, draw_command_type::geometry) == 4 && count_type(list, draw_command_type::clip_start) == 4;
+		ok = ok && count_type(list, draw_command_type::lines) == 1 && list.probes.size() == 40;
+
+		std::size_t drawn = 0;
+
+		for (const auto& command : list.commands)
+		{
+			if (command.type == draw_command_type::quads)
+				ok = ok && command.count % 4 == 0;
+
+			drawn += command.type == draw_command_type::text ? 0 : command.count;
+		}
+
+		ok = ok && drawn == quads && count_type(list, draw_command_type::quads) < 4 * 10 * 5;
+		bench::report("merging", ok);
+	}
+
+	// merged geometry indexes from its command's first vertex and stays inside its vertices.
+	{
+		bool ok = true;
+
+		for (const auto& command : list.commands)
+		{
+			if (command.type != draw_command_type::geometry)
+				continue;
+
+			ok = ok && command.index_count % 3 == 0 && command.first_index + command.index_count <= list.indices.size();
+
+			for (std::size_t i = 0; ok && i < command.index_count; i++)
+				ok = list.indices[command.first_index + i] < command.count;
+		}
+
+		bench::report("geometry indices", ok);
+	}
+
+	// text runs on the same page merge, a page change starts a new command.
+	{
+		draw_list text;
+		record_text(text, 0, 0, 0, 4);
+		record_text(text, 0, 0, 10, 4);
+		record_text(text, 1, 0, 20, 4);
+		record_text(text, 1, 0, 30, 4);
+
+		const bool ok = text.commands.size() == 2 && text.commands[0].count == 48 && text.commands[1].first == 48 && text.glyphs.size() == 96;
+		bench::report("text runs", ok);
+	}
+
+	// translating matches recording at the new position.
+	{
+		draw_list moved;
+		record_window(moved, 137, 81, geometry, indices);
+
+		draw_list translated = list;
+		translated.translate(37, -19);
+
+		bool ok = moved.commands.size() == translated.commands.size() && moved.vertices.size() == translated.vertices.size() && moved.glyphs.size() == translated.glyphs.size();
+
+		for (std::size_t i = 0; ok && i < moved.vertices.size(); i++)
+			ok = moved.vertices[i].position.x == translated.vertices[i].position.x && moved.vertices[i].position.y == translated.vertices[i].position.y;
+
+		for (std::size_t i = 0; ok && i < moved.glyphs.size(); i++)
+			ok = moved.glyphs[i].x == translated.glyphs[i].x && moved.glyphs[i].y == translated.glyphs[i].y;
+
+		for (std::size_t i = 0; ok && i < moved.commands.size(); i++)
+			ok = moved.commands[i].type != draw_command_type::clip_start || (moved.commands[i].clip.x == translated.commands[i].clip.x && moved.commands[i].clip.y == translated.commands[i].clip.y);
+
+		for (std::size_t i = 0; ok && i < moved.probes.size(); i++)
+			ok = moved.probes[i].area.x == translated.probes[i].area.x && moved.probes[i].area.y == translated.probes[i].area.y;
+
+		bench::report("translate", ok);
+	}
+
+	// frame hashes: the same frame hashes the same, any changed color, glyph or clip changes it.
+	{
+		draw_list again;
+		record_window(again, 100, 100, geometry, indices);
+
+		bool ok = again.hash() == list.hash();
+
+		again.vertices[again.vertices.size() / 2].colour ^= 1;
+		ok = ok && again.hash() != list.hash();
+		again.vertices[again.vertices.size() / 2].colour ^= 1;
+
+		again.glyphs[7].tu += 1.f;
+		ok = ok && again.hash() != list.hash();
+		again.glyphs[7].tu -= 1.f;
+
+		for (auto& command : again.commands)
+		{
+			if (command.type == draw_command_type::clip_start)
+			{
+				command.clip.h++;
+				break;
+			}
+		}
+
+		ok = ok && again.hash() != list.hash();
+		bench::report("frame hash", ok);
+	}
+
+	// a window's list replayed into the frame's capture keeps every command and hashes the same.
+	{
+		draw_list frame;
+		frame.append(list);
+
+		bool ok = frame.hash() == list.hash() && frame.commands.size() == list.commands.size() && frame.probes.empty();
+
+		frame.add_surface(nullptr, 1, rect(0, 0, 10, 10));
+		const std::uint64_t first = frame.hash();
+		frame.commands.back().version = 2;
+		ok = ok && frame.hash() != first;
+
+		bench::report("append", ok);
+	}
+
+	// clearing keeps the capacity so a re-record doesn't allocate.
+	{
+		const std::size_t memory = list.memory();
+		list.clear();
+		const bool ok = list.empty() && list.vertices.empty() && list.memory() == memory && memory > 0;
+		bench::report("clear", ok);
+	}
+
+	// timings: recording the window each frame against moving the recorded list.
+	const int frames = 2000, runs = 10;
+	double best_record = 1e30, best_translate = 1e30, best_hash = 1e30;
+	std::uint64_t hashes = 0;
+
+	for (int run = 0; run < runs; run++)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		for (int frame = 0; frame < frames; frame++)
+		{
+			list.clear();
+			record_window(list, 100 + frame % 7, 100, geometry, indices);
+		}
+
+		best_record = std::min<double>(best_record, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+		start = std::chrono::steady_clock::now();
+
+		for (int frame = 0; frame < frames; frame++)
+			list.translate(frame & 1 ? 1 : -1, 0);
+
+		best_translate = std::min<double>(best_translate, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+		start = std::chrono::steady_clock::now();
+
+		for (int frame = 0; frame < frames; frame++)
+			hashes += list.hash();
+
+		best_hash = std::min<double>(best_hash, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	std::printf("\n%d frames, best of %d runs, %zu commands, %zu vertices, %zu glyph vertices, %zu bytes\n", frames, runs, list.commands.size(), list.vertices.size(), list.glyphs.size(), list.memory());
+	std::printf("%-10s %10s %14s\n", "path", "ms", "us per frame");
+	std::printf("%-10s %10.3f %14.3f\n", "record", best_record, best_record * 1000.0 / frames);
+	std::printf("%-10s %10.3f %14.3f\n", "translate", best_translate, best_translate * 1000.0 / frames);
+	std::printf("%-10s %10.3f %14.3f\n", "hash", best_hash, best_hash * 1000.0 / frames);
+	std::printf("(hash sum %llx)\n", (unsigned long long)hashes);
+
+	return bench::exit_code();
+}
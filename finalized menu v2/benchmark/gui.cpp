@@ -0,0 +1,545 @@
+#include "common.h"
+#include "../renderer/gui/gui.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+/*
+* headless gui benchmark.
+* builds synthetic menus of n windows x m groups x k widgets, cycling through every widget type in gui.h,
+* drives them with a scripted mouse (hover sweeps, clicks, slider drags, window drags, wheel, escape) and
+* times think and draw per frame. draw either goes to the null device from platform.h or is recorded into
+* a draw list and hashed, which is what the skip_identical present mode does every frame.
+* before timing it checks that scripted input reaches the widgets, that cached windows draw exactly what
+* recording them again every frame would, and that offscreen surfaces keep to their budget, are only
+* redrawn when the window is and come back after a lost device.
+* every configuration prints one json object per line on stdout, checks go to stderr, so the output can
+* be collected per commit as is. exits non-zero when a check fails.
+* usage: gui [--frames n] [--font path] [--bold path] [--quick]
+* build: g++ -O2 -pthread gui.cpp ../renderer/gui/{gui,input_log}.cpp
+*        ../renderer/render/{atlas,batch,convert,draw_list,font,render,shape,stats,telemetry,truetype}.cpp
+*        ../renderer/other/{allocations,color,histogram}.cpp
+*/
+
+using namespace gui;
+
+struct menu_shape
+{
+	int windows;
+	int groups;		// per window.
+	int widgets;	// per group.
+};
+
+enum class backend
+{
+	null_device,
+	recording
+};
+
+struct run_options
+{
+	backend	target		= backend::null_device;
+	bool	cached		= true;		// false drops every window's draw list each frame.
+	bool	hud			= true;
+	bool	offscreen	= true;
+	int		warmup		= 0;
+	int		frames		= 0;
+};
+
+static const char* fruits[] = { "apple", "banana", "pineapple", "orange", "grape", "melon" };
+
+// where to point the mouse to hit a widget, relative to its draw position.
+struct widget_target
+{
+	element*	widget;
+	point		offset;
+};
+
+// one synthetic menu. the gui keeps pointers to titles and bound values, deques keep them where they are.
+class synthetic_menu
+{
+public:
+	synthetic_menu(const menu_shape& shape, bool hud, bool offscreen)
+	{
+		for (int w = 0; w < shape.windows; w++)
+		{
+			auto main = new window(this->name("window %d", w), { 40 + 60 * w, 40 + 40 * w }, { 700, 600 });
+			this->windows.push_back(main);
+			this->targets.emplace_back();
+
+			// every other window puts its columns in a sub tab, so both layouts are measured.
+			const bool in_sub	= w % 2 == 1;
+			auto handle			= new tab(this->name("T%d", w), main, in_sub);
+			sub_tab* sub		= in_sub ? new sub_tab("sub", handle) : nullptr;
+
+			column* columns[2] = { };
+
+			for (int c = 0; c < 2; c++)
+				columns[c] = in_sub ? new column(sub) : new column(handle);
+
+			// groups fill two columns, whatever doesn't fit is reached by scrolling.
+			const int rows		= (shape.groups + 1) / 2;
+			const int height	= std::max<int>(80, (in_sub ? 460 : 540) / std::max<int>(rows, 1) - 40);
+
+			for (int g = 0; g < shape.groups; g++)
+			{
+				column* parent	= columns[g % 2];
+				auto box		= new group(this->name("group %d", g), { 270, height }, parent);
+
+				for (int k = 0; k < shape.widgets; k++)
+					this->add_widget(box, k, hud && g == 0);
+
+				parent->add(box);
+			}
+
+			for (auto parent : columns)
+			{
+				if (in_sub)
+					sub->add(parent);
+				else
+					handle->add(parent);
+			}
+
+			if (in_sub)
+			{
+				handle->add(sub);
+				handle->set_default_sub(sub);
+			}
+
+			main->add(handle);
+			main->set_default_tab(handle);
+			main->set_offscreen(offscreen);
+
+			this->instance.add(main);
+		}
+	}
+
+	// how many bound values scripted input changed since the menu was built.
+	int changed() const
+	{
+		int count = 0;
+
+		for (const auto& value : this->bools)
+			count += value ? 1 : 0;
+
+		for (const auto& value : this->ints)
+			count += value != 0 ? 1 : 0;
+
+		for (const auto& value : this->floats)
+			count += value != 0.f ? 1 : 0;
+
+		return count;
+	}
+
+	gui_instance							instance;
+	std::vector<window*>					windows;
+	std::vector<std::vector<widget_target>>	targets;	// per window.
+	int										elements = 0;
+
+private:
+	const char* name(const char* format, int index)
+	{
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), format, index);
+		this->names.emplace_back(buffer);
+		return this->names.back().c_str();
+	}
+
+	void add_widget(group* parent, int index, bool hud)
+	{
+		const char* title = this->name("widget %d", index);
+		this->elements++;
+
+		// the first widget of a window's first group is its hud when there is one, everything else cycles.
+		if (hud && index == 0)
+		{
+			this->add(parent, new perf_hud(parent, title), { 140, 20 });
+			return;
+		}
+
+		switch (index % 7)
+		{
+		case 0:
+			this->bools.push_back(false);
+			this->add(parent, new checkbox(parent, title, &this->bools.back()), { 109, 4 });
+			break;
+
+		case 1:
+			this->ints.push_back(0);
+			this->add(parent, new slider_int(parent, title, &this->ints.back(), 0, 100, "%"), { 200, 9 });
+			break;
+
+		case 2:
+			this->floats.push_back(0.f);
+			this->add(parent, new slider_float(parent, title, &this->floats.back(), 0.f, 100.f, "%"), { 200, 9 });
+			break;
+
+		case 3:
+			this->ints.push_back(0);
+			this->add(parent, new combo(parent, title, &this->ints.back(), { fruits[0], fruits[1], fruits[2], fruits[3] }), { 200, 14 });
+			break;
+
+		case 4:
+		{
+			auto box = new multi(parent, title);
+
+			for (auto fruit : fruits)
+			{
+				this->bools.push_back(false);
+				box->add(fruit, &this->bools.back());
+			}
+
+			this->add(parent, box, { 200, 14 });
+			break;
+		}
+
+		case 5:
+			this->bools.push_back(false);
+			this->keys.push_back(-1);
+			this->add(parent, new keybind(parent, title, &this->bools.back(), &this->keys.back()), { 319, 0 });
+			break;
+
+		case 6:
+			this->colors.push_back(color());
+			this->add(parent, new color_picker(parent, title, color(255, 0, 0), &this->colors.back()), { 320, 2 });
+			break;
+		}
+	}
+
+	void add(group* parent, element* widget, point offset)
+	{
+		parent->add(widget);
+		this->targets.back().push_back({ widget, offset });
+	}
+
+	std::deque<std::string>	names;
+	std::deque<bool>		bools;
+	std::deque<int>			ints;
+	std::deque<int>			keys;
+	std::deque<float>		floats;
+	std::deque<color>		colors;
+};
+
+// scripted input for frame, a mix of what a user does with the menu open. every 240 frames the script
+// moves on to the next window: it walks the widgets clicking them, drags along one, hovers at random and
+// finally drags the window by its edge.
+static void script_input(synthetic_menu& menu, int frame)
+{
+	const int cycle									= frame % 240;
+	const std::size_t index							= std::size_t(frame / 240) % menu.windows.size();
+	const std::vector<widget_target>& targets		= menu.targets[index];
+	const point origin								= menu.windows[index]->get_position();
+	const dimension size							= menu.windows[index]->get_size();
+
+	bool left = false;
+
+	if (cycle < 120 && !targets.empty())
+	{
+		// five frames per widget, pressed on the first and let go on the second.
+		const widget_target& target = targets[std::size_t(frame / 5) % targets.size()];
+		input->mouse	= target.widget->draw_position() + target.offset;
+		left			= frame % 5 == 0;
+	}
+	else if (cycle < 140 && !targets.empty())
+	{
+		// hold and sweep sideways over one widget, which drags sliders and the picker's selectors.
+		const widget_target& target = targets[std::size_t(frame / 240) % targets.size()];
+		input->mouse	= target.widget->draw_position() + target.offset + point((cycle - 130) * 8, 0);
+		left			= cycle < 139;
+	}
+	else if (cycle >= 200 && cycle < 220)
+	{
+		// grab the top edge and drag, back and forth every other cycle.
+		const int step	= (frame / 240) % 2 == 0 ? 2 : -2;
+		input->mouse	= { origin.x + size.w / 2 + (cycle > 200 ? step : 0), origin.y + 2 + (cycle > 200 ? step : 0) };
+		left			= cycle < 219;
+	}
+	else
+	{
+		// hover around the window, clicking every tenth frame.
+		const unsigned mixed = unsigned(frame) * 2654435761u;
+		input->mouse	= { origin.x + 20 + int((mixed >> 8) % unsigned(size.w - 40)), origin.y + 20 + int((mixed >> 20) % unsigned(size.h - 40)) };
+		left			= frame % 10 == 0;
+	}
+
+	input->script_key(VK_LBUTTON, left);
+	input->script_key(VK_RBUTTON, frame % 70 == 35);
+	input->script_key(VK_ESCAPE, frame % 90 == 89);
+	input->set_mouse_wheel(frame % 25 == 0 ? ((frame / 25) % 2 == 0 ? -1 : 1) : 0);
+}
+
+// back to a clean slate between runs: nothing focused, no keys held, fresh statistics.
+static void reset_input()
+{
+	events->set_focussed(nullptr);
+	input->set_scripted(true);
+	input->set_mouse_wheel(0);
+	input->poll_input();
+	input->poll_input();
+	statistics->reset();
+}
+
+struct frame_times
+{
+	std::vector<double> think;
+	std::vector<double> draw;
+};
+
+struct run_result
+{
+	frame_times					times;
+	render_stats				sums;
+	std::uint64_t				commands = 0;
+	std::vector<std::uint64_t>	hashes;
+	int							changed = 0;
+};
+
+static double microseconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+	return std::chrono::duration<double, std::micro>(to - from).count();
+}
+
+// one frame the way entry.cpp runs it, either drawn to the null device or recorded into a list.
+static run_result run(const menu_shape& shape, const run_options& options)
+{
+	synthetic_menu menu(shape, options.hud, options.offscreen);
+	reset_input();
+
+	run_result result;
+	draw_list frame;
+
+	for (int i = 0; i < options.warmup + options.frames; i++)
+	{
+		script_input(menu, i);
+
+		if (!options.cached)
+			menu.instance.invalidate();
+
+		const auto start = std::chrono::steady_clock::now();
+		menu.instance.think();
+		const auto thought = std::chrono::steady_clock::now();
+
+		if (options.target == backend::recording)
+		{
+			frame.clear();
+			render->begin_capture(&frame);
+			menu.instance.draw();
+			render->end_capture();
+			result.hashes.push_back(frame.hash());
+		}
+		else
+		{
+			menu.instance.draw();
+			atlas->flush();
+		}
+
+		const auto drawn = std::chrono::steady_clock::now();
+		statistics->end_frame();
+
+		if (i < options.warmup)
+			continue;
+
+		result.times.think.push_back(microseconds(start, thought));
+		result.times.draw.push_back(microseconds(thought, drawn));
+		result.sums += statistics->history(0);
+		result.commands += frame.commands.size();
+	}
+
+	result.changed = menu.changed();
+	return result;
+}
+
+// one recorded frame, with the version of every surface it composited.
+static std::vector<std::uint32_t> surface_versions(synthetic_menu& menu)
+{
+	draw_list frame;
+
+	menu.instance.think();
+	render->begin_capture(&frame);
+	menu.instance.draw();
+	render->end_capture();
+	statistics->end_frame();
+
+	std::vector<std::uint32_t> versions;
+
+	for (const auto& command : frame.commands)
+	{
+		if (command.type == draw_command_type::surface)
+			versions.push_back(command.version);
+	}
+
+	return versions;
+}
+
+static double percentile(std::vector<double> values, double fraction)
+{
+	if (values.empty())
+		return 0.0;
+
+	const std::size_t rank = std::min<std::size_t>(values.size() - 1, std::size_t(fraction * double(values.size() - 1) + 0.5));
+	std::nth_element(values.begin(), values.begin() + rank, values.end());
+	return values[rank];
+}
+
+static double mean(const std::vector<double>& values)
+{
+	double sum = 0.0;
+
+	for (double value : values)
+		sum += value;
+
+	return values.empty() ? 0.0 : sum / double(values.size());
+}
+
+static void print_result(const menu_shape& shape, const run_options& options, const run_result& result)
+{
+	const double n = double(std::max<std::size_t>(result.times.draw.size(), 1));
+
+	std::vector<double> total(result.times.draw.size());
+
+	for (std::size_t i = 0; i < total.size(); i++)
+		total[i] = result.times.think[i] + result.times.draw[i];
+
+	std::printf("{\"benchmark\":\"gui\",\"windows\":%d,\"groups\":%d,\"widgets\":%d,\"backend\":\"%s\",\"cache\":%s,\"frames\":%zu,",
+		shape.windows, shape.groups, shape.widgets, options.target == backend::recording ? "recording" : "null", options.cached ? "true" : "false", result.times.draw.size());
+
+	std::printf("\"think_mean_us\":%.2f,\"think_p50_us\":%.2f,\"think_p99_us\":%.2f,\"draw_mean_us\":%.2f,\"draw_p50_us\":%.2f,\"draw_p99_us\":%.2f,\"frame_p99_us\":%.2f,",
+		mean(result.times.think), percentile(result.times.think, 0.5), percentile(result.times.think, 0.99),
+		mean(result.times.draw), percentile(result.times.draw, 0.5), percentile(result.times.draw, 0.99), percentile(total, 0.99));
+
+	// per frame averages.
+	std::printf("\"draw_calls\":%.1f,\"vertices\":%.1f,\"glyphs\":%.1f,\"state_changes\":%.1f,\"clip_changes\":%.1f,\"commands\":%.1f,\"allocations\":%.1f}\n",
+		result.sums.draw_calls / n, result.sums.vertices / n, result.sums.glyphs / n, result.sums.state_changes / n, result.sums.clip_changes / n,
+		double(result.commands) / n, result.sums.allocations / n);
+
+	std::fflush(stdout);
+}
+
+int main(int argc, char** argv)
+{
+	int frames = 600;
+	bench::headless fixture;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frames = std::max<int>(1, std::atoi(argv[++i]));
+		else if (fixture.option(argc, argv, i))
+			continue;
+		else if (std::strcmp(argv[i], "--quick") == 0)
+			frames = 120;
+		else
+		{
+			std::fprintf(stderr, "usage: %s [--frames n] [--font path] [--bold path] [--quick]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	// no system fonts here, the glyphs come from truetype files.
+	if (!fixture.setup())
+		return bench::skip();
+
+	// scripted input reaches the widgets, and the null device sees what the statistics count.
+	{
+		run_options options;
+		options.frames = 480;
+
+		const std::uint64_t draws_before	= fixture.device.draw_calls;
+		const run_result result				= run({ 2, 2, 14 }, options);
+
+		bench::report("input reaches widgets", result.changed > 0);
+		bench::report("frames draw", result.sums.draw_calls > 0 && fixture.device.draw_calls > draws_before && result.sums.glyphs > 0);
+	}
+
+	// a cached window replays exactly what recording it again would draw, hover, clicks and drags included.
+	// the hud redraws on a timer and surfaces are versioned per redraw, so both stay out of this one.
+	{
+		run_options options;
+		options.target		= backend::recording;
+		options.hud			= false;
+		options.offscreen	= false;
+		options.frames		= 720;
+
+		const run_result cached = run({ 3, 4, 14 }, options);
+
+		options.cached = false;
+		const run_result uncached = run({ 3, 4, 14 }, options);
+
+		bench::report("cache matches record", cached.hashes == uncached.hashes);
+	}
+
+	// surfaces on the null device: what doesn't fit the budget is drawn directly, device loss releases every
+	// one of them, and the version only moves when the texture is drawn again.
+	{
+		const std::size_t budget	= 16 * 1024 * 1024;
+		const std::size_t window	= std::size_t(700 + 12) * (600 + 12) * 4;
+
+		render_surface first, second;
+		render->set_surface_budget(1024 * 1024);
+
+		bool ok = render->acquire_surface(first, 400, 400) && !render->acquire_surface(second, 400, 400);
+		ok = ok && !second.texture && render->surface_memory() == 400 * 400 * 4;
+
+		// the same size again keeps the texture.
+		const LPDIRECT3DTEXTURE9 texture = first.texture;
+		ok = ok && render->acquire_surface(first, 400, 400) && first.texture == texture;
+
+		render->release_surface(first);
+		ok = ok && !first.texture && render->surface_memory() == 0;
+
+		// the first window is under the second, so it is the one kept in a surface.
+		synthetic_menu menu({ 2, 2, 7 }, false, true);
+		reset_input();
+		input->mouse = { 1900, 1070 };
+
+		render->set_surface_budget(0);
+		ok = ok && surface_versions(menu).empty() && render->surface_memory() == 0;
+		bench::report("surface budget", ok);
+
+		render->set_surface_budget(budget);
+		const std::vector<std::uint32_t> drawn = surface_versions(menu);
+		const std::vector<std::uint32_t> again = surface_versions(menu);
+
+		ok = drawn.size() == 1 && again == drawn && render->surface_memory() == window;
+
+		menu.windows[0]->invalidate();
+		const std::vector<std::uint32_t> redrawn = surface_versions(menu);
+
+		ok = ok && redrawn.size() == 1 && redrawn[0] == drawn[0] + 1;
+		bench::report("surface versions", ok);
+
+		render->lost_device();
+		ok = render->surface_memory() == 0;
+
+		render->reset_device();
+		const std::vector<std::uint32_t> restored = surface_versions(menu);
+
+		ok = ok && restored.size() == 1 && restored[0] == redrawn[0] + 1 && render->surface_memory() == window;
+		bench::report("surface device loss", ok);
+	}
+
+	const menu_shape shapes[] = { { 1, 2, 7 }, { 2, 4, 14 }, { 4, 6, 21 }, { 8, 8, 28 } };
+	const int warmup = std::min<int>(60, frames);
+
+	// cached against the null device is a normal frame, uncached is every window changing every frame.
+	run_options configurations[3];
+	configurations[1].cached = false;
+	configurations[2].target = backend::recording;
+
+	for (const auto& shape : shapes)
+	{
+		for (auto& options : configurations)
+		{
+			options.warmup = warmup;
+			options.frames = frames;
+			print_result(shape, options, run(shape, options));
+		}
+	}
+
+	return bench::exit_code();
+}
@@ -0,0 +1,480 @@
+#include "common.h"
+#include "../renderer/gui/gui.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+/*
+* microbenchmarks for the helpers the gui calls per widget per frame.
+* each one runs over a fixed dataset shaped like what the gui feeds it: the color picker's hue, saturation
+* and value sweep, the titles and formatted values widgets measure, every widget of a window in both tab
+* layouts, a frame of hover tests, multi boxes in every selection. results are checked before anything
+* is timed. each helper prints the best of several runs as one json object per line on stdout, checks go
+* to stderr, so the output can be collected per commit as is. exits non-zero when a check fails.
+* usage: helpers [--runs n] [--font path] [--bold path] [--quick]
+* build: g++ -O2 -pthread helpers.cpp ../renderer/gui/{gui,input_log}.cpp
+*        ../renderer/render/{atlas,batch,convert,draw_list,font,render,shape,stats,telemetry,truetype}.cpp
+*        ../renderer/other/{allocations,color,histogram}.cpp
+*/
+
+using namespace gui;
+
+// results are folded in here so the optimizer can't drop the calls being timed.
+static volatile std::uint64_t sink = 0;
+
+struct timing
+{
+	int			runs	= 15;
+	std::size_t	calls	= 200000;	// per run, rounded up to whole passes over the dataset.
+};
+
+// best of the runs in nanoseconds per call, the least disturbed run is the closest to the helper's cost.
+template <class F>
+static void measure(const char* helper, const char* dataset, std::size_t size, const timing& settings, F&& pass)
+{
+	const std::size_t passes = std::max<std::size_t>(1, (settings.calls + size - 1) / size);
+	double best = 0.0;
+
+	for (int run = 0; run < settings.runs; run++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		for (std::size_t i = 0; i < passes; i++)
+			pass();
+
+		const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / double(passes * size);
+		best = run ? std::min<double>(best, elapsed) : elapsed;
+	}
+
+	std::printf("{\"benchmark\":\"helpers\",\"helper\":\"%s\",\"dataset\":\"%s\",\"size\":%zu,\"calls\":%zu,\"ns_per_call\":%.2f}\n",
+		helper, dataset, size, passes * size, best);
+	std::fflush(stdout);
+}
+
+// a window the way menus build them, either tab > column > group > widget or with a sub tab in between.
+class widget_tree
+{
+public:
+	widget_tree(bool in_sub)
+	{
+		this->main = new window("helpers", { 100, 100 }, { 700, 600 });
+
+		auto handle		= new tab("A", this->main, in_sub);
+		sub_tab* sub	= in_sub ? new sub_tab("sub", handle) : nullptr;
+		column* columns[2] = { };
+
+		for (int c = 0; c < 2; c++)
+			columns[c] = in_sub ? new column(sub) : new column(handle);
+
+		for (int g = 0; g < 4; g++)
+		{
+			column* parent	= columns[g % 2];
+			auto box		= new group("group", { 270, 250 }, parent);
+
+			for (int k = 0; k < 7; k++)
+				this->add_widget(box, k);
+
+			parent->add(box);
+		}
+
+		for (auto parent : columns)
+		{
+			if (in_sub)
+				sub->add(parent);
+			else
+				handle->add(parent);
+		}
+
+		if (in_sub)
+		{
+			handle->add(sub);
+			handle->set_default_sub(sub);
+		}
+
+		this->main->add(handle);
+		this->main->set_default_tab(handle);
+	}
+
+	~widget_tree()
+	{
+		delete this->main;
+	}
+
+	window*					main;
+	std::vector<element*>	widgets;
+
+private:
+	void add_widget(group* parent, int index)
+	{
+		element* widget = nullptr;
+
+		switch (index)
+		{
+		case 0: this->bools.push_back(false); widget = new checkbox(parent, "checkbox", &this->bools.back()); break;
+		case 1: this->ints.push_back(0); widget = new slider_int(parent, "slider int", &this->ints.back(), 0, 100, "%"); break;
+		case 2: this->floats.push_back(0.f); widget = new slider_float(parent, "slider float", &this->floats.back(), 0.f, 100.f, "%"); break;
+		case 3: this->ints.push_back(0); widget = new combo(parent, "combo", &this->ints.back(), { "apple", "banana", "pineapple", "orange" }); break;
+		case 4:
+		{
+			auto box = new multi(parent, "multi");
+
+			for (int i = 0; i < 4; i++)
+			{
+				this->bools.push_back(false);
+				box->add("item", &this->bools.back());
+			}
+
+			widget = box;
+			break;
+		}
+		case 5: this->bools.push_back(false); this->ints.push_back(-1); widget = new keybind(parent, "keybind", &this->bools.back(), &this->ints.back()); break;
+		default: this->colors.emplace_back(); widget = new color_picker(parent, "picker", color(255, 0, 0), &this->colors.back(), true); break;
+		}
+
+		parent->add(widget);
+		this->widgets.push_back(widget);
+	}
+
+	std::deque<bool>	bools;
+	std::deque<int>		ints;
+	std::deque<float>	floats;
+	std::deque<color>	colors;
+};
+
+static void bench_hsv(const timing& settings)
+{
+	// the picker's sweep: every hue at a spread of saturations and values.
+	struct hsv_input { float h, s, v; };
+	std::vector<hsv_input> dataset;
+
+	for (int h = 0; h < 128; h++)
+	{
+		for (int s = 0; s < 16; s++)
+		{
+			for (int v = 0; v < 16; v++)
+				dataset.push_back({ h / 128.f, s / 15.f, v / 15.f });
+		}
+	}
+
+	bool ok = color::hsv(0.f, 1.f, 1.f, 255.f).argb() == color(255, 0, 0).argb() && color::hsv(1.f / 3.f, 1.f, 1.f, 255.f).argb() == color(0, 255, 0).argb();
+	ok = ok && color::hsv(0.7f, 0.f, 1.f, 128.f).argb() == color(255, 255, 255, 128).argb() && color::hsv(0.2f, 1.f, 0.f, 255.f).argb() == color(0, 0, 0).argb();
+	bench::report("color::hsv", ok);
+
+	measure("color::hsv", "128 hues x 16 saturations x 16 values", dataset.size(), settings, [&]() {
+		std::uint32_t folded = 0;
+
+		for (const auto& input : dataset)
+			folded += color::hsv(input.h, input.s, input.v, 255.f).argb();
+
+		sink += folded;
+		});
+}
+
+static void bench_text(const timing& settings)
+{
+	// what widgets measure: their titles and the values they print next to them.
+	std::vector<std::string> dataset = { "checkbox", "slider int", "slider float", "combo", "multi", "keybind", "picker", "performance",
+		"group 1", "group 2", "Player", "Local", "World", "apple, banana, pineapple ...", "p50 7.01 ms  p99 10.35 ms  max 33.20 ms",
+		"181 draws  1024 glyphs  0 allocs per frame", "-", "", "W" };
+
+	for (int i = 0; i <= 100; i += 7)
+		dataset.push_back(std::to_string(i) + "%");
+
+	for (float f = 0.f; f <= 100.f; f += 12.3f)
+		dataset.push_back(translate->format("%.1f", f) + "%");
+
+	environment_font& font = fonts->segoe_ui;
+	SIZE size = { };
+
+	bool ok = font.text_size("").w == 0 && font.text_size("WW").w > font.text_size("W").w && font.text_size("checkbox").h > 0;
+	ok = ok && font.GetTextExtent("slider int", &size) == S_OK && size.cx == font.text_size("slider int").w;
+	bench::report("text_size", ok);
+
+	measure("environment_font::GetTextExtent", "widget titles and values", dataset.size(), settings, [&]() {
+		LONG folded = 0;
+
+		for (const auto& string : dataset)
+		{
+			font.GetTextExtent(string.c_str(), &size);
+			folded += size.cx;
+		}
+
+		sink += std::uint64_t(folded);
+		});
+
+	measure("environment_font::text_size", "widget titles and values", dataset.size(), settings, [&]() {
+		int folded = 0;
+
+		for (const auto& string : dataset)
+			folded += font.text_size(string.c_str()).w;
+
+		sink += std::uint64_t(folded);
+		});
+}
+
+static void bench_draw_position(const timing& settings)
+{
+	for (bool in_sub : { false, true })
+	{
+		widget_tree tree(in_sub);
+		const std::vector<element*>& dataset = tree.widgets;
+
+		// the whole tree follows the window.
+		std::vector<point> before;
+
+		for (auto widget : dataset)
+			before.push_back(widget->draw_position());
+
+		tree.main->set_position({ 130, 90 });
+		bool ok = true;
+
+		for (std::size_t i = 0; i < dataset.size(); i++)
+			ok = ok && dataset[i]->draw_position() == before[i] + point(30, -10);
+
+		bench::report(in_sub ? "draw_position sub" : "draw_position", ok);
+
+		measure("element::draw_position", in_sub ? "28 widgets, depth 5 (sub tab)" : "28 widgets, depth 4", dataset.size(), settings, [&]() {
+			int folded = 0;
+
+			for (auto widget : dataset)
+				folded += widget->draw_position().x;
+
+			sink += std::uint64_t(folded);
+			});
+	}
+}
+
+static void bench_poll_input(const timing& settings)
+{
+	input->set_scripted(true);
+	input->script_key(VK_LBUTTON, true);
+	input->poll_input();
+
+	bool ok = input->key_pressed(VK_LBUTTON);
+	input->poll_input();
+	ok = ok && input->key_down(VK_LBUTTON) && !input->key_pressed(VK_LBUTTON);
+
+	input->script_key(VK_LBUTTON, false);
+	input->poll_input();
+	ok = ok && input->key_released(VK_LBUTTON);
+	bench::report("poll_input", ok);
+
+	measure("gui_input::poll_input", "scripted", 1, settings, [&]() {
+		input->poll_input();
+		sink += input->key_down(VK_LBUTTON);
+		});
+
+	// the keyboard path, a GetAsyncKeyState per key. off windows the call is a stub and this is the loop.
+	input->set_scripted(false);
+
+	measure("gui_input::poll_input", "keyboard", 1, settings, [&]() {
+		input->poll_input();
+		sink += input->key_down(VK_LBUTTON);
+		});
+
+	input->set_scripted(true);
+}
+
+static void bench_in_bound(const timing& settings)
+{
+	widget_tree tree(false);
+
+	// every widget's box against a grid of mouse positions over the window, a frame of hover tests.
+	std::vector<rect> areas;
+
+	for (auto widget : tree.widgets)
+	{
+		const point at = widget->draw_position();
+		areas.push_back({ at.x, at.y, 230, 20 });
+	}
+
+	std::vector<point> mice;
+
+	for (int y = 0; y < 8; y++)
+	{
+		for (int x = 0; x < 8; x++)
+			mice.push_back({ 100 + x * 90, 100 + y * 75 });
+	}
+
+	int expected = 0, counted = 0;
+
+	for (const auto& mouse : mice)
+	{
+		input->mouse = mouse;
+
+		for (const auto& area : areas)
+		{
+			expected += mouse.x >= area.x && mouse.y >= area.y && mouse.x <= area.x + area.w && mouse.y <= area.y + area.h + 1;
+			counted += input->in_bound(area);
+		}
+	}
+
+	bench::report("in_bound", counted == expected && expected > 0);
+
+	const std::size_t size = areas.size() * mice.size();
+
+	measure("gui_input::in_bound", "28 widgets x 64 mouse positions", size, settings, [&]() {
+		int folded = 0;
+
+		for (const auto& mouse : mice)
+		{
+			input->mouse = mouse;
+
+			for (const auto& area : areas)
+				folded += input->in_bound(area);
+		}
+
+		sink += std::uint64_t(folded);
+		});
+
+	// while a window records its draw list every test is also kept as a probe.
+	draw_list list;
+
+	measure("gui_input::in_bound", "recording probes", size, settings, [&]() {
+		int folded = 0;
+
+		list.clear();
+		render->begin_capture(&list);
+
+		for (const auto& mouse : mice)
+		{
+			input->mouse = mouse;
+
+			for (const auto& area : areas)
+				folded += input->in_bound(area);
+		}
+
+		render->end_capture();
+		sink += std::uint64_t(folded);
+		});
+}
+
+static void bench_format(const timing& settings)
+{
+	bool ok = translate->format("%d", 42) == "42" && translate->format("%.1f", 12.345f) == "12.3";
+	ok = ok && translate->format("p50 %.2f ms  p99 %.2f ms  max %.2f ms", 7.011f, 10.35f, 33.2f) == "p50 7.01 ms  p99 10.35 ms  max 33.20 ms";
+	bench::report("translate format", ok);
+
+	// slider values, one per step of the default ranges.
+	measure("text_translate::format", "slider_int values 0..100", 101, settings, [&]() {
+		std::size_t folded = 0;
+
+		for (int i = 0; i <= 100; i++)
+			folded += translate->format("%d", i).size();
+
+		sink += folded;
+		});
+
+	measure("text_translate::format", "slider_float values 0..100", 101, settings, [&]() {
+		std::size_t folded = 0;
+
+		for (int i = 0; i <= 100; i++)
+			folded += translate->format("%.1f", i * 0.99f).size();
+
+		sink += folded;
+		});
+
+	measure("text_translate::format", "perf_hud lines", 2, settings, [&]() {
+		std::size_t folded = translate->format("p50 %.2f ms  p99 %.2f ms  max %.2f ms", 7.01f, 10.35f, 33.2f).size();
+		folded += translate->format("%u draws  %u glyphs  %u allocs per frame", 181u, 1024u, 0u).size();
+
+		sink += folded;
+		});
+}
+
+static void bench_construct_list(const timing& settings)
+{
+	const char* fruits[] = { "apple", "banana", "pineapple", "orange", "grape", "melon" };
+
+	window main("helpers", { 100, 100 }, { 700, 600 });
+	auto handle = new tab("A", &main);
+	auto left	= new column(handle);
+	auto box	= new group("group", { 270, 300 }, left);
+
+	bool selected[2][6] = { };
+	multi* multis[2] = { new multi(box, "four"), new multi(box, "six") };
+
+	for (int i = 0; i < 4; i++)
+		multis[0]->add(fruits[i], &selected[0][i]);
+
+	for (int i = 0; i < 6; i++)
+		multis[1]->add(fruits[i], &selected[1][i]);
+
+	for (auto handle_multi : multis)
+		box->add(handle_multi);
+
+	left->add(box);
+	handle->add(left);
+	main.add(handle);
+
+	bool ok = multis[1]->label() == "-";
+	selected[1][0] = true;
+	ok = ok && multis[1]->label() == "apple";
+	selected[1][1] = true;
+	ok = ok && multis[1]->label() == "apple, banana";
+	std::fill(selected[1], selected[1] + 6, true);
+	ok = ok && multis[1]->label() == "apple, banana, pineapple ...";
+	bench::report("multi label", ok);
+
+	// every selection of both boxes.
+	for (int m = 0; m < 2; m++)
+	{
+		const int items = m ? 6 : 4;
+
+		measure("multi::construct_list", m ? "6 items, every selection" : "4 items, every selection", std::size_t(1) << items, settings, [&]() {
+			std::size_t folded = 0;
+
+			for (int mask = 0; mask < 1 << items; mask++)
+			{
+				for (int i = 0; i < items; i++)
+					selected[m][i] = (mask >> i) & 1;
+
+				folded += multis[m]->label().size();
+			}
+
+			sink += folded;
+			});
+	}
+}
+
+int main(int argc, char** argv)
+{
+	timing settings;
+	bench::headless fixture;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+			settings.runs = std::max<int>(1, std::atoi(argv[++i]));
+		else if (fixture.option(argc, argv, i))
+			continue;
+		else if (std::strcmp(argv[i], "--quick") == 0)
+		{
+			settings.runs	= 3;
+			settings.calls	= 20000;
+		}
+		else
+		{
+			std::fprintf(stderr, "usage: %s [--runs n] [--font path] [--bold path] [--quick]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (!fixture.setup())
+		return bench::skip();
+
+	bench_hsv(settings);
+	bench_text(settings);
+	bench_draw_position(settings);
+	bench_poll_input(settings);
+	bench_in_bound(settings);
+	bench_format(settings);
+	bench_construct_list(settings);
+
+	return bench::exit_code();
+}
@@ -0,0 +1,290 @@
+#include "common.h"
+#include "../renderer/gui/gui.h"
+#include "../renderer/render/telemetry.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+* histogram and frame telemetry checks, runs without a device.
+* checks the bucket layout, that percentiles of a long tailed frame time distribution stay within the
+* histogram's precision of the exact ones, merging and clamping, then runs a few fake frames through the
+* telemetry and checks what each phase recorded, which frame input messages are charged to, that a frame
+* that wasn't presented hands its input on and the exported file. finally times record() and a percentile
+* query. exits non-zero when a check fails.
+* build: g++ -O2 -pthread histogram.cpp ../renderer/gui/{gui,input_log}.cpp
+*        ../renderer/render/{atlas,batch,convert,draw_list,font,render,shape,stats,telemetry,truetype}.cpp
+*        ../renderer/other/{allocations,color,histogram}.cpp
+*/
+
+static void spin(std::uint64_t nanoseconds)
+{
+	const std::uint64_t until = telemetry->now() + nanoseconds;
+
+	while (telemetry->now() < until)
+		;
+}
+
+// mostly steady frames around 7 ms, with the occasional hitch an order of magnitude longer.
+static std::vector<std::uint64_t> frame_times(std::size_t count)
+{
+	std::mt19937_64 random(42);
+	std::lognormal_distribution<double> steady(std::log(7e6), 0.15);
+	std::uniform_real_distribution<double> hitch(30e6, 120e6);
+	std::uniform_int_distribution<int> odds(0, 199);
+
+	std::vector<std::uint64_t> values(count);
+
+	for (auto& value : values)
+		value = std::uint64_t(odds(random) == 0 ? hitch(random) : steady(random));
+
+	return values;
+}
+
+int main()
+{
+	// buckets tile the range without gaps and every value lands in the bucket that holds it.
+	{
+		bool ok = histogram::bucket_index(histogram::max_value) == histogram::bucket_count - 1;
+
+		for (std::size_t i = 0; i < histogram::bucket_count; i++)
+		{
+			ok = ok && histogram::bucket_index(histogram::bucket_lowest(i)) == i && histogram::bucket_index(histogram::bucket_highest(i)) == i;
+
+			if (i + 1 < histogram::bucket_count)
+				ok = ok && histogram::bucket_highest(i) + 1 == histogram::bucket_lowest(i + 1);
+
+			// the precision promise: no bucket is wider than 1/128 of the values it holds.
+			ok = ok && double(histogram::bucket_highest(i) - histogram::bucket_lowest(i)) <= double(histogram::bucket_lowest(i)) / double(histogram::sub_buckets);
+		}
+
+		bench::report("bucket layout", ok);
+	}
+
+	const std::vector<std::uint64_t> values = frame_times(200000);
+	std::vector<std::uint64_t> sorted = values;
+	std::sort(sorted.begin(), sorted.end());
+
+	histogram whole, first, second;
+
+	for (std::size_t i = 0; i < values.size(); i++)
+	{
+		whole.record(values[i]);
+		(i % 2 ? first : second).record(values[i]);
+	}
+
+	// against the exact rank from the sorted values.
+	{
+		bool ok = true;
+
+		for (double fraction : { 0.0, 0.5, 0.9, 0.99, 0.995, 0.999, 0.9999, 1.0 })
+		{
+			const std::size_t rank		= std::max<std::size_t>(1, std::size_t(fraction * double(sorted.size()) + 0.5)) - 1;
+			const double exact			= double(sorted[rank]);
+			const double estimate		= double(whole.percentile(fraction));
+
+			ok = ok && estimate >= exact && estimate - exact <= exact / double(histogram::sub_buckets);
+		}
+
+		bench::report("percentiles", ok);
+	}
+
+	{
+		double sum = 0.0;
+
+		for (std::uint64_t value : values)
+			sum += double(value);
+
+		const double mean = sum / double(values.size());
+		bench::report("min max mean", whole.min() == sorted.front() && whole.max() == sorted.back() && std::abs(whole.mean() - mean) < 1.0);
+	}
+
+	{
+		histogram merged = first;
+		merged.merge(second);
+
+		bool ok = merged.count() == whole.count() && merged.min() == whole.min() && merged.max() == whole.max();
+
+		for (double fraction : { 0.5, 0.99, 0.999 })
+			ok = ok && merged.percentile(fraction) == whole.percentile(fraction);
+
+		bench::report("merge", ok);
+	}
+
+	{
+		histogram clamped;
+		clamped.record(~0ull);
+		clamped.record(0);
+
+		bool ok = clamped.max() == histogram::max_value && clamped.min() == 0 && clamped.percentile(1.0) == histogram::max_value;
+
+		clamped.reset();
+		ok = ok && clamped.count() == 0 && clamped.percentile(0.99) == 0;
+		bench::report("clamp and reset", ok);
+	}
+
+	// fake frames the way entry.cpp runs them: a short pump, then think, draw and present.
+	{
+		const int frames = 20;
+
+		for (int i = 0; i < frames; i++)
+		{
+			spin(50000);
+			telemetry->begin_frame();
+
+			{
+				telemetry_scope scope(frame_phase::think);
+				spin(200000);
+			}
+
+			{
+				telemetry_scope scope(frame_phase::draw);
+				spin(300000);
+			}
+
+			{
+				telemetry_scope scope(frame_phase::present);
+				spin(100000);
+			}
+
+			telemetry->end_frame();
+		}
+
+		bool ok = telemetry->frame_time().count() == frames - 1 && telemetry->latency().count() == frames;
+		ok = ok && telemetry->phase(frame_phase::poll).count() == frames - 1 && telemetry->phase(frame_phase::think).count() == frames;
+		ok = ok && telemetry->phase(frame_phase::think).min() >= 200000 && telemetry->phase(frame_phase::draw).min() >= 300000;
+		ok = ok && telemetry->phase(frame_phase::poll).min() >= 50000 && telemetry->frame_time().min() >= 650000;
+		ok = ok && telemetry->latency().min() >= 600000;
+
+		// a frame is its pump plus the latency after it, so the latency leaves the pump out. the smallest of each
+		// compares without depending on how the spins were scheduled, the first frame has no frame time.
+		ok = ok && telemetry->latency().min() + telemetry->phase(frame_phase::poll).min() <= telemetry->frame_time().min();
+
+		bench::report("telemetry phases", ok);
+	}
+
+	// messages count from when they reach the window until the present of the first frame that polled them.
+	{
+		gui::input->set_scripted(true);
+		gui::input->process_mouse(nullptr, WM_MOUSEMOVE, 0, (20 << 16) | 10);
+		gui::input->process_mouse(nullptr, WM_KEYDOWN, VK_INSERT, 0);
+		gui::input->process_mouse(nullptr, WM_KEYDOWN, VK_INSERT, 1 << 30);
+		spin(100000);
+
+		telemetry->begin_frame();
+		gui::input->poll_input();
+		spin(200000);
+
+		// after the poll, so it waits for the next frame.
+		const std::uint64_t clicked = telemetry->now();
+		gui::input->process_mouse(nullptr, WM_LBUTTONDOWN, 0, 0);
+		spin(100000);
+		telemetry->end_frame();
+
+		telemetry->begin_frame();
+		gui::input->poll_input();
+		spin(100000);
+		telemetry->end_frame();
+
+		const std::uint64_t presented = telemetry->now();
+
+		const histogram& moves		= telemetry->event_latency(input_event::mouse_move);
+		const histogram& keys		= telemetry->event_latency(input_event::key);
+		const histogram& buttons	= telemetry->event_latency(input_event::mouse_button);
+
+		bool ok = moves.count() == 1 && keys.count() == 1 && buttons.count() == 1 && telemetry->event_latency(input_event::mouse_wheel).count() == 0;
+		ok = ok && moves.min() >= 400000 && keys.min() >= 400000 && buttons.min() >= 200000 && buttons.max() <= presented - clicked;
+		ok = ok && gui::input->mouse == point(10, 20);
+
+		bench::report("input latency", ok);
+	}
+
+	{
+		bool ok = telemetry->export_histograms("telemetry_check.hgrm");
+		std::FILE* file = std::fopen("telemetry_check.hgrm", "rb");
+		std::string text;
+
+		if (file)
+		{
+			char buffer[4096];
+			std::size_t read = 0;
+
+			while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+				text.append(buffer, read);
+
+			std::fclose(file);
+			std::remove("telemetry_check.hgrm");
+		}
+
+		std::size_t sections = 0;
+
+		for (std::size_t at = text.find("#[Max"); at != std::string::npos; at = text.find("#[Max", at + 1))
+			sections++;
+
+		ok = ok && sections == 2 + std::size_t(frame_phase::count) + std::size_t(input_event::count) && text.find("# key to present (ms)") != std::string::npos;
+		bench::report("export", ok);
+
+		telemetry->reset();
+		bench::report("telemetry reset", telemetry->frame_time().count() == 0 && telemetry->phase(frame_phase::poll).count() == 0 && telemetry->event_latency(input_event::key).count() == 0);
+	}
+
+	// skip_identical leaves the screen alone when nothing changed, what such a frame read waits for a present.
+	{
+		const std::uint64_t sent = telemetry->now();
+		gui::input->process_mouse(nullptr, WM_MOUSEMOVE, 0, (40 << 16) | 30);
+
+		telemetry->begin_frame();
+		gui::input->poll_input();
+		spin(200000);
+		telemetry->end_frame(false);
+
+		spin(50000);
+		telemetry->begin_frame();
+		gui::input->poll_input();
+		spin(100000);
+		telemetry->end_frame(false);
+
+		telemetry->begin_frame();
+		gui::input->poll_input();
+		spin(100000);
+		telemetry->end_frame();
+
+		const histogram& moves = telemetry->event_latency(input_event::mouse_move);
+
+		bool ok = telemetry->frame_time().count() == 2 && telemetry->latency().count() == 1 && moves.count() == 1;
+		// both run from before the first of the three frames began to the one present.
+		ok = ok && telemetry->latency().min() >= 450000 && telemetry->latency().max() <= moves.min() && moves.max() <= telemetry->now() - sent;
+
+		bench::report("skipped frames", ok);
+		telemetry->reset();
+	}
+
+	// record is what every frame pays per value, a percentile query is what a hud refresh would pay.
+	histogram timed;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int pass = 0; pass < 10; pass++)
+	{
+		for (std::uint64_t value : values)
+			timed.record(value);
+	}
+
+	const auto recorded = std::chrono::steady_clock::now();
+	std::uint64_t checksum = 0;
+
+	for (int i = 0; i < 1000; i++)
+		checksum += timed.percentile(0.99);
+
+	const auto queried = std::chrono::steady_clock::now();
+
+	std::printf("\n%zu records, %.2f ns per record\n", values.size() * 10, std::chrono::duration<double, std::nano>(recorded - start).count() / double(values.size() * 10));
+	std::printf("1000 p99 queries, %.2f us per query (checksum %llu)\n", std::chrono::duration<double, std::micro>(queried - recorded).count() / 1000.0, static_cast<unsigned long long>(checksum));
+	std::printf("p50 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms, mean %.3f ms\n", whole.percentile(0.5) / 1e6, whole.percentile(0.99) / 1e6,
+		whole.percentile(0.999) / 1e6, whole.max() / 1e6, whole.mean() / 1e6);
+
+	return bench::exit_code();
+}
@@ -0,0 +1,259 @@
+#include "common.h"
+#include "../renderer/menu/menu.h"
+#include "../renderer/other/allocations.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+/*
+* memory accounting checks, runs on the null device against a core built with MEMORY_TRACKING.
+* checks that allocations are charged to the innermost open scope of the thread making them and given back
+* to the same tag wherever they are freed, that the frame peaks start over with every frame, then sets up
+* the fonts and the demo menu, runs a few frames and checks what each subsystem holds and what the frame
+* figures in the statistics add up to. prints the per tag table and times a new / delete pair.
+* exits non-zero when a check fails.
+* usage: memory [--font path] [--bold path]
+* build: g++ -O2 -DMEMORY_TRACKING -pthread memory.cpp ../renderer/menu/menu.cpp ../renderer/gui/{gui,input_log}.cpp
+*        ../renderer/render/{atlas,batch,convert,draw_list,font,render,shape,stats,telemetry,truetype}.cpp
+*        ../renderer/other/{allocations,color,histogram}.cpp
+*/
+
+using namespace gui;
+
+static std::int64_t live(memory_tag tag)
+{
+	return memory_usage_of(tag).live;
+}
+
+// the compiler may drop a new / delete pair it can see through, publishing the block keeps it.
+static char* volatile escaped = nullptr;
+
+static char* allocate(std::size_t size)
+{
+	char* block = new char[size];
+	escaped = block;
+	return block;
+}
+
+// one frame the way entry.cpp runs it, minus the device.
+static void frame()
+{
+	input->poll_input();
+	instance->think();
+	instance->draw();
+	atlas->flush();
+	statistics->end_frame();
+}
+
+int main(int argc, char** argv)
+{
+	bench::headless fixture;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!fixture.option(argc, argv, i))
+		{
+			std::fprintf(stderr, "usage: %s [--font path] [--bold path]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	// charged to the open scope, given back on free, nothing else moves.
+	{
+		const std::int64_t strings = live(memory_tag::strings), untagged = live(memory_tag::untagged), total = memory_total().live;
+		const std::uint64_t count = memory_usage_of(memory_tag::strings).allocations;
+		char* block = nullptr;
+
+		{
+			memory_scope memory(memory_tag::strings);
+			block = allocate(1000);
+		}
+
+		bool ok = live(memory_tag::strings) == strings + 1000 && live(memory_tag::untagged) == untagged && memory_total().live == total + 1000;
+		ok = ok && memory_usage_of(memory_tag::strings).allocations == count + 1;
+
+		// freed outside of any scope, still comes off the tag it was charged to.
+		delete[] block;
+		ok = ok && live(memory_tag::strings) == strings && memory_total().live == total;
+
+		bench::report("tag attribution", ok);
+	}
+
+	{
+		const std::int64_t font = live(memory_tag::font), tree = live(memory_tag::widget_tree), untagged = live(memory_tag::untagged);
+		char* inner = nullptr;
+		char* outer = nullptr;
+
+		{
+			memory_scope memory(memory_tag::font);
+
+			{
+				memory_scope nested(memory_tag::widget_tree);
+				inner = allocate(300);
+			}
+
+			outer = allocate(200);
+		}
+
+		char* after = allocate(100);
+
+		bool ok = live(memory_tag::font) == font + 200 && live(memory_tag::widget_tree) == tree + 300 && live(memory_tag::untagged) == untagged + 100;
+
+		delete[] inner;
+		delete[] outer;
+		delete[] after;
+
+		ok = ok && live(memory_tag::font) == font && live(memory_tag::widget_tree) == tree && live(memory_tag::untagged) == untagged;
+		bench::report("nested scopes", ok);
+	}
+
+	// a size the header would wrap around fails instead of handing out a block far smaller than asked for.
+	{
+		// volatile, so the compiler doesn't refuse the size before the allocator sees it.
+		volatile std::size_t size = SIZE_MAX - 4;
+		const std::int64_t total = memory_total().live;
+		void* volatile huge = ::operator new(size, std::nothrow);
+
+		bench::report("size overflow", !huge && memory_total().live == total);
+	}
+
+	// a scope only covers its own thread.
+	{
+		const std::size_t size = 1 << 20;
+		const std::int64_t strings = live(memory_tag::strings), untagged = live(memory_tag::untagged);
+		char* block = nullptr;
+
+		{
+			memory_scope memory(memory_tag::strings);
+			std::thread worker([&block, size]() { block = allocate(size); });
+			worker.join();
+		}
+
+		bool ok = live(memory_tag::untagged) >= untagged + std::int64_t(size) && live(memory_tag::strings) < strings + std::int64_t(size);
+
+		delete[] block;
+		ok = ok && live(memory_tag::untagged) == untagged;
+		bench::report("per thread", ok);
+	}
+
+	// the frame peak catches what came and went within the frame, the next frame starts from live.
+	{
+		statistics->end_frame();
+
+		{
+			memory_scope memory(memory_tag::render_vertices);
+			std::vector<char> scratch(64 * 1024);
+		}
+
+		statistics->end_frame();
+
+		const memory_frame& vertices = statistics->memory(memory_tag::render_vertices);
+		bool ok = vertices.peak >= vertices.live + 64 * 1024 && vertices.allocations == 1;
+
+		statistics->end_frame();
+		ok = ok && statistics->memory(memory_tag::render_vertices).peak == statistics->memory(memory_tag::render_vertices).live;
+		ok = ok && statistics->memory(memory_tag::render_vertices).allocations == 0;
+
+		bench::report("frame peaks", ok);
+	}
+
+	{
+		const std::uint64_t count = memory_usage_of(memory_tag::strings).allocations;
+		const std::int64_t strings = live(memory_tag::strings);
+
+		bool ok = false;
+
+		{
+			// too long for the small string buffer.
+			const std::string label = translate->format("%s %d", "a label longer than any small string buffer", 42);
+			ok = live(memory_tag::strings) > strings && memory_usage_of(memory_tag::strings).allocations == count + 1;
+		}
+
+		ok = ok && live(memory_tag::strings) == strings;
+		bench::report("format strings", ok);
+	}
+
+	{
+		const std::int64_t font = live(memory_tag::font);
+
+		if (!fixture.setup())
+			return bench::skip();
+
+		bench::report("font memory", live(memory_tag::font) > font + 256 * 256);
+	}
+
+	{
+		const std::int64_t tree = live(memory_tag::widget_tree);
+
+		input->set_scripted(true);
+		menu->setup();
+
+		bench::report("widget tree", live(memory_tag::widget_tree) > tree + std::int64_t(2 * sizeof(window)));
+	}
+
+	// the tagged figures of a frame add up to the totals.
+	{
+		for (int i = 0; i < 60; i++)
+		{
+			input->mouse = { 320 + i * 4, 240 + i };
+			input->script_key(VK_LBUTTON, i % 10 == 5);
+			frame();
+		}
+
+		std::int64_t live_sum = 0;
+		std::uint64_t allocation_sum = 0;
+
+		for (std::size_t i = 0; i < memory_tags; i++)
+		{
+			live_sum		+= statistics->memory(memory_tag(i)).live;
+			allocation_sum	+= statistics->memory(memory_tag(i)).allocations;
+		}
+
+		bool ok = live_sum == statistics->memory().live && allocation_sum == statistics->memory().allocations;
+		ok = ok && statistics->memory().allocations == statistics->history(0).allocations;
+
+		bench::report("frame totals", ok);
+	}
+
+	std::printf("\n%-16s %12s %12s %12s %14s\n", "tag", "live", "peak", "allocations", "last frame");
+
+	for (std::size_t i = 0; i <= memory_tags; i++)
+	{
+		const memory_usage usage	= i < memory_tags ? memory_usage_of(memory_tag(i)) : memory_total();
+		const memory_frame& last	= i < memory_tags ? statistics->memory(memory_tag(i)) : statistics->memory();
+
+		std::printf("%-16s %12lld %12lld %12llu %14u\n", i < memory_tags ? memory_tag_name(memory_tag(i)) : "total", static_cast<long long>(usage.live),
+			static_cast<long long>(usage.peak), static_cast<unsigned long long>(usage.allocations), last.allocations);
+	}
+
+	// what every new / delete pays for the header and the counters.
+	{
+		const int pairs = 1000000;
+		std::vector<int*> kept(16);
+		const auto start = std::chrono::steady_clock::now();
+
+		{
+			memory_scope memory(memory_tag::strings);
+
+			for (int i = 0; i < pairs; i++)
+			{
+				int*& slot = kept[i % kept.size()];
+				delete slot;
+				slot = new int(i);
+			}
+		}
+
+		const auto finished = std::chrono::steady_clock::now();
+
+		for (int* slot : kept)
+			delete slot;
+
+		std::printf("\n%d new / delete pairs, %.2f ns per pair\n", pairs, std::chrono::duration<double, std::nano>(finished - start).count() / double(pairs));
+	}
+
+	return bench::exit_code();
+}
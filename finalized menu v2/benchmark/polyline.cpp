@@ -0,0 +1,180 @@
+#include "common.h"
+#include "../renderer/render/batch.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/*
+* polyline tessellation checks and benchmark, runs without a device.
+* checks the fringe/core offsets of a straight line, the miter of a right angle, closed loops, index ranges
+* and that a line split into max_polyline_points pieces produces the same vertices as one long pass.
+* then times tessellating streaming graphs of a few thousand points.
+* exits non-zero when a check fails.
+* build: g++ -O2 polyline.cpp ../renderer/render/batch.cpp
+*/
+
+static bool near(float a, float b)
+{
+	return std::fabs(a - b) < 1e-4f;
+}
+
+static bool at(const vertex& v, float x, float y)
+{
+	return near(v.position.x, x) && near(v.position.y, y);
+}
+
+static bool indices_in_range(const std::vector<std::uint16_t>& indices, std::size_t vertices)
+{
+	for (auto index : indices)
+	{
+		if (index >= vertices)
+			return false;
+	}
+
+	return true;
+}
+
+// a scrolling graph like the ones the perf overlays draw.
+static std::vector<vector_2d> graph(std::size_t count, float phase)
+{
+	std::vector<vector_2d> points(count);
+
+	for (std::size_t i = 0; i < count; i++)
+		points[i] = vector_2d(float(i) * 0.25f, 300.f + std::sin(float(i) * 0.05f + phase) * 120.f + std::sin(float(i) * 0.71f) * 8.f);
+
+	return points;
+}
+
+int main()
+{
+	std::vector<vertex> vertices;
+	std::vector<std::uint16_t> indices;
+
+	// straight line, 3px: core at 1px, fringe at 2px either side of the pixel centre.
+	{
+		const vector_2d points[2] = { { 0.f, 10.f }, { 100.f, 10.f } };
+		line_batch::polyline(points, 2, 0, 1, 3.f, color(255, 0, 0), false, vertices, indices);
+
+		bool ok = vertices.size() == 8 && indices.size() == 18 && indices_in_range(indices, vertices.size());
+		ok = ok && at(vertices[0], -0.5f, 11.5f) && at(vertices[1], -0.5f, 10.5f) && at(vertices[2], -0.5f, 8.5f) && at(vertices[3], -0.5f, 7.5f);
+		ok = ok && at(vertices[4], 99.5f, 11.5f) && at(vertices[7], 99.5f, 7.5f);
+		ok = ok && vertices[0].colour == 0x00ff0000 && vertices[1].colour == 0xffff0000 && vertices[2].colour == 0xffff0000 && vertices[3].colour == 0x00ff0000;
+		bench::report("straight line", ok);
+	}
+
+	// right angle: the corner vertices sit on the diagonal, sqrt(2) times further out.
+	{
+		vertices.clear();
+		indices.clear();
+
+		const vector_2d points[3] = { { 0.f, 0.f }, { 10.f, 0.f }, { 10.f, 10.f } };
+		line_batch::polyline(points, 3, 0, 2, 4.f, color(255, 255, 255), false, vertices, indices);
+
+		const vertex* corner = &vertices[4];
+		bool ok = vertices.size() == 12 && indices.size() == 36 && indices_in_range(indices, vertices.size());
+		ok = ok && at(corner[1], 9.5f - 1.5f, -0.5f + 1.5f) && at(corner[2], 9.5f + 1.5f, -0.5f - 1.5f);
+		ok = ok && at(corner[0], 9.5f - 2.5f, -0.5f + 2.5f);
+		bench::report("miter join", ok);
+	}
+
+	// hairpin turns stay within the miter limit instead of shooting off.
+	{
+		vertices.clear();
+		indices.clear();
+
+		const vector_2d points[3] = { { 0.f, 0.f }, { 100.f, 0.f }, { 0.f, 1.f } };
+		line_batch::polyline(points, 3, 0, 2, 2.f, color(255, 255, 255), false, vertices, indices);
+
+		const float dx = vertices[4].position.x - 99.5f, dy = vertices[4].position.y + 0.5f;
+		bench::report("miter limit", std::sqrt(dx * dx + dy * dy) <= 1.5f * 4.f + 1e-3f);
+	}
+
+	// closed square: 4 segments, the last point is the first one again.
+	{
+		vertices.clear();
+		indices.clear();
+
+		const vector_2d points[4] = { { 0.f, 0.f }, { 10.f, 0.f }, { 10.f, 10.f }, { 0.f, 10.f } };
+		line_batch::polyline(points, 4, 0, line_batch::segment_count(4, true), 2.f, color(0, 255, 0), true, vertices, indices);
+
+		bool ok = vertices.size() == 20 && indices.size() == 72 && indices_in_range(indices, vertices.size());
+		ok = ok && std::memcmp(&vertices[0], &vertices[16], sizeof(vertex) * 4) == 0;
+		bench::report("closed loop", ok);
+	}
+
+	// a graph longer than one draw splits into pieces that match the single pass vertex for vertex.
+	{
+		const std::vector<vector_2d> points = graph(40000, 0.f);
+		const std::size_t segments = line_batch::segment_count(points.size(), false);
+
+		std::vector<vertex> whole;
+		std::vector<std::uint16_t> unused;
+		line_batch::polyline(points.data(), points.size(), 0, segments, 2.f, color(255, 255, 255), false, whole, unused);
+
+		bool ok = whole.size() == points.size() * 4;
+		std::size_t pieces = 0;
+
+		for (std::size_t first = 0; ok && first < segments; first += max_polyline_points - 1)
+		{
+			const std::size_t last = std::min<std::size_t>(segments, first + max_polyline_points - 1);
+
+			vertices.clear();
+			indices.clear();
+			line_batch::polyline(points.data(), points.size(), first, last, 2.f, color(255, 255, 255), false, vertices, indices);
+
+			ok = vertices.size() <= max_polyline_points * 4 && indices_in_range(indices, vertices.size());
+			ok = ok && std::memcmp(vertices.data(), &whole[first * 4], vertices.size() * sizeof(vertex)) == 0;
+			pieces++;
+		}
+
+		bench::report("split pieces", ok && pieces == 3);
+	}
+
+	// timings: one long graph and many short ones, scratch reused like the renderer does.
+	const int runs = 50;
+
+	struct workload
+	{
+		const char*	name;
+		std::size_t	lines;
+		std::size_t	points;
+	};
+
+	const workload workloads[] = { { "1 x 10000 points", 1, 10000 }, { "64 x 2000 points", 64, 2000 } };
+
+	std::printf("\n%-18s %12s %14s %10s\n", "graph", "best ms", "ns per point", "draws");
+
+	for (const auto& work : workloads)
+	{
+		std::vector<std::vector<vector_2d>> lines;
+
+		for (std::size_t i = 0; i < work.lines; i++)
+			lines.push_back(graph(work.points, float(i)));
+
+		double best = 1e30;
+
+		for (int run = 0; run < runs; run++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+
+			for (const auto& line : lines)
+			{
+				vertices.clear();
+				indices.clear();
+				line_batch::polyline(line.data(), line.size(), 0, line.size() - 1, 1.5f, color(99, 160, 200), false, vertices, indices);
+			}
+
+			const double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			if (time < best)
+				best = time;
+		}
+
+		const std::size_t total = work.lines * work.points;
+		std::printf("%-18s %12.3f %14.2f %10zu\n", work.name, best, best * 1e6 / double(total), work.lines);
+	}
+
+	return bench::exit_code();
+}
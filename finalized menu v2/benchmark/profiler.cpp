@@ -0,0 +1,326 @@
+#include "common.h"
+#include "../renderer/other/profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+* profiler checks and overhead, runs on the null device against a core built with PROFILER.
+* draws a real frame of two windows holding a group of color pickers plus scopes from worker threads, then
+* checks that every element was recorded under its own window, the per thread buffers, nesting, self time,
+* the per category / window totals and that the chrome trace export is written. snapshots taken while
+* another thread laps its ring have to come back whole. finally times an empty scope, which is what every
+* profiled element pays. exits non-zero when a check fails.
+* usage: profiler [--font path] [--bold path]
+* build: g++ -O2 -DPROFILER -pthread profiler.cpp ../renderer/gui/{gui,input_log}.cpp
+*        ../renderer/render/{atlas,batch,convert,draw_list,font,render,shape,stats,telemetry,truetype}.cpp
+*        ../renderer/other/{allocations,color,histogram,profiler}.cpp
+*/
+
+using namespace gui;
+
+static const profile_total* find(const std::vector<profile_total>& totals, const char* key)
+{
+	for (const auto& total : totals)
+	{
+		if (std::strcmp(total.key, key) == 0)
+			return &total;
+	}
+
+	return nullptr;
+}
+
+// a window with one group of three color pickers, the gui keeps pointers to the bound colors.
+static window* picker_window(const char* title, point position, std::deque<color>& colors)
+{
+	auto handle		= new window(title, position, { 400, 300 });
+	auto page		= new tab("T", handle, false);
+	auto parent		= new column(page);
+	auto box		= new group("group", { 270, 200 }, parent);
+
+	for (int i = 0; i < 3; i++)
+	{
+		colors.emplace_back();
+		box->add(new color_picker(box, "pick color", color(255, 0, 0), &colors.back()));
+	}
+
+	parent->add(box);
+	page->add(parent);
+	handle->add(page);
+	handle->set_default_tab(page);
+	return handle;
+}
+
+static bool is(const char* text, const char* expected)
+{
+	return text && std::strcmp(text, expected) == 0;
+}
+
+int main(int argc, char** argv)
+{
+	bench::headless fixture;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!fixture.option(argc, argv, i))
+		{
+			std::fprintf(stderr, "usage: %s [--font path] [--bold path]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (!fixture.setup())
+		return bench::skip();
+
+	gui_instance instance;
+	std::deque<color> colors;
+
+	instance.add(picker_window("main", { 40, 40 }, colors));
+	instance.add(picker_window("other", { 500, 40 }, colors));
+
+	// nothing hovered, so think stops at the windows and draw records every element.
+	input->set_scripted(true);
+	input->mouse = { 1900, 1070 };
+	input->poll_input();
+	input->poll_input();
+
+	profiler->clear();
+	instance.think();
+	instance.draw();
+	atlas->flush();
+
+	std::vector<std::thread> workers;
+
+	for (int i = 0; i < 3; i++)
+	{
+		workers.emplace_back([]() {
+			PROFILE_SCOPE("rasterize", "worker");
+			});
+	}
+
+	for (auto& worker : workers)
+		worker.join();
+
+	const std::vector<profile_event> events = profiler->snapshot();
+
+	// the frame on this thread, one scope on each worker.
+	{
+		std::vector<std::uint32_t> threads;
+
+		for (const auto& event : events)
+		{
+			if (std::find(threads.begin(), threads.end(), event.thread) == threads.end())
+				threads.push_back(event.thread);
+		}
+
+		bench::report("events", threads.size() == 4);
+	}
+
+	// PROFILE_ELEMENT names the widget by its title and finds the window through window_title.
+	{
+		std::size_t pickers = 0;
+		bool ok = true;
+
+		for (const auto& event : events)
+		{
+			if (is(event.category, "color_picker"))
+			{
+				pickers++;
+				ok = ok && is(event.name, "pick color") && (is(event.window, "main") || is(event.window, "other"));
+			}
+			else if (is(event.category, "window") || is(event.category, "group"))
+				ok = ok && (is(event.window, "main") || is(event.window, "other"));
+		}
+
+		bench::report("element scopes", ok && pickers == 6);
+	}
+
+	// children finish first, inside their parent and one level deeper than it.
+	{
+		const profile_event* draw = nullptr;
+
+		for (const auto& event : events)
+		{
+			if (is(event.name, "draw") && is(event.category, "gui"))
+				draw = &event;
+		}
+
+		bool ok = draw && draw->depth == 0;
+
+		for (std::size_t i = 0; ok && i < events.size(); i++)
+		{
+			const profile_event& picker = events[i];
+
+			if (!is(picker.category, "color_picker"))
+				continue;
+
+			const profile_event* parent = nullptr;
+
+			for (std::size_t j = i + 1; j < events.size() && !parent; j++)
+			{
+				if (events[j].thread == picker.thread && events[j].depth + 1 == picker.depth)
+					parent = &events[j];
+			}
+
+			ok = parent && is(parent->category, "group") && parent->window == picker.window;
+			ok = ok && picker.start >= parent->start && picker.start + picker.duration <= parent->start + parent->duration;
+			ok = ok && picker.start >= draw->start && picker.start + picker.duration <= draw->start + draw->duration;
+		}
+
+		bench::report("nesting", ok);
+	}
+
+	// self times split the outermost scopes between everything nested in them.
+	{
+		const std::vector<profile_total> totals = profiler->totals(profile_group::category);
+		const profile_total* pickers	= find(totals, "color_picker");
+		const profile_total* groups		= find(totals, "group");
+		const profile_total* workers	= find(totals, "worker");
+
+		bool ok = pickers && groups && workers && is(totals.front().key, "gui");
+		ok = ok && pickers->count == 6 && pickers->self < pickers->total && groups->self < groups->total && workers->count == 3;
+
+		std::uint64_t self = 0, outermost = 0;
+
+		for (const auto& total : totals)
+			self += total.self;
+
+		for (const auto& event : events)
+			outermost += event.depth == 0 ? event.duration : 0;
+
+		bench::report("category totals", ok && self == outermost);
+	}
+
+	// a window's self time is what it spent in its own elements, text drawn for them goes to the font.
+	{
+		const std::vector<profile_total> totals = profiler->totals(profile_group::window);
+		const profile_total* main = find(totals, "main");
+		const profile_total* other = find(totals, "other");
+
+		std::size_t count = 0;
+		std::uint64_t windows = 0;
+
+		for (const auto& event : events)
+		{
+			if (is(event.window, "main"))
+			{
+				count++;
+				windows += event.depth == 1 ? event.duration : 0;
+			}
+		}
+
+		bench::report("window totals", main && other && main->count == count && main->self > 0 && main->self <= windows);
+	}
+
+	// chrome trace export.
+	{
+		bool ok = profiler->export_trace("profile_check.json");
+		std::FILE* file = std::fopen("profile_check.json", "rb");
+		std::string text;
+
+		if (file)
+		{
+			char buffer[4096];
+			std::size_t read = 0;
+
+			while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+				text.append(buffer, read);
+
+			std::fclose(file);
+			std::remove("profile_check.json");
+		}
+
+		std::size_t complete = 0;
+
+		for (std::size_t at = text.find("\"ph\":\"X\""); at != std::string::npos; at = text.find("\"ph\":\"X\"", at + 1))
+			complete++;
+
+		ok = ok && complete == events.size() && text.find("\"window\":\"main\"") != std::string::npos && text.back() == '\n';
+		bench::report("trace export", ok);
+	}
+
+	// a thread records as fast as it can while snapshots are taken. its scopes always pair a name with the
+	// same category and start in order, a slot read while it was being rewritten would break either.
+	{
+		static const char* names[]		= { "a", "b", "c", "d" };
+		static const char* categories[]	= { "lap a", "lap b", "lap c", "lap d" };
+
+		std::atomic<std::size_t> recorded{ 0 };
+		std::atomic<bool> done{ false };
+
+		std::thread recorder([&recorded, &done]() {
+			for (std::size_t i = 0; !done.load(std::memory_order_relaxed); i++)
+			{
+				{
+					PROFILE_SCOPE(names[i % 4], categories[i % 4]);
+				}
+
+				recorded.store(i + 1, std::memory_order_relaxed);
+			}
+			});
+
+		bool ok = true;
+		std::size_t seen = 0;
+
+		// snapshots start once the ring has been lapped, so every one of them races the owner.
+		while (recorded.load(std::memory_order_relaxed) < environment_profiler::capacity)
+			std::this_thread::yield();
+
+		for (int round = 0; round < 100; round++)
+		{
+			std::uint64_t last = 0;
+
+			for (const auto& event : profiler->snapshot())
+			{
+				for (int i = 0; i < 4; i++)
+				{
+					if (event.category != categories[i])
+						continue;
+
+					ok = ok && event.name == names[i] && event.depth == 0 && event.start >= last;
+					last = event.start;
+					seen++;
+				}
+			}
+		}
+
+		done.store(true, std::memory_order_relaxed);
+		recorder.join();
+
+		bench::report("concurrent snapshot", ok && seen > 0);
+	}
+
+	// clear drops the events but keeps recording.
+	{
+		profiler->clear();
+		bool ok = profiler->snapshot().empty();
+
+		{
+			PROFILE_SCOPE("after clear", "check");
+		}
+
+		ok = ok && profiler->snapshot().size() == 1;
+		bench::report("clear", ok);
+	}
+
+	// overhead of an empty scope, wrapped past the ring's capacity so the buffer keeps its size.
+	const int scopes = 1000000;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < scopes; i++)
+	{
+		PROFILE_SCOPE("empty", "check");
+	}
+
+	const double total = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	bench::report("ring wraps", profiler->snapshot().size() == environment_profiler::capacity - 1);
+
+	std::printf("\n%d empty scopes, %.1f ns per scope\n", scopes, total / scopes);
+	return bench::exit_code();
+}
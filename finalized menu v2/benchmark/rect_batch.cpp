@@ -0,0 +1,154 @@
+#include "common.h"
+#include "../renderer/render/batch.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+/*
+* bulk rect vertex generation benchmark, runs without a device.
+* the per-call path rebuilds what filled_rect / outlined_rect do today: a fresh 4 vertex vector per quad.
+* the batch path appends every rect into one reused vector, which is what filled_rects / outlined_rects
+* hand to a single DrawIndexedPrimitiveUP. both have to produce the same vertices, the index list has to
+* describe two triangles per quad within 16 bits.
+* exits non-zero when the batch disagrees with the per-call path.
+* build: g++ -O2 rect_batch.cpp ../renderer/render/batch.cpp
+*/
+
+static const std::size_t rect_count = 100000;
+static const int runs = 20;
+
+// what filled_rect builds for each call, appended so the result can be compared.
+static void per_call_filled(int x, int y, int w, int h, color colour, std::vector<vertex>& all)
+{
+	std::vector<vertex> vertices = { };
+
+	vertices.emplace_back(vertex({ x - 0.5f, y - 0.5f }, { 0.f, 1.f }, colour.argb()));
+	vertices.emplace_back(vertex({ x + w - 0.5f, y - 0.5f }, { 0.f, 1.f }, colour.argb()));
+	vertices.emplace_back(vertex({ x - 0.5f, y + h - 0.5f }, { 0.f, 1.f }, colour.argb()));
+	vertices.emplace_back(vertex({ x + w - 0.5f, y + h - 0.5f }, { 0.f, 1.f }, colour.argb()));
+
+	all.insert(all.end(), vertices.begin(), vertices.end());
+}
+
+static void per_call_outlined(const rect_instance& instance, std::vector<vertex>& all)
+{
+	const rect& r = instance.area;
+
+	per_call_filled(r.x, r.y, r.w, 1, instance.colour, all);
+	per_call_filled(r.x, r.y, 1, r.h, instance.colour, all);
+	per_call_filled(r.x + r.w - 1, r.y, 1, r.h, instance.colour, all);
+	per_call_filled(r.x, r.y + r.h - 1, r.w, 1, instance.colour, all);
+}
+
+static bool same_vertices(const std::vector<vertex>& a, const std::vector<vertex>& b)
+{
+	return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(vertex)) == 0;
+}
+
+// best of runs, in milliseconds.
+template <class body_t>
+static double best_time(body_t body)
+{
+	double best = 1e30;
+
+	for (int run = 0; run < runs; run++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		body();
+		const double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		if (time < best)
+			best = time;
+	}
+
+	return best;
+}
+
+int main()
+{
+	std::mt19937 random(1337);
+	std::vector<rect_instance> rects(rect_count);
+
+	for (auto& instance : rects)
+	{
+		instance.area	= rect(int(random() % 1920), int(random() % 1080), int(random() % 200) + 1, int(random() % 200) + 1);
+		instance.colour	= color(int(random() % 256), int(random() % 256), int(random() % 256), int(random() % 256));
+	}
+
+	// checks.
+	const std::vector<std::uint16_t>& indices = rect_batch::quad_indices();
+	bool indices_ok = indices.size() == max_batch_quads * 6;
+
+	for (std::size_t i = 0; indices_ok && i < max_batch_quads; i++)
+	{
+		const std::uint16_t* quad = &indices[i * 6];
+		const std::size_t base = i * 4;
+		indices_ok = quad[0] == base && quad[1] == base + 1 && quad[2] == base + 2 && quad[3] == base + 2 && quad[4] == base + 1 && quad[5] == base + 3;
+	}
+
+	bench::report("quad indices", indices_ok);
+
+	std::vector<vertex> expected, result;
+
+	for (const auto& instance : rects)
+		per_call_filled(instance.area.x, instance.area.y, instance.area.w, instance.area.h, instance.colour, expected);
+
+	rect_batch::filled(rects.data(), rects.size(), result);
+	bench::report("filled vertices", same_vertices(expected, result));
+
+	expected.clear();
+	result.clear();
+
+	for (const auto& instance : rects)
+		per_call_outlined(instance, expected);
+
+	rect_batch::outlined(rects.data(), rects.size(), result);
+	bench::report("outlined vertices", same_vertices(expected, result));
+
+	// appending keeps what is already there.
+	std::vector<vertex> fresh;
+	rect_batch::filled(rects.data(), 2, fresh);
+
+	result.assign(3, vertex());
+	rect_batch::filled(rects.data(), 2, result);
+	bench::report("filled appends", result.size() == 11 && std::memcmp(&result[3], fresh.data(), fresh.size() * sizeof(vertex)) == 0);
+
+	// timings, the batch vector keeps its capacity between runs like the renderer's scratch.
+	std::vector<vertex> scratch;
+	std::vector<vertex> sink;
+	sink.reserve(rect_count * 16);
+
+	const double filled_call = best_time([&]() {
+		sink.clear();
+		for (const auto& instance : rects)
+			per_call_filled(instance.area.x, instance.area.y, instance.area.w, instance.area.h, instance.colour, sink);
+		});
+
+	const double filled_batch = best_time([&]() {
+		scratch.clear();
+		rect_batch::filled(rects.data(), rects.size(), scratch);
+		});
+
+	const double outlined_call = best_time([&]() {
+		sink.clear();
+		for (const auto& instance : rects)
+			per_call_outlined(instance, sink);
+		});
+
+	const double outlined_batch = best_time([&]() {
+		scratch.clear();
+		rect_batch::outlined(rects.data(), rects.size(), scratch);
+		});
+
+	const std::size_t filled_draws		= (rect_count + max_batch_quads - 1) / max_batch_quads;
+	const std::size_t outlined_draws	= (rect_count * 4 + max_batch_quads - 1) / max_batch_quads;
+
+	std::printf("\n%zu rects, best of %d runs (cpu vertex generation only)\n", rect_count, runs);
+	std::printf("%-10s %12s %12s %12s %14s\n", "shape", "per call ms", "batch ms", "speedup", "draw calls");
+	std::printf("%-10s %12.3f %12.3f %11.1fx %6zu -> %zu\n", "filled", filled_call, filled_batch, filled_call / filled_batch, rect_count, filled_draws);
+	std::printf("%-10s %12.3f %12.3f %11.1fx %6zu -> %zu\n", "outlined", outlined_call, outlined_batch, outlined_call / outlined_batch, rect_count * 4, outlined_draws);
+
+	return bench::exit_code();
+}
@@ -0,0 +1,301 @@
+#include "common.h"
+#include "../renderer/gui/input_log.h"
+#include "../renderer/menu/menu.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/*
+* input replay.
+* runs an input log recorded by the demo (built with INPUT_LOG) against the demo menu on the null device,
+* as fast as the gui can think and draw it, and prints the frame timings and the final state hash as one
+* json object per run. two builds replaying the same log should end on the same hash, whatever their
+* timings. --timings writes the per frame times as csv.
+* without a log it checks itself: a scripted session is recorded live, the log has to survive encoding
+* and a file, and replaying it on a fresh menu has to end exactly where the session did, every time.
+* exits non-zero when a check fails.
+* usage: replay [log] [--repeat n] [--timings path] [--save path] [--font path] [--bold path]
+* build: g++ -O2 -pthread replay.cpp ../renderer/menu/menu.cpp ../renderer/gui/{gui,input_log}.cpp
+*        ../renderer/render/{atlas,batch,convert,draw_list,font,render,shape,stats,telemetry,truetype}.cpp
+*        ../renderer/other/{allocations,color,histogram}.cpp
+*/
+
+using namespace gui;
+
+// the demo menu as entry.cpp builds it, with nothing left over from a previous run.
+static void fresh_menu()
+{
+	delete instance;
+	delete events;
+	delete input;
+
+	instance	= new gui_instance;
+	events		= new gui_event;
+	input		= new gui_input;
+
+	input->set_scripted(true);
+	menu->setup();
+}
+
+// deterministic stand-in for a user: every 12 frames it picks a spot, mostly over the other window's
+// widgets, presses there and drags a little. scrolls, types a key for the keybind, escapes popups and
+// toggles the menu off and on once.
+static void script_input(int frame, std::uint32_t& seed)
+{
+	const int step = frame % 12;
+
+	if (step == 0)
+	{
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+
+		if (seed % 4)
+			input->mouse = { 310 + int((seed >> 8) % 280), 215 + int((seed >> 20) % 190) };
+		else
+			input->mouse = { 100 + int((seed >> 8) % 800), 100 + int((seed >> 20) % 700) };
+	}
+	else if (step > 3 && step < 8)
+		input->mouse.x += 6;
+
+	input->script_key(VK_LBUTTON, step >= 2 && step < 8);
+	input->script_key('A', frame % 150 == 75);
+	input->script_key(VK_ESCAPE, frame % 200 == 199);
+	input->script_key(VK_INSERT, frame == 400 || frame == 420);
+	input->set_mouse_wheel(frame % 40 == 20 ? ((frame / 40) % 2 ? 1 : -1) : 0);
+}
+
+struct replay_result
+{
+	std::vector<double>	think;
+	std::vector<double>	draw;
+	double				total	= 0.0;	// microseconds for the whole replay.
+	std::uint64_t		hash	= 0;
+};
+
+static double microseconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+	return std::chrono::duration<double, std::micro>(to - from).count();
+}
+
+// one frame the way entry.cpp runs it, minus the device and the wait for vsync.
+static replay_result replay(input_log& log)
+{
+	fresh_menu();
+	log.rewind();
+
+	replay_result result;
+	result.think.reserve(log.frames());
+	result.draw.reserve(log.frames());
+
+	const auto begin = std::chrono::steady_clock::now();
+
+	while (log.replay(input))
+	{
+		const auto start = std::chrono::steady_clock::now();
+		instance->think();
+		const auto thought = std::chrono::steady_clock::now();
+		instance->draw();
+		atlas->flush();
+		const auto drawn = std::chrono::steady_clock::now();
+
+		result.think.push_back(microseconds(start, thought));
+		result.draw.push_back(microseconds(thought, drawn));
+	}
+
+	result.total	= microseconds(begin, std::chrono::steady_clock::now());
+	result.hash		= instance->state_hash();
+	return result;
+}
+
+static double percentile(std::vector<double> values, double fraction)
+{
+	if (values.empty())
+		return 0.0;
+
+	const std::size_t rank = std::min<std::size_t>(values.size() - 1, std::size_t(fraction * double(values.size() - 1) + 0.5));
+	std::nth_element(values.begin(), values.begin() + rank, values.end());
+	return values[rank];
+}
+
+static double mean(const std::vector<double>& values)
+{
+	double sum = 0.0;
+
+	for (double value : values)
+		sum += value;
+
+	return values.empty() ? 0.0 : sum / double(values.size());
+}
+
+static void print_result(const char* name, const input_log& log, const replay_result& result)
+{
+	const double recorded = log.frames() ? double(log.frame(log.frames() - 1).time) : 0.0;
+
+	std::printf("{\"benchmark\":\"replay\",\"log\":\"%s\",\"frames\":%zu,\"recorded_ms\":%.2f,\"replay_ms\":%.2f,\"speedup\":%.1f,",
+		name, log.frames(), recorded / 1000.0, result.total / 1000.0, result.total > 0.0 ? recorded / result.total : 0.0);
+
+	std::printf("\"think_mean_us\":%.2f,\"think_p50_us\":%.2f,\"think_p99_us\":%.2f,\"draw_mean_us\":%.2f,\"draw_p50_us\":%.2f,\"draw_p99_us\":%.2f,\"state_hash\":\"%016llx\"}\n",
+		mean(result.think), percentile(result.think, 0.5), percentile(result.think, 0.99),
+		mean(result.draw), percentile(result.draw, 0.5), percentile(result.draw, 0.99), static_cast<unsigned long long>(result.hash));
+
+	std::fflush(stdout);
+}
+
+static bool write_timings(const char* path, const input_log& log, const replay_result& result)
+{
+	std::FILE* file = std::fopen(path, "w");
+
+	if (!file)
+		return false;
+
+	std::fputs("frame,recorded_us,think_us,draw_us\n", file);
+
+	for (std::size_t i = 0; i < result.think.size(); i++)
+		std::fprintf(file, "%zu,%llu,%.2f,%.2f\n", i, static_cast<unsigned long long>(log.frame(i).time), result.think[i], result.draw[i]);
+
+	return std::fclose(file) == 0;
+}
+
+static bool same_frames(const input_log& a, const input_log& b)
+{
+	if (a.frames() != b.frames())
+		return false;
+
+	for (std::size_t i = 0; i < a.frames(); i++)
+	{
+		const input_frame& x = a.frame(i);
+		const input_frame& y = b.frame(i);
+
+		if (x.time != y.time || x.mouse != y.mouse || x.wheel != y.wheel || x.key_count != y.key_count)
+			return false;
+
+		if (std::memcmp(a.toggled(x), b.toggled(y), x.key_count))
+			return false;
+	}
+
+	return true;
+}
+
+// records a scripted session live, then checks the log and that replaying it ends where the session did.
+static int self_check(const char* save, const char* timings)
+{
+	const int frames = 900;
+
+	fresh_menu();
+	const std::uint64_t initial = instance->state_hash();
+
+	input_log session;
+	input->set_recorder(&session);
+
+	std::uint32_t seed = 0x2545f491;
+
+	for (int i = 0; i < frames; i++)
+	{
+		script_input(i, seed);
+		instance->think();
+		instance->draw();
+		atlas->flush();
+	}
+
+	input->set_recorder(nullptr);
+	const std::uint64_t live = instance->state_hash();
+
+	bench::report("session changes state", live != initial && session.frames() == frames);
+
+	const std::vector<std::uint8_t> encoded = session.encode();
+	input_log decoded;
+	bench::report("log round trips", decoded.decode(encoded) && same_frames(session, decoded) && decoded.encode() == encoded);
+
+	// a cut off log is refused instead of replayed half way.
+	{
+		input_log truncated;
+		std::vector<std::uint8_t> cut(encoded.begin(), encoded.end() - 1);
+		bench::report("truncated log refused", !truncated.decode(cut) && truncated.frames() == 0);
+	}
+
+	const char* path = save ? save : "replay_check.log";
+	input_log loaded;
+	bench::report("file round trips", session.save(path) && loaded.load(path) && same_frames(session, loaded));
+
+	if (!save)
+		std::remove(path);
+
+	const replay_result first	= replay(loaded);
+	const replay_result second	= replay(loaded);
+
+	bench::report("replay matches session", first.hash == live);
+	bench::report("replay repeats", second.hash == first.hash);
+
+	std::printf("{\"benchmark\":\"replay_log\",\"frames\":%zu,\"bytes\":%zu,\"bytes_per_frame\":%.2f}\n", session.frames(), encoded.size(), double(encoded.size()) / double(session.frames()));
+	print_result(path, loaded, second);
+
+	if (timings && !write_timings(timings, loaded, second))
+		bench::report("timings written", false);
+
+	return bench::exit_code();
+}
+
+int main(int argc, char** argv)
+{
+	const char* path	= nullptr;
+	const char* timings	= nullptr;
+	const char* save	= nullptr;
+	int repeat			= 1;
+	bench::headless fixture;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+			repeat = std::max<int>(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--timings") == 0 && i + 1 < argc)
+			timings = argv[++i];
+		else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+			save = argv[++i];
+		else if (fixture.option(argc, argv, i))
+			continue;
+		else if (argv[i][0] != '-' && !path)
+			path = argv[i];
+		else
+		{
+			std::fprintf(stderr, "usage: %s [log] [--repeat n] [--timings path] [--save path] [--font path] [--bold path]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	// same fonts on every machine, so text widths and with them the layout don't change the hash.
+	if (!fixture.setup())
+		return bench::skip();
+
+	if (!path)
+		return self_check(save, timings);
+
+	input_log log;
+
+	if (!log.load(path))
+	{
+		std::fprintf(stderr, "%s: not an input log\n", path);
+		return 2;
+	}
+
+	std::uint64_t hash = 0;
+
+	for (int i = 0; i < repeat; i++)
+	{
+		const replay_result result = replay(log);
+		print_result(path, log, result);
+
+		if (i == 0 && timings && !write_timings(timings, log, result))
+			bench::report("timings written", false);
+
+		if (i > 0)
+			bench::report("replay repeats", result.hash == hash);
+
+		hash = result.hash;
+	}
+
+	return bench::exit_code();
+}
@@ -0,0 +1,244 @@
+#include "common.h"
+#include "../renderer/render/shape.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/*
+* shape tessellation checks and benchmark, runs without a device.
+* checks the ring cache (hits return the same ring, segment counts are multiples of 4, points lie on the
+* circle), vertex templates (a cached circle matches tessellating it in place), rounded rect outlines, arc end
+* points and index ranges. then times a frame of knobs (filled circle plus a value arc) built from the cache
+* against recomputing sin/cos and joins for every shape.
+* exits non-zero when a check fails.
+* build: g++ -O2 shapes.cpp ../renderer/render/shape.cpp ../renderer/render/batch.cpp
+*/
+
+static const float pi = 3.14159265358979f;
+
+static bool near(float a, float b, float tolerance = 1e-3f)
+{
+	return std::fabs(a - b) < tolerance;
+}
+
+static bool indices_in_range(const std::vector<std::uint16_t>& indices, std::size_t vertices)
+{
+	for (auto index : indices)
+	{
+		if (index >= vertices)
+			return false;
+	}
+
+	return !indices.empty() && indices.size() % 3 == 0;
+}
+
+// what every shape costs without the cache: a fresh round of trig per point.
+static void uncached_knob(vector_2d centre, float radius, float value, std::vector<vector_2d>& path, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices)
+{
+	int segments = environment_shapes::segments_for(radius);
+	path.resize(std::size_t(segments));
+
+	for (int i = 0; i < segments; i++)
+	{
+		const float angle = 2.f * pi * float(i) / float(segments);
+		path[i] = centre + vector_2d(std::cos(angle), std::sin(angle)) * radius;
+	}
+
+	fill_batch::convex(path.data(), path.size(), color(25, 25, 25), vertices, indices);
+
+	const float outer	= radius + 4.f;
+	const float start	= pi * 0.75f;
+	const float end		= start + value * pi * 1.5f;
+
+	segments = environment_shapes::segments_for(outer);
+	const int steps = std::max<int>(1, int(std::ceil((end - start) / (2.f * pi) * segments)));
+	path.resize(std::size_t(steps) + 1);
+
+	for (int i = 0; i <= steps; i++)
+	{
+		const float angle = start + (end - start) * float(i) / float(steps);
+		path[i] = centre + vector_2d(std::cos(angle), std::sin(angle)) * outer;
+	}
+
+	line_batch::polyline(path.data(), path.size(), 0, path.size() - 1, 3.f, color(99, 160, 200), false, vertices, indices);
+}
+
+static void cached_knob(environment_shapes& cache, vector_2d centre, float radius, float value, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices)
+{
+	const float start = pi * 0.75f;
+
+	cache.filled_circle(centre, radius, 0, color(25, 25, 25), vertices, indices);
+	cache.arc(centre, radius + 4.f, start, start + value * pi * 1.5f, 0, 3.f, color(99, 160, 200), vertices, indices);
+}
+
+int main()
+{
+	environment_shapes cache;
+	std::vector<vertex> vertices;
+	std::vector<std::uint16_t> indices;
+
+	// segment counts.
+	{
+		bool ok = true;
+
+		for (float radius = 0.f; radius < 400.f; radius += 0.75f)
+		{
+			const int segments = environment_shapes::segments_for(radius);
+			ok = ok && segments % 4 == 0 && segments >= 12 && segments <= 512;
+
+			// the chord midpoint stays within the tolerance of the circle.
+			if (radius > 1.f)
+				ok = ok && radius * (1.f - std::cos(pi / float(segments))) <= 0.25f + 1e-4f;
+		}
+
+		bench::report("segment counts", ok);
+	}
+
+	// ring cache.
+	{
+		const std::vector<vector_2d>& ring = cache.ring(10.f, 16);
+		bool ok = &ring == &cache.ring(10.f, 16) && &ring == &cache.ring(10.01f, 16) && &ring != &cache.ring(10.f, 32);
+		ok = ok && cache.cached() == 4;
+
+		for (std::size_t i = 0; ok && i < ring.size(); i++)
+			ok = near(std::sqrt(ring[i].x * ring[i].x + ring[i].y * ring[i].y), 10.f);
+
+		ok = ok && near(ring[0].x, 10.f) && near(ring[4].y, 10.f);
+		bench::report("ring cache", ok);
+
+		cache.clear();
+		bench::report("ring clear", cache.cached() == 0);
+	}
+
+	// filled circle: solid vertices half a pixel inside the radius, fringe half a pixel outside.
+	{
+		cache.filled_circle({ 50.f, 50.f }, 20.f, 0, color(255, 255, 255), vertices, indices);
+
+		bool ok = indices_in_range(indices, vertices.size()) && vertices.size() == std::size_t(environment_shapes::segments_for(20.f)) * 2;
+
+		for (std::size_t i = 0; ok && i < vertices.size(); i++)
+		{
+			const float dx = vertices[i].position.x + 0.5f - 50.f, dy = vertices[i].position.y + 0.5f - 50.f;
+			const float distance = std::sqrt(dx * dx + dy * dy);
+
+			// corners of the polygon sit slightly further out than the edge midpoints.
+			ok = (i & 1) ? distance > 20.f && distance < 20.6f : distance > 19.4f && distance < 20.f;
+			ok = ok && ((i & 1) ? vertices[i].colour >> 24 == 0 : vertices[i].colour >> 24 == 255);
+		}
+
+		bench::report("filled circle", ok);
+
+		// a second circle elsewhere reuses the template: same vertices as tessellating it there directly.
+		const std::size_t templates = cache.cached();
+		const std::size_t first = vertices.size();
+		cache.filled_circle({ 130.f, 75.f }, 20.f, 0, color(10, 20, 30, 40), vertices, indices);
+
+		std::vector<vector_2d> moved(cache.ring(20.f, environment_shapes::segments_for(20.f)));
+		std::vector<vertex> direct;
+		std::vector<std::uint16_t> direct_indices;
+
+		for (auto& point : moved)
+			point += vector_2d(130.f, 75.f);
+
+		fill_batch::convex(moved.data(), moved.size(), color(10, 20, 30, 40), direct, direct_indices);
+
+		ok = cache.cached() == templates && vertices.size() - first == direct.size() && indices_in_range(indices, vertices.size());
+
+		for (std::size_t i = 0; ok && i < direct.size(); i++)
+		{
+			const vertex& a = vertices[first + i];
+			ok = near(a.position.x, direct[i].position.x) && near(a.position.y, direct[i].position.y) && a.colour == direct[i].colour;
+		}
+
+		for (std::size_t i = 0; ok && i < direct_indices.size(); i++)
+			ok = indices[indices.size() - direct_indices.size() + i] == direct_indices[i] + first;
+
+		bench::report("template reuse", ok);
+	}
+
+	// arc: the first and last core vertices straddle the exact end angles.
+	{
+		vertices.clear();
+		indices.clear();
+
+		const float start = 0.3f, end = 2.2f;
+		cache.arc({ 0.f, 0.f }, 30.f, end, start, 0, 2.f, color(255, 255, 255), vertices, indices);
+
+		auto mid = [&](std::size_t point) {
+			const vertex& a = vertices[point * 4 + 1];
+			const vertex& b = vertices[point * 4 + 2];
+			return vector_2d((a.position.x + b.position.x) * 0.5f + 0.5f, (a.position.y + b.position.y) * 0.5f + 0.5f);
+		};
+
+		const vector_2d first = mid(0), last = mid(vertices.size() / 4 - 1);
+		bool ok = indices_in_range(indices, vertices.size());
+		ok = ok && near(first.x, std::cos(start) * 30.f) && near(first.y, std::sin(start) * 30.f);
+		ok = ok && near(last.x, std::cos(end) * 30.f) && near(last.y, std::sin(end) * 30.f);
+		bench::report("arc end points", ok);
+	}
+
+	// rounded rect: 4 quarters of the ring, every point inside the rect, straight edges on the rect.
+	{
+		vertices.clear();
+		indices.clear();
+
+		cache.filled_rounded_rect(rect(10, 20, 100, 40), 8.f, color(255, 255, 255), vertices, indices);
+
+		const std::size_t points = vertices.size() / 2;
+		bool ok = indices_in_range(indices, vertices.size()) && points == std::size_t(environment_shapes::segments_for(8.f) / 4 + 1) * 4;
+
+		for (std::size_t i = 0; ok && i < points; i++)
+		{
+			const vertex& solid = vertices[i * 2];
+			ok = solid.position.x >= 9.9f && solid.position.x <= 110.f && solid.position.y >= 19.9f && solid.position.y <= 60.f;
+		}
+
+		// the radius is clamped to half the smaller side, which turns a short rect into a pill.
+		vertices.clear();
+		indices.clear();
+		cache.outlined_rounded_rect(rect(0, 0, 60, 10), 100.f, 1.f, color(255, 255, 255), vertices, indices);
+		ok = ok && indices_in_range(indices, vertices.size());
+
+		bench::report("rounded rect", ok);
+	}
+
+	// timings: a frame of knobs with changing values, scratch reused like the renderer does.
+	const int knobs = 1000, runs = 30;
+	std::vector<vector_2d> path;
+
+	double best_uncached = 1e30, best_cached = 1e30;
+
+	for (int run = 0; run < runs; run++)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < knobs; i++)
+		{
+			vertices.clear();
+			indices.clear();
+			uncached_knob({ float(i % 40) * 48.f, float(i / 40) * 48.f }, 12.f + float(i % 3) * 4.f, float((i + run) % 100) / 100.f, path, vertices, indices);
+		}
+
+		best_uncached = std::min<double>(best_uncached, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+		start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < knobs; i++)
+		{
+			vertices.clear();
+			indices.clear();
+			cached_knob(cache, { float(i % 40) * 48.f, float(i / 40) * 48.f }, 12.f + float(i % 3) * 4.f, float((i + run) % 100) / 100.f, vertices, indices);
+		}
+
+		best_cached = std::min<double>(best_cached, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	std::printf("\n%d knobs per frame, best of %d runs\n", knobs, runs);
+	std::printf("%-10s %10s %14s\n", "path", "ms", "us per knob");
+	std::printf("%-10s %10.3f %14.3f\n", "trig", best_uncached, best_uncached * 1000.0 / knobs);
+	std::printf("%-10s %10.3f %14.3f\n", "cached", best_cached, best_cached * 1000.0 / knobs);
+	std::printf("%zu cached templates\n", cache.cached());
+
+	return bench::exit_code();
+}
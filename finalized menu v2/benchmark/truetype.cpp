@@ -0,0 +1,225 @@
+#include "common.h"
+#include "../renderer/render/atlas.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+/*
+* truetype reader checks.
+* loads dejavu sans and checks its metrics, character map and advances against the values in the file,
+* rasterizes the full block (a plain rectangle) and checks the coverage adds up to its area, then feeds the
+* reader truncated and corrupted copies of the face, every one of which has to be refused or read without
+* leaving the file. run it under a sanitizer to catch a read that only lands in the wrong place.
+* finally times rasterizing the printable ascii range. exits non-zero when a check fails.
+* usage: truetype [--font path]
+* build: g++ -O2 truetype.cpp ../renderer/render/{atlas,truetype}.cpp
+*/
+
+static const char* default_font = "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+
+static std::vector<std::uint8_t> read_file(const char* path)
+{
+	std::vector<std::uint8_t> data;
+	std::FILE* file = std::fopen(path, "rb");
+
+	if (!file)
+		return data;
+
+	std::uint8_t chunk[4096];
+	std::size_t read = 0;
+
+	while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+		data.insert(data.end(), chunk, chunk + read);
+
+	std::fclose(file);
+	return data;
+}
+
+// everything a caller can ask of a loaded face, over a spread of glyphs including ones the face doesn't have.
+static std::uint32_t exercise(const truetype_font& face)
+{
+	std::uint32_t sum = 0;
+	atlas_bitmap bitmap;
+	bitmap.w = 24;
+	bitmap.h = 24;
+
+	for (std::uint32_t codepoint : { 0x20u, 0x41u, 0x56u, 0x67u, 0xe9u, 0x2588u, 0x1d400u, 0x10ffffu })
+		sum += std::uint32_t(face.glyph_index(codepoint));
+
+	for (int glyph : { -1, 0, 3, 36, 57, 3680, 6252, 6253, 70000 })
+	{
+		sum += std::uint32_t(face.advance(glyph) + face.left_bearing(glyph) + face.kerning(glyph, 57));
+
+		face.rasterize(glyph, face.scale_for_em(16.f), 2.f, 18.f, bitmap);
+
+		for (std::uint8_t pixel : bitmap.pixels)
+			sum += pixel;
+	}
+
+	return sum;
+}
+
+int main(int argc, char** argv)
+{
+	const char* path = default_font;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--font") == 0 && i + 1 < argc)
+			path = argv[++i];
+		else
+		{
+			std::fprintf(stderr, "usage: %s [--font path]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	const std::vector<std::uint8_t> data = read_file(path);
+	truetype_font face;
+
+	if (!face.load(data.data(), data.size()))
+	{
+		std::fprintf(stderr, "font not found (%s), skipping\n", path);
+		return bench::skip();
+	}
+
+	// the checks below read dejavu's own tables, another face only gets the robustness checks.
+	if (path == default_font)
+	{
+		bool ok = face.scale_for_em(2048.f) == 1.f && face.ascent() == 1901 && face.descent() == 483;
+		bench::report("metrics", ok);
+
+		ok = face.glyph_index(' ') == 3 && face.glyph_index('A') == 36 && face.glyph_index('V') == 57 && face.glyph_index(0x2588) == 3680;
+		ok = ok && face.glyph_index(0x1d400) == 0 && face.glyph_index(0x10ffff) == 0;
+		bench::report("character map", ok);
+
+		ok = face.advance(36) == 1401 && face.left_bearing(36) == 16 && face.advance(3) == 651 && face.advance(3680) == 1575 && face.left_bearing(3680) == -20;
+		ok = ok && face.advance(-1) == 0 && face.left_bearing(-1) == 0;
+		bench::report("advances", ok);
+
+		bench::report("kerning", face.kerning(36, 57) < 0 && face.kerning(3, 3) == 0);
+
+		// the full block is a single rectangle from (-20, -512) to (1595, 1921) in font units.
+		atlas_bitmap bitmap;
+		bitmap.w = 110;
+		bitmap.h = 165;
+
+		const float scale = face.scale_for_em(128.f);
+		face.rasterize(3680, scale, 4.f, 4.f + 1921.f * scale, bitmap);
+
+		double area = 0.0;
+
+		for (std::uint8_t pixel : bitmap.pixels)
+			area += pixel / 255.0;
+
+		const double expected = 1615.0 * 2433.0 * scale * scale;
+
+		ok = std::abs(area - expected) < expected * 0.002;
+		ok = ok && bitmap.pixels[std::size_t(80) * bitmap.w + 50] == 255 && bitmap.pixels[0] == 0 && bitmap.pixels.back() == 0;
+
+		// the edges fall a quarter into a pixel, exact area coverage shows that instead of rounding it away.
+		ok = ok && bitmap.pixels[std::size_t(80) * bitmap.w + 2] > 0 && bitmap.pixels[std::size_t(80) * bitmap.w + 2] < 255;
+		bench::report("coverage", ok);
+
+		atlas_bitmap space;
+		space.w = space.h = 16;
+		face.rasterize(3, scale, 0.f, 12.f, space);
+		bench::report("empty glyph", std::all_of(space.pixels.begin(), space.pixels.end(), [](std::uint8_t pixel) { return pixel == 0; }));
+	}
+
+	// cut short anywhere, from inside the table directory to the last byte.
+	{
+		bool ok = true;
+		truetype_font cut;
+
+		for (std::size_t size : { std::size_t(0), std::size_t(11), std::size_t(12), std::size_t(100), std::size_t(400), data.size() / 4, data.size() / 2, data.size() - 1 })
+		{
+			const bool loaded = cut.load(data.data(), size);
+			ok = ok && (size >= 12 || !loaded);
+			exercise(cut);
+		}
+
+		for (std::size_t size = 12; size < data.size(); size += data.size() / 97)
+		{
+			cut.load(data.data(), size);
+			exercise(cut);
+		}
+
+		bench::report("truncated", ok);
+	}
+
+	// tables shorter than the fields read out of them, the directory's lengths are what has to be trusted.
+	{
+		bool ok = true;
+		const std::uint16_t tables = std::uint16_t((data[4] << 8) | data[5]);
+
+		for (std::uint16_t table = 0; table < tables; table++)
+		{
+			for (std::uint32_t length : { 0u, 2u, 4u, 8u, 16u, 40u })
+			{
+				std::vector<std::uint8_t> broken = data;
+				std::uint8_t* field = broken.data() + 12 + table * 16 + 12;
+
+				field[0] = field[1] = field[2] = 0;
+				field[3] = std::uint8_t(length);
+
+				truetype_font shrunk;
+				shrunk.load(broken.data(), broken.size());
+				exercise(shrunk);
+
+				// a face without a usable character map or outlines is refused outright.
+				if (!std::memcmp(broken.data() + 12 + table * 16, "cmap", 4) || !std::memcmp(broken.data() + 12 + table * 16, "head", 4))
+					ok = ok && !shrunk.valid();
+			}
+		}
+
+		bench::report("short tables", ok);
+	}
+
+	// random bytes overwritten anywhere, mostly inside the outlines and the maps.
+	{
+		std::mt19937 random(7);
+		std::uniform_int_distribution<std::size_t> offset(0, data.size() - 1);
+		std::uniform_int_distribution<int> byte(0, 255);
+		truetype_font corrupted;
+
+		for (int round = 0; round < 200; round++)
+		{
+			std::vector<std::uint8_t> broken = data;
+
+			for (int i = 0; i < 64; i++)
+				broken[offset(random)] = std::uint8_t(byte(random));
+
+			corrupted.load(broken.data(), broken.size());
+			exercise(corrupted);
+		}
+
+		bench::report("corrupted", true);
+	}
+
+	atlas_bitmap bitmap;
+	bitmap.w = bitmap.h = 20;
+
+	const float scale = face.scale_for_em(13.f);
+	const int rounds = 200;
+	std::uint32_t checksum = 0;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int round = 0; round < rounds; round++)
+	{
+		for (std::uint32_t codepoint = 0x20; codepoint < 0x7f; codepoint++)
+		{
+			face.rasterize(face.glyph_index(codepoint), scale, 2.f, 15.f, bitmap);
+			checksum += bitmap.pixels[std::size_t(10) * bitmap.w + 6];
+		}
+	}
+
+	const double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	std::printf("rasterize 13 px ascii: %.2f us per glyph (checksum %u)\n", elapsed / (rounds * 95.0), checksum);
+
+	return bench::exit_code();
+}
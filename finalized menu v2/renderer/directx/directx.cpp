@@ -1,4 +1,6 @@
 #include "directx.h"
+#include "../gui/theme.h"
+#include "../other/profiler.h"
 
 environment_directx* directx = new environment_directx;
 
@@ -31,6 +33,9 @@ void environment_directx::restore()
 
 void environment_directx::reset()
 {
+	// whatever was on screen is gone after a reset.
+	this->presented = false;
+
 	render->lost_device();
 	this->device->Reset(&this->present_parameter);
 	render->reset_device();
@@ -43,10 +48,18 @@ void environment_directx::handle_screen(LPARAM lparam)
 	this->reset();
 }
 
+void environment_directx::set_present_mode(present_mode mode)
+{
+	this->mode		= mode;
+	this->presented	= false;
+	this->skipped	= 0;
+}
+
 bool environment_directx::render_start()
 {
-	// environment window background.
-	this->device->Clear(0, nullptr, D3DCLEAR_TARGET, color(40, 40, 40).argb(), 1.f, 0);
+	// environment window background, in skip_identical mode only once we know the frame changed.
+	if (this->mode == present_mode::always)
+		this->device->Clear(0, nullptr, D3DCLEAR_TARGET, theme::device_clear.argb(), 1.f, 0);
 
 	if (FAILED(this->device->BeginScene()))
 		return false;
@@ -54,15 +67,61 @@ bool environment_directx::render_start()
 	// set render state.
 	render->set_state();
 
+	// the scene is open so offscreen surfaces can still be redrawn while the frame is recorded.
+	if (this->mode == present_mode::skip_identical)
+	{
+		this->frame.clear();
+		render->begin_capture(&this->frame);
+	}
+
 	return true;
 }
 
-void environment_directx::render_end()
+bool environment_directx::render_end()
 {
+	if (this->mode == present_mode::skip_identical)
+	{
+		render->end_capture();
+
+		std::uint64_t hash = 0;
+		{
+			PROFILE_SCOPE("frame hash", "directx");
+			hash = this->frame.hash();
+		}
+
+		// same commands as what's on screen, leave it there.
+		if (this->presented && hash == this->presented_hash)
+		{
+			this->skipped++;
+			this->device->EndScene();
+			statistics->end_frame();
+			return false;
+		}
+
+		this->device->Clear(0, nullptr, D3DCLEAR_TARGET, theme::device_clear.argb(), 1.f, 0);
+		render->replay(this->frame);
+
+		this->presented_hash	= hash;
+		this->presented			= true;
+	}
+
+	// draw whatever text is still queued.
+	atlas->flush();
+
 	this->device->EndScene();
 
-	HRESULT handle_result = this->device->Present(nullptr, nullptr, nullptr, nullptr);
+	HRESULT handle_result = D3D_OK;
+	{
+		PROFILE_SCOPE("present", "directx");
+		handle_result = this->device->Present(nullptr, nullptr, nullptr, nullptr);
+	}
+
+	statistics->end_frame();
 
 	if (handle_result == D3DERR_DEVICELOST && this->device->TestCooperativeLevel() == D3DERR_DEVICENOTRESET)
 		this->reset();
+	else if (FAILED(handle_result))
+		this->presented = false;
+
+	return SUCCEEDED(handle_result);
 }
\ No newline at end of file
@@ -1,7 +1,14 @@
 #pragma once
 #include "../include.h"
+#include "../render/draw_list.h"
 #include <string>
 
+enum class present_mode : int
+{
+	always,			// clear, draw and present every frame.
+	skip_identical	// record the frame first, nothing is cleared, drawn or presented when it matches the last presented one.
+};
+
 class environment_directx
 {
 public:
@@ -10,17 +17,30 @@ public:
 	void reset();
 	void handle_screen(LPARAM lparam);
 	bool render_start();
-	void render_end();
+	// true when the frame reached the screen, false when it was skipped as identical or present failed.
+	bool render_end();
 
 	IDirect3DDevice9* handle()
 	{
 		return this->device;
 	}
 
+	void set_present_mode(present_mode mode);
+	present_mode get_present_mode() const { return this->mode; }
+
+	// frames skipped because they matched the last presented one, since the mode was set.
+	std::uint64_t skipped_frames() const { return this->skipped; }
+
 private:
 	IDirect3D9* d3d = nullptr;
 	IDirect3DDevice9* device = nullptr;
 	D3DPRESENT_PARAMETERS present_parameter = { 0 };
+
+	present_mode	mode			= present_mode::always;
+	draw_list		frame;						// this frame's commands in skip_identical mode.
+	std::uint64_t	presented_hash	= 0;
+	bool			presented		= false;	// presented_hash belongs to what is on screen.
+	std::uint64_t	skipped			= 0;
 };
 
 extern environment_directx* directx;
\ No newline at end of file
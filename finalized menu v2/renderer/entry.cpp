@@ -1,4 +1,9 @@
 #include "include.h"
+#include "other/allocations.h"
+#include "other/profiler.h"
+#include "gui/input_log.h"
+#include "render/telemetry.h"
+#include <cstdio>
 
 int WINAPI main(HINSTANCE handle, HINSTANCE prev_handle, LPSTR cmd_line, int cmd_show)
 {
@@ -19,32 +24,109 @@ int WINAPI main(HINSTANCE handle, HINSTANCE prev_handle, LPSTR cmd_line, int cmd
 	// install renderer.
 	render->setup(directx->handle());
 
+	// report how much of the shared font atlas is actually used.
+	atlas_occupancy usage = atlas->occupancy();
+	std::printf("font atlas: %d page(s), %zu / %zu pixels used (%.1f%%), texture per font would allocate %zu pixels\n",
+		usage.pages, usage.used, usage.total, usage.ratio() * 100.f, usage.legacy);
+
+	// report where renderer setup spent its time.
+	const render_startup& startup = render->startup;
+	std::printf("renderer setup: %.2f ms on %u thread(s) - rasterize %.2f ms (%.2f ms of work), pack %.2f ms, convert %.2f ms, upload %.2f ms\n",
+		startup.total, startup.threads, startup.rasterize, startup.rasterize_cpu, startup.pack, startup.convert, startup.upload);
+
 	// install gui input handle.
 	gui::input->setup(window->handle());
 
 	// install gui framework.
 	menu->setup();
 
+#ifdef INPUT_LOG
+	// everything the gui reads, for bench_replay to run the session again headless.
+	gui::input_log session;
+	gui::input->set_recorder(&session);
+#endif
+
 	// handle environment window screen.
 	window->display();
 
 	// handle rendering.
 	while (window->run())
 	{
+		telemetry->begin_frame();
+
 		// start drawing.
 		if (directx->render_start())
 		{
 			// add render functions here.
-			gui::instance->think();
-			gui::instance->draw();
+			{
+				telemetry_scope scope(frame_phase::think);
+				gui::instance->think();
+			}
+
+			{
+				telemetry_scope scope(frame_phase::draw);
+				gui::instance->draw();
 
-			menu->draw_test();
+				menu->draw_test();
+			}
 
 			// end drawing.
-			directx->render_end();
+			bool presented = false;
+			{
+				telemetry_scope scope(frame_phase::present);
+				presented = directx->render_end();
+			}
+
+			telemetry->end_frame(presented);
 		}
 	}
 
+	// the tail is where the hitches are, the averages hide them.
+	const histogram& frame_time = telemetry->frame_time();
+	std::printf("frame time: %llu frames, mean %.2f ms, p50 %.2f ms, p99 %.2f ms, p99.9 %.2f ms, max %.2f ms\n",
+		static_cast<unsigned long long>(frame_time.count()), frame_time.mean() / 1e6, frame_time.percentile(0.5) / 1e6,
+		frame_time.percentile(0.99) / 1e6, frame_time.percentile(0.999) / 1e6, frame_time.max() / 1e6);
+
+	// from the message reaching the window to the present of the frame that read it.
+	for (int i = 0; i < int(input_event::count); i++)
+	{
+		const histogram& latency = telemetry->event_latency(input_event(i));
+
+		if (latency.count())
+			std::printf("input latency: %-12s %8llu events, min %.2f ms, mean %.2f ms, p99 %.2f ms\n", environment_telemetry::event_name(input_event(i)),
+				static_cast<unsigned long long>(latency.count()), latency.min() / 1e6, latency.mean() / 1e6, latency.percentile(0.99) / 1e6);
+	}
+
+#ifdef MEMORY_TRACKING
+	// who holds the heap, and what the last frame allocated.
+	for (int i = 0; i < int(memory_tag::count); i++)
+	{
+		const memory_usage usage = memory_usage_of(memory_tag(i));
+		std::printf("memory: %-16s %10lld bytes live, %10lld peak, %8llu allocations, %5u in the last frame\n", memory_tag_name(memory_tag(i)),
+			static_cast<long long>(usage.live), static_cast<long long>(usage.peak), static_cast<unsigned long long>(usage.allocations), statistics->memory(memory_tag(i)).allocations);
+	}
+#endif
+
+	telemetry->export_histograms("frame_times.hgrm");
+
+#ifdef PROFILER
+	// where the session's frame time went, and the raw scopes for chrome://tracing.
+	for (const auto& total : profiler->totals(profile_group::category))
+		std::printf("profile: %-12s %8zu calls, %10.3f ms total, %10.3f ms self, %8.3f ms max\n", total.key, total.count, total.total / 1e6, total.self / 1e6, total.max / 1e6);
+
+	for (const auto& total : profiler->totals(profile_group::window))
+		std::printf("profile: window %-12s %10.3f ms self\n", total.key, total.self / 1e6);
+
+	profiler->export_trace("profile.json");
+#endif
+
+#ifdef INPUT_LOG
+	gui::input->set_recorder(nullptr);
+
+	if (session.save("input.log"))
+		std::printf("input: %zu frames recorded to input.log\n", session.frames());
+#endif
+
 	// clean up.
 	render->restore();
 	directx->restore();
@@ -1,4 +1,10 @@
 #include "gui.h"
+#include "input_log.h"
+#include "../render/telemetry.h"
+#include "../other/allocations.h"
+#include "../other/profiler.h"
+#include <algorithm>
+#include <cmath>
 
 using namespace gui;
 
@@ -14,11 +20,22 @@ void gui_input::poll_input()
 {
 	std::memcpy(this->old_key_state, this->key_state, sizeof(this->old_key_state));
 
-	// check if input is within window.
-	bool in_window = GetForegroundWindow() != this->handle;
+	if (this->scripted)
+		std::memcpy(this->key_state, this->script_state, sizeof(this->key_state));
+	else
+	{
+		// check if input is within window.
+		bool in_window = GetForegroundWindow() != this->handle;
 
-	for (int i = 0; i < max_key_state; i++)
-		this->key_state[i] = in_window ? false : (GetAsyncKeyState(i) & 0xFFFF);
+		for (int i = 0; i < max_key_state; i++)
+			this->key_state[i] = in_window ? false : (GetAsyncKeyState(i) & 0xFFFF);
+	}
+
+	// everything the gui reads this frame is settled now.
+	telemetry->input_read();
+
+	if (this->recorder)
+		this->recorder->record(this->mouse, this->mouse_wheel, this->key_state);
 }
 
 bool gui_input::process_mouse(HWND handle, UINT message, WPARAM wparam, LPARAM lparam)
@@ -26,29 +43,81 @@ bool gui_input::process_mouse(HWND handle, UINT message, WPARAM wparam, LPARAM l
 	switch (message)
 	{
 	case WM_MOUSEMOVE:
+		telemetry->input_arrived(input_event::mouse_move);
 		this->mouse = { LOWORD(lparam), HIWORD(lparam) };
 		return true;
 
 	case WM_MOUSEWHEEL:
+		telemetry->input_arrived(input_event::mouse_wheel);
 		this->set_mouse_wheel(GET_WHEEL_DELTA_WPARAM(wparam) / WHEEL_DELTA);
 		return true;
+
+	// buttons and keys are polled, their messages only stamp when they happened and go on to the default.
+	case WM_LBUTTONDOWN:
+	case WM_LBUTTONUP:
+	case WM_RBUTTONDOWN:
+	case WM_RBUTTONUP:
+	case WM_MBUTTONDOWN:
+	case WM_MBUTTONUP:
+		telemetry->input_arrived(input_event::mouse_button);
+		break;
+
+	case WM_KEYDOWN:
+	case WM_SYSKEYDOWN:
+		// held keys repeat, only the first press changes anything.
+		if (lparam & (1 << 30))
+			break;
+
+		telemetry->input_arrived(input_event::key);
+		break;
+
+	case WM_KEYUP:
+	case WM_SYSKEYUP:
+		telemetry->input_arrived(input_event::key);
+		break;
 	}
 
 	return false;
 }
 
+void gui_input::set_scripted(bool enabled)
+{
+	this->scripted = enabled;
+	std::memset(this->script_state, 0, sizeof(this->script_state));
+}
+
+void gui_input::script_key(const int key, bool down)
+{
+	if (key >= 0 && key < max_key_state)
+		this->script_state[key] = down;
+}
+
+void gui_input::set_recorder(input_log* log)
+{
+	this->recorder = log;
+}
+
 bool gui_input::key_down(const int key)
 {
+	if (key < 0 || key >= max_key_state)
+		return false;
+
 	return this->key_state[key] && this->old_key_state[key];
 }
 
 bool gui_input::key_pressed(const int key)
 {
+	if (key < 0 || key >= max_key_state)
+		return false;
+
 	return this->key_state[key] && !this->old_key_state[key];
 }
 
 bool gui_input::key_released(const int key)
 {
+	if (key < 0 || key >= max_key_state)
+		return false;
+
 	return !this->key_state[key] && this->old_key_state[key];
 }
 
@@ -64,8 +133,14 @@ int gui_input::get_mouse_wheel()
 
 bool gui_input::in_bound(rect area)
 {
-	return this->mouse.x >= area.x && this->mouse.y >= area.y
+	const bool inside = this->mouse.x >= area.x && this->mouse.y >= area.y
 		&& this->mouse.x <= area.x + area.w && this->mouse.y <= area.y + area.h + 1;
+
+	// hover tests made while a window records its draw list decide when that list goes stale.
+	if (render->capturing())
+		render->capture_list()->add_probe(area, inside);
+
+	return inside;
 }
 
 gui_event* gui::events = new gui_event;
@@ -121,6 +196,9 @@ gui_instance::~gui_instance()
 
 void gui_instance::draw()
 {
+	PROFILE_SCOPE("draw", "gui");
+	memory_scope memory(memory_tag::render_vertices);
+
 	// we haven't pressed our menu key then don't draw.
 	if (!events->get_state())
 		return;
@@ -135,12 +213,16 @@ void gui_instance::draw()
 		if (!handle)
 			continue;
 
+		// sorted by input time, the last window is the one being interacted with.
+		handle->topmost = handle == this->windows.back();
 		handle->draw();
 	}
 }
 
 void gui_instance::think()
 {
+	PROFILE_SCOPE("think", "gui");
+
 	// handle gui input.
 	input->poll_input();
 
@@ -219,6 +301,56 @@ void gui_instance::add(window* handle)
 	this->windows.push_back(handle);
 }
 
+void gui_instance::invalidate()
+{
+	for (const auto& handle : this->windows)
+	{
+		if (handle)
+			handle->invalidate();
+	}
+}
+
+std::uint64_t gui_instance::state_hash()
+{
+	std::uint64_t hash = hash_value(hash_seed, events->get_state());
+
+	for (const auto& handle : this->windows)
+	{
+		if (!handle)
+			continue;
+
+		hash = hash_string(hash, handle->get_title());
+		hash = hash_value(hash, handle->position);
+		hash = hash_value(hash, handle->last_input_time);
+		hash = hash_value(hash, std::find(handle->tabs.begin(), handle->tabs.end(), handle->tab_selected) - handle->tabs.begin());
+
+		// every tab and sub tab, not only the ones on screen, and through them every bound value.
+		for (const auto& page : handle->tabs)
+		{
+			if (!page)
+				continue;
+
+			page->hash_state(hash);
+
+			for (const auto& sub : page->sub_tabs)
+			{
+				if (sub)
+					sub->hash_state(hash);
+			}
+		}
+	}
+
+	// window::hash_state knows the focused element by its address, here it goes by title and place.
+	if (element* focussed = events->get_focussed())
+	{
+		hash = hash_string(hash, focussed->get_title());
+		hash = hash_value(hash, focussed->draw_position());
+		focussed->hash_state(hash);
+	}
+
+	return hash;
+}
+
 window::window(const char* title, const point& position, const dimension& size)
 {
 	this->title		= title;
@@ -233,14 +365,120 @@ window::~window()
 {
 	for (auto handle : this->tabs)
 		SAFE_DELETE(handle);
+
+	render->release_surface(this->surface);
 }
 
 void window::draw()
+{
+	PROFILE_ELEMENT("window");
+
+	std::uint64_t state = hash_seed;
+	this->hash_state(state);
+
+	bool dirty = !this->cache_valid || state != this->cache_state;
+
+	// dragging only moves the window, the recorded list can follow it.
+	if (!dirty && this->position != this->cache_origin)
+	{
+		const point moved = this->position - this->cache_origin;
+		this->cache.translate(moved.x, moved.y);
+		this->cache_origin = this->position;
+	}
+
+	// a hover test that would answer differently now means a widget changed its look.
+	for (std::size_t i = 0; !dirty && i < this->cache.probes.size(); i++)
+		dirty = input->in_bound(this->cache.probes[i].area) != this->cache.probes[i].inside;
+
+	if (dirty)
+	{
+		this->cache.clear();
+
+		render->begin_capture(&this->cache);
+		this->draw_contents();
+		render->end_capture();
+
+		this->cache_origin	= this->position;
+		this->cache_state	= state;
+		this->cache_valid	= true;
+
+		this->surface.valid	= false;
+	}
+
+	if (this->draw_offscreen())
+		return;
+
+	render->replay(this->cache);
+}
+
+void window::set_offscreen(bool enabled)
+{
+	this->offscreen = enabled;
+
+	if (!enabled)
+		render->release_surface(this->surface);
+}
+
+bool window::draw_offscreen()
+{
+	// the focused element is drawn over every window and may reach past this one, so it can't come from a texture.
+	if (!this->offscreen || this->topmost || events->has_focus())
+		return false;
+
+	// the border reaches 6 pixels past the window on each side.
+	const int margin	= 6;
+	const rect area		= { this->position.x - margin, this->position.y - margin, this->size.w + margin * 2, this->size.h + margin * 2 };
+
+	if (!render->acquire_surface(this->surface, area.w, area.h))
+		return false;
+
+	if (!this->surface.valid)
+	{
+		if (!render->begin_surface(this->surface))
+			return false;
+
+		// the list is recorded in screen space, move it to the surface's origin for the redraw.
+		this->cache.translate(-area.x, -area.y);
+		render->replay(this->cache);
+		this->cache.translate(area.x, area.y);
+
+		render->end_surface();
+		this->surface.valid = true;
+	}
+
+	render->draw_surface(this->surface, area.x, area.y);
+	return true;
+}
+
+void window::hash_state(std::uint64_t& hash)
+{
+	// by index, the same in every process, so gui_instance::state_hash can use it too.
+	hash = hash_value(hash, std::find(this->tabs.begin(), this->tabs.end(), this->tab_selected) - this->tabs.begin());
+	hash = hash_value(hash, this->size);
+
+	// the focused element is drawn on top by every window.
+	element* focussed = events->get_focussed();
+	hash = hash_value(hash, focussed);
+
+	// it may belong to another window, which moves or scrolls it independently. relative to this window, so
+	// dragging moves it along with the recorded list only when it is ours.
+	if (focussed)
+	{
+		hash = hash_value(hash, focussed->draw_position() - this->position);
+		focussed->hash_state(hash);
+	}
+
+	// only the selected tab gets drawn.
+	if (this->tab_selected)
+		this->tab_selected->hash_state(hash);
+}
+
+void window::draw_contents()
 {
 	rect window_area		= { this->position.x, this->position.y, this->size.w, this->size.h };
 
 	// background.
-	render->filled_rect(window_area.x, window_area.y, window_area.w, window_area.h, color(20, 20, 20));
+	render->filled_rect(window_area.x, window_area.y, window_area.w, window_area.h, theme::window);
 
 	// add tabs here.
 	if (!this->tabs.empty())
@@ -248,16 +486,16 @@ void window::draw()
 		rect handle_area	= { window_area.x, window_area.y, 100, window_area.h };
 
 		// tabs background.
-		render->filled_rect(handle_area.x, handle_area.y + 1, handle_area.w, handle_area.h - 1, color(12, 12, 12));
+		render->filled_rect(handle_area.x, handle_area.y + 1, handle_area.w, handle_area.h - 1, theme::panel);
 
 		// tabs outline.
-		render->line(handle_area.x + handle_area.w, handle_area.y, handle_area.x + handle_area.w, handle_area.y + handle_area.h, color(35, 35, 35));
+		render->line(handle_area.x + handle_area.w, handle_area.y, handle_area.x + handle_area.w, handle_area.y + handle_area.h, theme::outline);
 
 		// sometimes we want empty window.
 		if (!this->tab_selected)
 			return;
 
-		for (int i = 0; i < this->tabs.size(); i++)
+		for (int i = 0; i < int(this->tabs.size()); i++)
 		{
 			rect tabs_area	= { handle_area.x, (handle_area.y + 20) + (i * (90 + (int)this->tabs.size())), handle_area.w, 90 + (int)this->tabs.size() };
 			tab* handle		= this->tabs[i];
@@ -265,18 +503,18 @@ void window::draw()
 			if (this->tab_selected == handle)
 			{
 				// tabs background.
-				render->filled_rect(tabs_area.x, tabs_area.y, tabs_area.w + 1, tabs_area.h, color(20, 20, 20));
+				render->filled_rect(tabs_area.x, tabs_area.y, tabs_area.w + 1, tabs_area.h, theme::window);
 				// top outline.
-				render->line(tabs_area.x - 1, tabs_area.y + (tabs_area.h - tabs_area.h) - 1, tabs_area.x + tabs_area.w, tabs_area.y + (tabs_area.h - tabs_area.h) - 1, color(35, 35, 35));
+				render->line(tabs_area.x - 1, tabs_area.y + (tabs_area.h - tabs_area.h) - 1, tabs_area.x + tabs_area.w, tabs_area.y + (tabs_area.h - tabs_area.h) - 1, theme::outline);
 				// bottom outline.
-				render->line(tabs_area.x - 1, tabs_area.y + tabs_area.h, tabs_area.x + tabs_area.w, tabs_area.y + tabs_area.h, color(35, 35, 35));
+				render->line(tabs_area.x - 1, tabs_area.y + tabs_area.h, tabs_area.x + tabs_area.w, tabs_area.y + tabs_area.h, theme::outline);
 				// menu text -> selected -> white.
-				fonts->segoe_ui_bold.text(tabs_area.x + (tabs_area.w / 2) - 15, (tabs_area.y - 25) + (tabs_area.h / 2) - 15, handle->get_title(), color(255, 255, 255));
+				fonts->segoe_ui_bold.text(tabs_area.x + (tabs_area.w / 2) - 15, (tabs_area.y - 25) + (tabs_area.h / 2) - 15, handle->get_title(), theme::text);
 			}
 			else
 			{
 				// not selected -> grey.
-				fonts->segoe_ui_bold.text(tabs_area.x + (tabs_area.w / 2) - 15, (tabs_area.y - 25) + (tabs_area.h / 2) - 15, handle->get_title(), color(92, 92, 92));
+				fonts->segoe_ui_bold.text(tabs_area.x + (tabs_area.w / 2) - 15, (tabs_area.y - 25) + (tabs_area.h / 2) - 15, handle->get_title(), theme::text_inactive);
 			}
 		}
 
@@ -289,24 +527,24 @@ void window::draw()
 		events->get_focussed()->draw();
 
 	// skeet rgb line.
-	render->gradient(window_area.x, window_area.y + 1, window_area.w / 2, 1, color(99, 160, 200), color(179, 102, 181), gradient_direction::horizontal);
-	render->gradient(window_area.x + (window_area.w / 2), window_area.y + 1, window_area.w / 2, 1, color(179, 102, 181), color(230, 217, 100), gradient_direction::horizontal);
+	render->gradient(window_area.x, window_area.y + 1, window_area.w / 2, 1, theme::accent_blue, theme::accent_purple, gradient_direction::horizontal);
+	render->gradient(window_area.x + (window_area.w / 2), window_area.y + 1, window_area.w / 2, 1, theme::accent_purple, theme::accent_yellow, gradient_direction::horizontal);
 
-	render->gradient(window_area.x, window_area.y + 2, window_area.w / 2, 1, color(49, 79, 99), color(89, 50, 90), gradient_direction::horizontal);
-	render->gradient(window_area.x + (window_area.w / 2), window_area.y + 2, window_area.w / 2, 1, color(89, 50, 90), color(114, 108, 49), gradient_direction::horizontal);
+	render->gradient(window_area.x, window_area.y + 2, window_area.w / 2, 1, theme::accent_blue_dark, theme::accent_purple_dark, gradient_direction::horizontal);
+	render->gradient(window_area.x + (window_area.w / 2), window_area.y + 2, window_area.w / 2, 1, theme::accent_purple_dark, theme::accent_yellow_dark, gradient_direction::horizontal);
 
 	// resize arrow.
 	//rect resize_area = { (window_area.x + window_area.w - 1) - 5, (window_area.y + (window_area.h - 7) + 1), 6, 6 };
 
 	//if (input->in_bound(resize_area))
 	//{
-	//	render->filled_rect(resize_area.x, resize_area.y, resize_area.w, resize_area.h, color(255, 255, 255));
-	//	render->filled_rect(resize_area.x, resize_area.y, resize_area.w - 3, resize_area.h - 3, color(20, 20, 20));
+	//	render->filled_rect(resize_area.x, resize_area.y, resize_area.w, resize_area.h, theme::text);
+	//	render->filled_rect(resize_area.x, resize_area.y, resize_area.w - 3, resize_area.h - 3, theme::window);
 	//}
 	//else
 	//{
 	//	render->filled_rect(resize_area.x, resize_area.y, resize_area.w, resize_area.h, color(50, 50, 50));
-	//	render->filled_rect(resize_area.x, resize_area.y, resize_area.w - 3, resize_area.h - 3, color(20, 20, 20));
+	//	render->filled_rect(resize_area.x, resize_area.y, resize_area.w - 3, resize_area.h - 3, theme::window);
 	//}
 	
 	// border.
@@ -318,6 +556,8 @@ void window::draw()
 
 void window::think()
 {
+	PROFILE_ELEMENT("window");
+
 	rect handle_area	= { this->position.x, this->position.y, 100, this->size.h };
 
 	// sometimes we want empty window.
@@ -327,7 +567,7 @@ void window::think()
 	// if we haven't selected any elements then do tabs input.
 	if (!events->get_focussed())
 	{
-		for (int i = 0; i < this->tabs.size(); i++)
+		for (int i = 0; i < int(this->tabs.size()); i++)
 		{
 			rect tabs_area = { handle_area.x, (handle_area.y + 20) + (i * (90 + (int)this->tabs.size())), handle_area.w, 90 + (int)this->tabs.size() };
 			tab* handle = this->tabs[i];
@@ -383,6 +623,8 @@ tab::~tab()
 
 void tab::draw()
 {
+	PROFILE_ELEMENT("tab");
+
 	// we have sub tab present then we draw sub tabs.
 	if (this->has_sub)
 	{
@@ -394,16 +636,16 @@ void tab::draw()
 			rect sub_handle_area		= { tabs_area.x + 15, tabs_area.y + (tabs_area.h - 70), tabs_area.w + 118, 66 };
 
 			// sub tabs background.
-			render->filled_rect(sub_handle_area.x, sub_handle_area.y + sub_handle_area.h, sub_handle_area.w, sub_handle_area.h, color(12, 12, 12));
+			render->filled_rect(sub_handle_area.x, sub_handle_area.y + sub_handle_area.h, sub_handle_area.w, sub_handle_area.h, theme::panel);
 
 			// sub tabs outline.
-			render->outlined_rect(sub_handle_area.x, sub_handle_area.y + sub_handle_area.h, sub_handle_area.w, sub_handle_area.h, color(35, 35, 35));
+			render->outlined_rect(sub_handle_area.x, sub_handle_area.y + sub_handle_area.h, sub_handle_area.w, sub_handle_area.h, theme::outline);
 
 			// sometimes we want empty window.
 			if (!this->sub_selected)
 				return;
 
-			for (int i = 0; i < this->sub_tabs.size(); i++)
+			for (int i = 0; i < int(this->sub_tabs.size()); i++)
 			{
 				const int sub_tab_width		= (sub_handle_area.w / (int)this->sub_tabs.size());
 				point sub_tabs_area			= { sub_handle_area.x + (i * sub_tab_width) + (sub_tab_width / 2), sub_handle_area.y + sub_handle_area.h + (sub_handle_area.h / 2) };
@@ -414,12 +656,12 @@ void tab::draw()
 				if (this->sub_selected == sub_handle)
 				{
 					// menu text -> selected -> white.
-					fonts->segoe_ui.text(sub_tabs_area.x - (text_size.w / 2), sub_tabs_area.y - (text_size.h / 2), sub_handle->get_title(), color(255, 255, 255));
+					fonts->segoe_ui.text(sub_tabs_area.x - (text_size.w / 2), sub_tabs_area.y - (text_size.h / 2), sub_handle->get_title(), theme::text);
 				}
 				else
 				{
 					// not selected -> grey.
-					fonts->segoe_ui.text(sub_tabs_area.x - (text_size.w / 2), sub_tabs_area.y - (text_size.h / 2), sub_handle->get_title(), color(92, 92, 92));
+					fonts->segoe_ui.text(sub_tabs_area.x - (text_size.w / 2), sub_tabs_area.y - (text_size.h / 2), sub_handle->get_title(), theme::text_inactive);
 				}
 			}
 
@@ -442,8 +684,26 @@ void tab::draw()
 	}
 }
 
+void tab::hash_state(std::uint64_t& hash)
+{
+	hash = hash_value(hash, std::find(this->sub_tabs.begin(), this->sub_tabs.end(), this->sub_selected) - this->sub_tabs.begin());
+
+	// only the selected sub tab gets drawn.
+	if (this->has_sub)
+	{
+		if (this->sub_selected)
+			this->sub_selected->hash_state(hash);
+
+		return;
+	}
+
+	element::hash_state(hash);
+}
+
 void tab::think()
 {
+	PROFILE_ELEMENT("tab");
+
 	// we have sub tab present then we draw sub tabs.
 	if (this->has_sub)
 	{
@@ -457,7 +717,7 @@ void tab::think()
 
 		if (!events->get_focussed())
 		{
-			for (int i = 0; i < this->sub_tabs.size(); i++)
+			for (int i = 0; i < int(this->sub_tabs.size()); i++)
 			{
 				const int sub_tab_width = (sub_handle_area.w / (int)this->sub_tabs.size());
 
@@ -531,6 +791,8 @@ sub_tab::~sub_tab()
 
 void sub_tab::draw()
 {
+	PROFILE_ELEMENT("sub_tab");
+
 	for (const auto& handle : this->elements)
 	{
 		// skip elements that are invalid.
@@ -544,6 +806,8 @@ void sub_tab::draw()
 
 void sub_tab::think()
 {
+	PROFILE_ELEMENT("sub_tab");
+
 	for (const auto& handle : this->elements)
 	{
 		// skip elements that are invalid.
@@ -585,6 +849,8 @@ column::~column()
 
 void column::draw()
 {
+	PROFILE_ELEMENT("column");
+
 	for (const auto& handle : this->elements)
 	{
 		// skip elements that are invalid.
@@ -598,6 +864,8 @@ void column::draw()
 
 void column::think()
 {
+	PROFILE_ELEMENT("column");
+
 	for (const auto& handle : this->elements)
 	{
 		// skip elements that are invalid.
@@ -647,12 +915,14 @@ group::~group()
 
 void group::draw()
 {
+	PROFILE_ELEMENT("group");
+
 	point offset_position	= this->parent->draw_position() + this->position + point(105, 0);
 	rect group_area			= { offset_position.x, offset_position.y, this->size.w, this->size.h };
 	float content_height	= this->offset.y - 20;
 
 	// background.
-	render->filled_rect(group_area.x, group_area.y, group_area.w, group_area.h, color(12, 12, 12));
+	render->filled_rect(group_area.x, group_area.y, group_area.w, group_area.h, theme::panel);
 
 	// handle element clipping.
 	render->start_clip(group_area);
@@ -669,17 +939,17 @@ void group::draw()
 		}
 
 		// separator / header.
-		render->filled_rect(group_area.x + 1, group_area.y, group_area.w - 2, 5, color(12, 12, 12));
-		render->gradient(group_area.x + 1, group_area.y + 5, group_area.w - 2, 12, color(12, 12, 12), color(12, 12, 12, 0), gradient_direction::vertical);
+		render->filled_rect(group_area.x + 1, group_area.y, group_area.w - 2, 5, theme::panel);
+		render->gradient(group_area.x + 1, group_area.y + 5, group_area.w - 2, 12, theme::panel, theme::panel.alpha(0), gradient_direction::vertical);
 
 		// blur.
 		if (content_height > group_area.h - 45)
-			render->gradient(group_area.x + 1, (group_area.y + group_area.h) - 13, group_area.w - 2, 12, color(12, 12, 12, 0), color(12, 12, 12), gradient_direction::vertical);
+			render->gradient(group_area.x + 1, (group_area.y + group_area.h) - 13, group_area.w - 2, 12, theme::panel.alpha(0), theme::panel, gradient_direction::vertical);
 	}
 	render->end_clip();
 
 	// outline.
-	render->outlined_rect(group_area.x, group_area.y, group_area.w, group_area.h, color(35, 35, 35));
+	render->outlined_rect(group_area.x, group_area.y, group_area.w, group_area.h, theme::outline);
 
 	// handle scroll bar rendering.
 	if (content_height > group_area.h - 45)
@@ -693,39 +963,47 @@ void group::draw()
 		if (scroll_position)
 		{
 			// fixed these upper and lower arrows relative to group box height, as before it messes up when group box height is being changed.
-			render->filled_rect((group_area.x + group_area.w - 6) - 5, (group_area.y + (group_area.h + 8) - (group_area.h + 4)), 1, 1, color(255, 255, 255));
-			render->filled_rect((group_area.x + group_area.w - 6) - 6, (group_area.y + (group_area.h + 8) - (group_area.h + 3)), 3, 1, color(255, 255, 255));
-			render->filled_rect((group_area.x + group_area.w - 6) - 7, (group_area.y + (group_area.h + 8) - (group_area.h + 2)), 5, 1, color(255, 255, 255));
+			render->filled_rect((group_area.x + group_area.w - 6) - 5, (group_area.y + (group_area.h + 8) - (group_area.h + 4)), 1, 1, theme::text);
+			render->filled_rect((group_area.x + group_area.w - 6) - 6, (group_area.y + (group_area.h + 8) - (group_area.h + 3)), 3, 1, theme::text);
+			render->filled_rect((group_area.x + group_area.w - 6) - 7, (group_area.y + (group_area.h + 8) - (group_area.h + 2)), 5, 1, theme::text);
 		}
 
 		// show lower arrow, not scrolled or scrolled -> lower arrow, max scrolled then lower arrow disappears.
 		if (max_scroll_position > scroll_position)
 		{
-			render->filled_rect((group_area.x + group_area.w - 6) - 7, (group_area.y + (group_area.h - 9) + 2), 5, 1, color(255, 255, 255));
-			render->filled_rect((group_area.x + group_area.w - 6) - 6, (group_area.y + (group_area.h - 9) + 3), 3, 1, color(255, 255, 255));
-			render->filled_rect((group_area.x + group_area.w - 6) - 5, (group_area.y + (group_area.h - 9) + 4), 1, 1, color(255, 255, 255));
+			render->filled_rect((group_area.x + group_area.w - 6) - 7, (group_area.y + (group_area.h - 9) + 2), 5, 1, theme::text);
+			render->filled_rect((group_area.x + group_area.w - 6) - 6, (group_area.y + (group_area.h - 9) + 3), 3, 1, theme::text);
+			render->filled_rect((group_area.x + group_area.w - 6) - 5, (group_area.y + (group_area.h - 9) + 4), 1, 1, theme::text);
 		}
 
 		// scroll bar rendering.
 		dimension scroll_size	= { 5, group_area.h };
 
 		// scroll background.
-		render->filled_rect((group_area.x + group_area.w) - scroll_size.w - 1, group_area.y + 1, scroll_size.w, scroll_size.h - 2, color(25, 25, 25));
+		render->filled_rect((group_area.x + group_area.w) - scroll_size.w - 1, group_area.y + 1, scroll_size.w, scroll_size.h - 2, theme::control);
 
 		// scroll bar.
-		render->filled_rect((group_area.x + group_area.w) - scroll_size.w + 1, group_area.y + scroll_position + 2, scroll_size.w - 3, scroll_size.h - max_scroll_position - 3, color(45, 45, 45));
+		render->filled_rect((group_area.x + group_area.w) - scroll_size.w + 1, group_area.y + scroll_position + 2, scroll_size.w - 3, scroll_size.h - max_scroll_position - 3, theme::scroll_bar);
 	}
 
 	// black line.
 	dimension text_size		= fonts->segoe_ui.text_size(this->get_title());
-	render->filled_rect(group_area.x + 15, group_area.y, text_size.w + 10, 1, color(12, 12, 12));
+	render->filled_rect(group_area.x + 15, group_area.y, text_size.w + 10, 1, theme::panel);
 
 	// group box title.
-	fonts->segoe_ui.text(group_area.x + 21, group_area.y - 7, this->get_title(), color(255, 255, 255));
+	fonts->segoe_ui.text(group_area.x + 21, group_area.y - 7, this->get_title(), theme::text);
+}
+
+void group::hash_state(std::uint64_t& hash)
+{
+	hash = hash_value(hash, this->scroll);
+	element::hash_state(hash);
 }
 
 void group::think()
 {
+	PROFILE_ELEMENT("group");
+
 	point offset_position	= this->parent->draw_position() + this->position + point(105, 0);
 	rect group_area			= { offset_position.x, offset_position.y, this->size.w, this->size.h };
 	float content_height	= this->offset.y - 20;
@@ -758,7 +1036,7 @@ void group::think()
 			continue;
 
 		// handle element input.
-		if ((!events->has_focus() && input->in_bound(group_area)) || (events->has_focus() && events->has_focus(handle)))
+		if (!handle->takes_input() || (!events->has_focus() && input->in_bound(group_area)) || (events->has_focus() && events->has_focus(handle)))
 			handle->think();
 	}
 }
@@ -783,25 +1061,34 @@ checkbox::checkbox(group* parent, const char* title, bool* value)
 
 void checkbox::draw()
 {
+	PROFILE_ELEMENT("checkbox");
+
 	point control_position	= this->parent->draw_position() + this->position + point(105, 0);
 	rect checkbox_area		= { control_position.x, control_position.y, 9, 9 };
 
 	// background.
-	render->filled_rect(checkbox_area.x, checkbox_area.y + 1, checkbox_area.w, checkbox_area.h, color(25, 25, 25));
+	render->filled_rect(checkbox_area.x, checkbox_area.y + 1, checkbox_area.w, checkbox_area.h, theme::control);
 
 	// value = true -> white.
 	if (*this->value)
-		render->filled_rect(checkbox_area.x, checkbox_area.y + 1, checkbox_area.w, checkbox_area.h, color(255, 255, 255));
+		render->filled_rect(checkbox_area.x, checkbox_area.y + 1, checkbox_area.w, checkbox_area.h, theme::text);
 
 	// outline.
-	render->outlined_rect(checkbox_area.x, checkbox_area.y + 1, checkbox_area.w, checkbox_area.h, color(35, 35, 35));
+	render->outlined_rect(checkbox_area.x, checkbox_area.y + 1, checkbox_area.w, checkbox_area.h, theme::outline);
 
 	// title.
-	fonts->segoe_ui.text((checkbox_area.x + 11) + checkbox_area.w, checkbox_area.y + (checkbox_area.w / 2) - 7, this->get_title(), color(255, 255, 255));
+	fonts->segoe_ui.text((checkbox_area.x + 11) + checkbox_area.w, checkbox_area.y + (checkbox_area.w / 2) - 7, this->get_title(), theme::text);
+}
+
+void checkbox::hash_state(std::uint64_t& hash)
+{
+	hash = hash_value(hash, *this->value);
 }
 
 void checkbox::think()
 {
+	PROFILE_ELEMENT("checkbox");
+
 	point control_position	= this->parent->draw_position() + this->position + point(105, 0);
 	rect checkbox_area		= { control_position.x, control_position.y, 9, 9 };
 
@@ -832,18 +1119,20 @@ slider_int::slider_int(group* parent, const char* title, int* value, int min, in
 
 void slider_int::draw()
 {
+	PROFILE_ELEMENT("slider_int");
+
 	point control_position	= this->parent->draw_position() + this->position + point(125, 7);
 	rect slider_area		= { control_position.x, control_position.y, 180, 6 };
 
 	// title.
 	dimension text_size		= fonts->segoe_ui.text_size(this->get_title());
-	fonts->segoe_ui.text(slider_area.x, (slider_area.y - 2) - (text_size.h - 2), this->get_title(), color(255, 255, 255));
+	fonts->segoe_ui.text(slider_area.x, (slider_area.y - 2) - (text_size.h - 2), this->get_title(), theme::text);
 
 	// format slider value.
 	std::string text_value	= translate->format("%d", *this->value);
 
 	// slider background.
-	render->filled_rect(slider_area.x, slider_area.y, slider_area.w, slider_area.h, color(25, 25, 25));
+	render->filled_rect(slider_area.x, slider_area.y, slider_area.w, slider_area.h, theme::control);
 
 	// fixed: slider bar not showing whilst sliding until it hits the max value of slider -> only applies to int min, max values.
 	float max_delta		= this->max - this->min;
@@ -851,24 +1140,31 @@ void slider_int::draw()
 	float value_mod		= (value_delta / max_delta) * slider_area.w;
 
 	// slider bar.
-	render->filled_rect(slider_area.x, slider_area.y, value_mod, slider_area.h, color(255, 255, 255));
+	render->filled_rect(slider_area.x, slider_area.y, value_mod, slider_area.h, theme::text);
 
 	// slider outline.
-	render->outlined_rect(slider_area.x, slider_area.y, slider_area.w + 1, slider_area.h + 1, color(35, 35, 35));
+	render->outlined_rect(slider_area.x, slider_area.y, slider_area.w + 1, slider_area.h + 1, theme::outline);
 
 	// slider value w/ suffix.
 	if (this->suffix)
 	{
 		text_value += this->suffix;
-		fonts->segoe_ui.text(slider_area.x + (int)value_mod, slider_area.y, text_value.c_str(), color(255, 255, 255));
+		fonts->segoe_ui.text(slider_area.x + (int)value_mod, slider_area.y, text_value.c_str(), theme::text);
 	}
 	// slider value.
 	else
-		fonts->segoe_ui.text(slider_area.x + (int)value_mod, slider_area.y, text_value.c_str(), color(255, 255, 255));
+		fonts->segoe_ui.text(slider_area.x + (int)value_mod, slider_area.y, text_value.c_str(), theme::text);
+}
+
+void slider_int::hash_state(std::uint64_t& hash)
+{
+	hash = hash_value(hash, *this->value);
 }
 
 void slider_int::think()
 {
+	PROFILE_ELEMENT("slider_int");
+
 	point control_position	= this->parent->draw_position() + this->position + point(125, 7);
 	rect slider_area		= { control_position.x, control_position.y, 180, 6 };
 	float max_delta			= this->max - this->min;
@@ -899,18 +1195,20 @@ slider_float::slider_float(group* parent, const char* title, float* value, float
 
 void slider_float::draw()
 {
+	PROFILE_ELEMENT("slider_float");
+
 	point control_position	= this->parent->draw_position() + this->position + point(125, 7);
 	rect slider_area		= { control_position.x, control_position.y, 180, 6 };
 
 	// title.
 	dimension text_size		= fonts->segoe_ui.text_size(this->get_title());
-	fonts->segoe_ui.text(slider_area.x, (slider_area.y - 2) - (text_size.h - 2), this->get_title(), color(255, 255, 255));
+	fonts->segoe_ui.text(slider_area.x, (slider_area.y - 2) - (text_size.h - 2), this->get_title(), theme::text);
 
 	// format slider value.
 	std::string text_value	= translate->format("%.1f", *this->value);
 
 	// slider background.
-	render->filled_rect(slider_area.x, slider_area.y, slider_area.w, slider_area.h, color(25, 25, 25));
+	render->filled_rect(slider_area.x, slider_area.y, slider_area.w, slider_area.h, theme::control);
 
 	// fixed: slider bar not showing whilst sliding until it hits the max value of slider -> only applies to int min, max values.
 	float max_delta		= this->max - this->min;
@@ -918,24 +1216,31 @@ void slider_float::draw()
 	float value_mod		= (value_delta / max_delta) * slider_area.w;
 
 	// slider bar.
-	render->filled_rect(slider_area.x, slider_area.y, value_mod, slider_area.h, color(255, 255, 255));
+	render->filled_rect(slider_area.x, slider_area.y, value_mod, slider_area.h, theme::text);
 
 	// slider outline.
-	render->outlined_rect(slider_area.x, slider_area.y, slider_area.w + 1, slider_area.h + 1, color(35, 35, 35));
+	render->outlined_rect(slider_area.x, slider_area.y, slider_area.w + 1, slider_area.h + 1, theme::outline);
 
 	// slider value w/ suffix.
 	if (this->suffix)
 	{
 		text_value += this->suffix;
-		fonts->segoe_ui.text(slider_area.x + (int)value_mod, slider_area.y, text_value.c_str(), color(255, 255, 255));
+		fonts->segoe_ui.text(slider_area.x + (int)value_mod, slider_area.y, text_value.c_str(), theme::text);
 	}
 	// slider value.
 	else
-		fonts->segoe_ui.text(slider_area.x + (int)value_mod, slider_area.y, text_value.c_str(), color(255, 255, 255));
+		fonts->segoe_ui.text(slider_area.x + (int)value_mod, slider_area.y, text_value.c_str(), theme::text);
+}
+
+void slider_float::hash_state(std::uint64_t& hash)
+{
+	hash = hash_value(hash, *this->value);
 }
 
 void slider_float::think()
 {
+	PROFILE_ELEMENT("slider_float");
+
 	point control_position	= this->parent->draw_position() + this->position + point(125, 7);
 	rect slider_area		= { control_position.x, control_position.y, 180, 6 };
 	float max_delta			= this->max - this->min;
@@ -964,46 +1269,48 @@ combo::combo(group* parent, const char* title, int* value, const std::vector<con
 
 void combo::draw()
 {
+	PROFILE_ELEMENT("combo");
+
 	point control_position	= this->parent->draw_position() + this->position + point(125, 7);
 	rect combo_area			= { control_position.x, control_position.y, 180, 18 };
 
 	// dropdown background.
 	if (!events->has_focus(this) && input->in_bound(combo_area))
-		render->filled_rect(combo_area.x, combo_area.y, combo_area.w, combo_area.h, color(34, 34, 34));
+		render->filled_rect(combo_area.x, combo_area.y, combo_area.w, combo_area.h, theme::dropdown_hovered);
 	else
-		render->filled_rect(combo_area.x, combo_area.y, combo_area.w, combo_area.h, color(30, 30, 30));
+		render->filled_rect(combo_area.x, combo_area.y, combo_area.w, combo_area.h, theme::dropdown);
 
 	// dropdown outline.
-	render->outlined_rect(combo_area.x, combo_area.y, combo_area.w + 1, combo_area.h + 1, color(35, 35, 35));
+	render->outlined_rect(combo_area.x, combo_area.y, combo_area.w + 1, combo_area.h + 1, theme::outline);
 
 	// title.
-	fonts->segoe_ui.text(combo_area.x, combo_area.y - (combo_area.h / 2) - 5, this->get_title(), color(255, 255, 255));
+	fonts->segoe_ui.text(combo_area.x, combo_area.y - (combo_area.h / 2) - 5, this->get_title(), theme::text);
 
 	// construct dropdown list.
-	fonts->segoe_ui.text(combo_area.x + 8, combo_area.y + (combo_area.h / 2) - 8, this->list[*this->value], color(255, 255, 255));
+	fonts->segoe_ui.text(combo_area.x + 8, combo_area.y + (combo_area.h / 2) - 8, this->list[*this->value], theme::text);
 
 	// dropdown opened.
 	if (events->has_focus(this))
 	{
-		for (int i = 0; i < this->list.size(); i++)
+		for (int i = 0; i < int(this->list.size()); i++)
 		{
 			rect list_area	= { combo_area.x, combo_area.y + 20 + (combo_area.h * i), combo_area.w, combo_area.h };
 			bool in_bound	= input->in_bound(list_area);
 
 			// dropdown list background.
-			render->filled_rect(list_area.x, list_area.y, list_area.w + 1, list_area.h, in_bound ? color(25, 25, 25) : color(30, 30, 30));
+			render->filled_rect(list_area.x, list_area.y, list_area.w + 1, list_area.h, in_bound ? theme::control : theme::dropdown);
 
 			// selected -> black.
 			if (*this->value == i || in_bound)
 			{
 				// list items text.
-				fonts->segoe_ui.text(list_area.x + 8, list_area.y + (list_area.h / 2) - 8, this->list[i], color(255, 255, 255));
+				fonts->segoe_ui.text(list_area.x + 8, list_area.y + (list_area.h / 2) - 8, this->list[i], theme::text);
 			}
 			// not selected -> grey.
 			else
 			{
 				// list items text.
-				fonts->segoe_ui.text(list_area.x + 8, list_area.y + (list_area.h / 2) - 8, this->list[i], color(120, 120, 120));
+				fonts->segoe_ui.text(list_area.x + 8, list_area.y + (list_area.h / 2) - 8, this->list[i], theme::text_unselected);
 			}
 		}
 	}
@@ -1012,21 +1319,28 @@ void combo::draw()
 	// open -> up arrow.
 	if (events->has_focus(this))
 	{
-		render->filled_rect((combo_area.x + combo_area.w - 6) - 5, combo_area.y + ((combo_area.h / 2) + 3) - 4, 1, 1, color(255, 255, 255));
-		render->filled_rect((combo_area.x + combo_area.w - 6) - 6, combo_area.y + ((combo_area.h / 2) + 3) - 3, 3, 1, color(255, 255, 255));
-		render->filled_rect((combo_area.x + combo_area.w - 6) - 7, combo_area.y + ((combo_area.h / 2) + 3) - 2, 5, 1, color(255, 255, 255));
+		render->filled_rect((combo_area.x + combo_area.w - 6) - 5, combo_area.y + ((combo_area.h / 2) + 3) - 4, 1, 1, theme::text);
+		render->filled_rect((combo_area.x + combo_area.w - 6) - 6, combo_area.y + ((combo_area.h / 2) + 3) - 3, 3, 1, theme::text);
+		render->filled_rect((combo_area.x + combo_area.w - 6) - 7, combo_area.y + ((combo_area.h / 2) + 3) - 2, 5, 1, theme::text);
 	}
 	// close -> down arrow.
 	else
 	{
-		render->filled_rect((combo_area.x + combo_area.w - 6) - 7, combo_area.y + ((combo_area.h / 2) - 3) + 2, 5, 1, color(255, 255, 255));
-		render->filled_rect((combo_area.x + combo_area.w - 6) - 6, combo_area.y + ((combo_area.h / 2) - 3) + 3, 3, 1, color(255, 255, 255));
-		render->filled_rect((combo_area.x + combo_area.w - 6) - 5, combo_area.y + ((combo_area.h / 2) - 3) + 4, 1, 1, color(255, 255, 255));
+		render->filled_rect((combo_area.x + combo_area.w - 6) - 7, combo_area.y + ((combo_area.h / 2) - 3) + 2, 5, 1, theme::text);
+		render->filled_rect((combo_area.x + combo_area.w - 6) - 6, combo_area.y + ((combo_area.h / 2) - 3) + 3, 3, 1, theme::text);
+		render->filled_rect((combo_area.x + combo_area.w - 6) - 5, combo_area.y + ((combo_area.h / 2) - 3) + 4, 1, 1, theme::text);
 	}
 }
 
+void combo::hash_state(std::uint64_t& hash)
+{
+	hash = hash_value(hash, *this->value);
+}
+
 void combo::think()
 {
+	PROFILE_ELEMENT("combo");
+
 	point control_position	= this->parent->draw_position() + this->position + point(125, 7);
 	rect combo_area			= { control_position.x, control_position.y, 180, 18 };
 	// add extra 20 height fixes last item in the dropdown not being registered.
@@ -1050,7 +1364,7 @@ void combo::think()
 	// open dropdown.
 	if (events->has_focus(this))
 	{
-		for (int i = 0; i < this->list.size(); i++)
+		for (int i = 0; i < int(this->list.size()); i++)
 		{
 			rect list_area		= { combo_area.x, combo_area.y + 20 + (combo_area.h * i), combo_area.w, combo_area.h };
 
@@ -1074,46 +1388,48 @@ multi::multi(group* parent, const char* title)
 
 void multi::draw()
 {
+	PROFILE_ELEMENT("multi");
+
 	point control_position	= this->parent->draw_position() + this->position + point(125, 7);
 	rect multi_area			= { control_position.x, control_position.y, 180, 18 };
 
 	// dropdown background.
 	if (!events->has_focus(this) && input->in_bound(multi_area))
-		render->filled_rect(multi_area.x, multi_area.y, multi_area.w, multi_area.h, color(34, 34, 34));
+		render->filled_rect(multi_area.x, multi_area.y, multi_area.w, multi_area.h, theme::dropdown_hovered);
 	else
-		render->filled_rect(multi_area.x, multi_area.y, multi_area.w, multi_area.h, color(30, 30, 30));
+		render->filled_rect(multi_area.x, multi_area.y, multi_area.w, multi_area.h, theme::dropdown);
 
 	// dropdown outline.
-	render->outlined_rect(multi_area.x, multi_area.y, multi_area.w + 1, multi_area.h + 1, color(35, 35, 35));
+	render->outlined_rect(multi_area.x, multi_area.y, multi_area.w + 1, multi_area.h + 1, theme::outline);
 
 	// title.
-	fonts->segoe_ui.text(multi_area.x, multi_area.y - (multi_area.h / 2) - 5, this->get_title(), color(255, 255, 255));
+	fonts->segoe_ui.text(multi_area.x, multi_area.y - (multi_area.h / 2) - 5, this->get_title(), theme::text);
 
 	// construct dropdown list.
-	fonts->segoe_ui.text(multi_area.x + 8, multi_area.y + (multi_area.h / 2) - 8, this->construct_list(this->list).c_str(), color(255, 255, 255));
+	fonts->segoe_ui.text(multi_area.x + 8, multi_area.y + (multi_area.h / 2) - 8, this->construct_list(this->list).c_str(), theme::text);
 
 	// dropdown opened.
 	if (events->has_focus(this))
 	{
-		for (int i = 0; i < this->list.size(); i++)
+		for (int i = 0; i < int(this->list.size()); i++)
 		{
 			rect list_area	= { multi_area.x, multi_area.y + 20 + (multi_area.h * i), multi_area.w, multi_area.h };
 			bool in_bound	= input->in_bound(list_area);
 
 			// dropdown list background.
-			render->filled_rect(list_area.x, list_area.y, list_area.w + 1, list_area.h, in_bound ? color(25, 25, 25) : color(30, 30, 30));
+			render->filled_rect(list_area.x, list_area.y, list_area.w + 1, list_area.h, in_bound ? theme::control : theme::dropdown);
 
 			// selected -> black.
 			if (*this->list[i].value || in_bound)
 			{
 				// list items text.
-				fonts->segoe_ui.text(list_area.x + 8, list_area.y + (list_area.h / 2) - 8, this->list[i].title, color(255, 255, 255));
+				fonts->segoe_ui.text(list_area.x + 8, list_area.y + (list_area.h / 2) - 8, this->list[i].title, theme::text);
 			}
 			// not selected -> grey.
 			else
 			{
 				// list items text.
-				fonts->segoe_ui.text(list_area.x + 8, list_area.y + (list_area.h / 2) - 8, this->list[i].title, color(120, 120, 120));
+				fonts->segoe_ui.text(list_area.x + 8, list_area.y + (list_area.h / 2) - 8, this->list[i].title, theme::text_unselected);
 			}
 		}
 	}
@@ -1122,21 +1438,29 @@ void multi::draw()
 	// open -> up arrow.
 	if (events->has_focus(this))
 	{
-		render->filled_rect((multi_area.x + multi_area.w - 6) - 5, multi_area.y + ((multi_area.h / 2) + 3) - 4, 1, 1, color(255, 255, 255));
-		render->filled_rect((multi_area.x + multi_area.w - 6) - 6, multi_area.y + ((multi_area.h / 2) + 3) - 3, 3, 1, color(255, 255, 255));
-		render->filled_rect((multi_area.x + multi_area.w - 6) - 7, multi_area.y + ((multi_area.h / 2) + 3) - 2, 5, 1, color(255, 255, 255));
+		render->filled_rect((multi_area.x + multi_area.w - 6) - 5, multi_area.y + ((multi_area.h / 2) + 3) - 4, 1, 1, theme::text);
+		render->filled_rect((multi_area.x + multi_area.w - 6) - 6, multi_area.y + ((multi_area.h / 2) + 3) - 3, 3, 1, theme::text);
+		render->filled_rect((multi_area.x + multi_area.w - 6) - 7, multi_area.y + ((multi_area.h / 2) + 3) - 2, 5, 1, theme::text);
 	}
 	// close -> down arrow.
 	else
 	{
-		render->filled_rect((multi_area.x + multi_area.w - 6) - 7, multi_area.y + ((multi_area.h / 2) - 3) + 2, 5, 1, color(255, 255, 255));
-		render->filled_rect((multi_area.x + multi_area.w - 6) - 6, multi_area.y + ((multi_area.h / 2) - 3) + 3, 3, 1, color(255, 255, 255));
-		render->filled_rect((multi_area.x + multi_area.w - 6) - 5, multi_area.y + ((multi_area.h / 2) - 3) + 4, 1, 1, color(255, 255, 255));
+		render->filled_rect((multi_area.x + multi_area.w - 6) - 7, multi_area.y + ((multi_area.h / 2) - 3) + 2, 5, 1, theme::text);
+		render->filled_rect((multi_area.x + multi_area.w - 6) - 6, multi_area.y + ((multi_area.h / 2) - 3) + 3, 3, 1, theme::text);
+		render->filled_rect((multi_area.x + multi_area.w - 6) - 5, multi_area.y + ((multi_area.h / 2) - 3) + 4, 1, 1, theme::text);
 	}
 }
 
+void multi::hash_state(std::uint64_t& hash)
+{
+	for (const auto& item : this->list)
+		hash = hash_value(hash, *item.value);
+}
+
 void multi::think()
 {
+	PROFILE_ELEMENT("multi");
+
 	point control_position	= this->parent->draw_position() + this->position + point(125, 7);
 	rect multi_area			= { control_position.x, control_position.y, 180, 18 };
 	// add extra 20 height fixes last item in the dropdown not being registered.
@@ -1160,7 +1484,7 @@ void multi::think()
 	// open dropdown.
 	if (events->has_focus(this))
 	{
-		for (int i = 0; i < this->list.size(); i++)
+		for (int i = 0; i < int(this->list.size()); i++)
 		{
 			rect list_area	= { multi_area.x, multi_area.y + 20 + (multi_area.h * i), multi_area.w, multi_area.h };
 
@@ -1192,13 +1516,15 @@ keybind::keybind(group* parent, const char* title, bool* value, int* key_value,
 
 void keybind::draw()
 {
+	PROFILE_ELEMENT("keybind");
+
 	point control_position	= this->parent->draw_position() + this->position + point(125, this->inlined ? -25 : 0);
 	point keybind_area		= { control_position.x, control_position.y };
 	dimension text_size		= fonts->segoe_ui.text_size(this->get_title());
 
 	// title.
 	if (!this->inlined)
-		fonts->segoe_ui.text(keybind_area.x, keybind_area.y - (text_size.h / 2), this->get_title(), color(255, 255, 255));
+		fonts->segoe_ui.text(keybind_area.x, keybind_area.y - (text_size.h / 2), this->get_title(), theme::text);
 
 	// get our input key name from the key mapper.
 	std::string key = "[" + this->get_key_name(*this->key_value) + "]";
@@ -1208,7 +1534,7 @@ void keybind::draw()
 		key = "[...]";
 
 	// key value string.
-	fonts->segoe_ui.text(keybind_area.x + 190, keybind_area.y - (text_size.h / 2) - 1, key.c_str(), color(255, 255, 255));
+	fonts->segoe_ui.text(keybind_area.x + 190, keybind_area.y - (text_size.h / 2) - 1, key.c_str(), theme::text);
 
 	// key type dropdown.
 	if (events->has_focus(this) && this->type_list_opened)
@@ -1216,34 +1542,45 @@ void keybind::draw()
 		rect list_area		= { keybind_area.x + 195, keybind_area.y - (text_size.h / 2) + 7, 60, 80 };
 
 		// dropdown list background.
-		render->filled_rect(list_area.x, list_area.y, list_area.w, list_area.h, color(30, 30, 30));
+		render->filled_rect(list_area.x, list_area.y, list_area.w, list_area.h, theme::dropdown);
 
-		for (int i = 0; i < this->list.size(); i++)
+		for (int i = 0; i < int(this->list.size()); i++)
 		{
 			rect item_area	= { list_area.x, list_area.y + (20 * i), list_area.w, 20 };
 			bool in_bound	= input->in_bound(item_area);
 
 			// dropdown list background.
-			render->filled_rect(item_area.x, item_area.y, item_area.w, item_area.h, in_bound ? color(25, 25, 25) : color(30, 30, 30));
+			render->filled_rect(item_area.x, item_area.y, item_area.w, item_area.h, in_bound ? theme::control : theme::dropdown);
 
 			// selected -> white.
 			if (this->key_type == i || in_bound)
 			{
 				// item text.
-				fonts->segoe_ui.text(item_area.x + 8, item_area.y + 2, this->list[i], color(255, 255, 255));
+				fonts->segoe_ui.text(item_area.x + 8, item_area.y + 2, this->list[i], theme::text);
 			}
 			// not selected -> grey.
 			else
 			{
 				// item text.
-				fonts->segoe_ui.text(item_area.x + 8, item_area.y + 2, this->list[i], color(120, 120, 120));
+				fonts->segoe_ui.text(item_area.x + 8, item_area.y + 2, this->list[i], theme::text_unselected);
 			}
 		}
 	}
 }
 
+void keybind::hash_state(std::uint64_t& hash)
+{
+	hash = hash_value(hash, *this->value);
+	hash = hash_value(hash, *this->key_value);
+	hash = hash_value(hash, this->key_type);
+	hash = hash_value(hash, this->picking);
+	hash = hash_value(hash, this->type_list_opened);
+}
+
 void keybind::think()
 {
+	PROFILE_ELEMENT("keybind");
+
 	point control_position	= this->parent->draw_position() + this->position + point(125, this->inlined ? -25 : 0);
 	point keybind_area		= { control_position.x, control_position.y };
 	dimension text_size		= fonts->segoe_ui.text_size(this->get_title());
@@ -1284,7 +1621,7 @@ void keybind::think()
 	{
 		rect list_area		= { title_area.x + 5, title_area.y + 8, 60, 80 };
 
-		for (int i = 0; i < this->list.size(); i++)
+		for (int i = 0; i < int(this->list.size()); i++)
 		{
 			rect item_area	= { list_area.x, list_area.y + (20 * i), list_area.w, 20 };
 
@@ -1382,17 +1719,25 @@ color_picker::color_picker(group* parent, const char* title, color default_value
 	this->inlined			= inlined;
 	this->distance			= { 0, this->inlined ? -19 : 0 };
 	this->parent			= parent;
+
+	// start the selectors on the color we write into value, instead of wherever they happen to be.
+	color::rgb_to_hsv(this->preview_default, this->hue, this->saturation, this->color_value);
+	this->alpha				= this->preview_default.a / 255.f;
+
+	this->reset();
 }
 
 void color_picker::draw()
 {
+	PROFILE_ELEMENT("color_picker");
+
 	point control_position	= this->parent->draw_position() + this->position + point(125, this->inlined ? -25 : 0);
 	rect picker_area		= { control_position.x, control_position.y, 20, 9 };
 	dimension text_size		= fonts->segoe_ui.text_size(this->get_title());
 
 	// title.
 	if (!this->inlined)
-		fonts->segoe_ui.text(picker_area.x, picker_area.y - (text_size.h / 2), this->get_title(), color(255, 255, 255));
+		fonts->segoe_ui.text(picker_area.x, picker_area.y - (text_size.h / 2), this->get_title(), theme::text);
 
 	// update preview opacity.
 	color preview = this->preview_default;
@@ -1401,16 +1746,16 @@ void color_picker::draw()
 	rect preview_area = { picker_area.x + picker_area.w + 170, picker_area.y - (text_size.h / 2) + 4, picker_area.w, picker_area.h };
 
 	// background.
-	render->filled_rect(preview_area.x, preview_area.y, preview_area.w, preview_area.h, color(30, 30, 30));
+	render->filled_rect(preview_area.x, preview_area.y, preview_area.w, preview_area.h, theme::dropdown);
 
 	// picker preview color.
 	render->filled_rect(preview_area.x, preview_area.y, preview_area.w, preview_area.h, preview);
 
 	// shadows.
-	render->gradient(preview_area.x, preview_area.y, preview_area.w, preview_area.h, color(50, 50, 35, 0), color(50, 50, 35, 150), gradient_direction::vertical);
+	render->gradient(preview_area.x, preview_area.y, preview_area.w, preview_area.h, theme::preview_shadow.alpha(0), theme::preview_shadow, gradient_direction::vertical);
 
 	// outline.
-	render->outlined_rect(preview_area.x, preview_area.y, preview_area.w + 1, preview_area.h, color(35, 35, 35));
+	render->outlined_rect(preview_area.x, preview_area.y, preview_area.w + 1, preview_area.h, theme::outline);
 
 	// open color picker.
 	if (events->has_focus(this))
@@ -1421,41 +1766,47 @@ void color_picker::draw()
 		this->update();
 
 		// background.
-		render->filled_rect(inner_area.x, inner_area.y + 5, inner_area.w + 25, inner_area.h + 25, color(30, 30, 30));
+		render->filled_rect(inner_area.x, inner_area.y + 5, inner_area.w + 25, inner_area.h + 25, theme::dropdown);
 
 		// outline.
-		render->outlined_rect(inner_area.x, inner_area.y + 5, inner_area.w + 25, inner_area.h + 25, color(35, 35, 35));
+		render->outlined_rect(inner_area.x, inner_area.y + 5, inner_area.w + 25, inner_area.h + 25, theme::outline);
 
-		// picker palette.
-		for (int i = 0; i < 150; i++)
-			render->gradient(inner_area.x + 5 + i, inner_area.y + 10, 1, inner_area.h, this->gradient[i].rgba(), this->gradient[i].set(0, 0, 0), gradient_direction::vertical);
+		// picker palette, saturation runs left to right along the top row and value fades to black downwards.
+		// both are linear in screen space, so one horizontal quad with a black vertical overlay gives the same square.
+		render->gradient(inner_area.x + 5, inner_area.y + 10, inner_area.w, inner_area.h, color::from_argb(this->palette[0]), color::from_argb(this->palette[1]), gradient_direction::horizontal);
+		render->gradient(inner_area.x + 5, inner_area.y + 10, inner_area.w, inner_area.h, color(0, 0, 0, 0), color(0, 0, 0), gradient_direction::vertical);
 
 		// picker palette outline.
-		render->outlined_rect(inner_area.x + 5, inner_area.y + 10, inner_area.w, inner_area.h, color(35, 35, 35));
+		render->outlined_rect(inner_area.x + 5, inner_area.y + 10, inner_area.w, inner_area.h, theme::outline);
 
 		// color selector dot.
 		float s		= this->saturation * (inner_area.w - 4);
 		float v		= (1.f - this->color_value) * (inner_area.h - 4);
 
-		render->filled_rect(inner_area.x + 5 + s, inner_area.y + 10 + v, 4, 4, color(255, 255, 255));
+		render->filled_rect(inner_area.x + 5 + s, inner_area.y + 10 + v, 4, 4, theme::text);
 
 		// color selector dot outline.
-		render->outlined_rect(inner_area.x + 5 + s, inner_area.y + 10 + v, 4, 4, color(10, 10, 10));
+		render->outlined_rect(inner_area.x + 5 + s, inner_area.y + 10 + v, 4, 4, theme::marker_outline);
 
-		// hue bar.
-		for (int i = 0; i < 150; i++)
-			render->filled_rect(inner_area.x + inner_area.w + 10, inner_area.y + 10 + i, 10, 1, color::hsv_to_rgb(i / 150.f, 1.f, 1.f));
+		// hue bar, hue is piecewise linear in rgb between the six primaries and secondaries.
+		for (int i = 0; i < 6; i++)
+		{
+			int top		= inner_area.h * i / 6;
+			int bottom	= inner_area.h * (i + 1) / 6;
+
+			render->gradient(inner_area.x + inner_area.w + 10, inner_area.y + 10 + top, 10, bottom - top, color::hsv_to_rgb(i / 6.f, 1.f, 1.f), color::hsv_to_rgb((i + 1) / 6.f, 1.f, 1.f), gradient_direction::vertical);
+		}
 		
 		// hue bar outline.
-		render->outlined_rect(inner_area.x + inner_area.w + 10, inner_area.y + 10, 11, inner_area.h, color(35, 35, 35));
+		render->outlined_rect(inner_area.x + inner_area.w + 10, inner_area.y + 10, 11, inner_area.h, theme::outline);
 
 		// hue bar slider -> optional.
 		float h		= this->hue * (inner_area.h - 3);
 
-		render->filled_rect(inner_area.x + inner_area.w + 10, inner_area.y + 10 + h, 11, 3, color(255, 255, 255, 0));
+		render->filled_rect(inner_area.x + inner_area.w + 10, inner_area.y + 10 + h, 11, 3, theme::text.alpha(0));
 
 		// hue bar slider outline.
-		render->outlined_rect(inner_area.x + inner_area.w + 10, inner_area.y + 10 + h, 11, 3, color(10, 10, 10));
+		render->outlined_rect(inner_area.x + inner_area.w + 10, inner_area.y + 10 + h, 11, 3, theme::marker_outline);
 
 		// update alpha opacity.
 		this->alpha = preview.a / 255.f;
@@ -1464,20 +1815,35 @@ void color_picker::draw()
 		render->filled_rect(inner_area.x + 5, inner_area.y + inner_area.h + 15, inner_area.w, 10, preview);
 
 		// alpha bar outline.
-		render->outlined_rect(inner_area.x + 5, inner_area.y + inner_area.h + 15, inner_area.w, 11, color(35, 35, 35));
+		render->outlined_rect(inner_area.x + 5, inner_area.y + inner_area.h + 15, inner_area.w, 11, theme::outline);
 
 		// alpha bar slider -> optional.
 		float a		= this->alpha * (inner_area.w - 3);
 
-		render->filled_rect(inner_area.x + 5 + a, inner_area.y + inner_area.h + 15, 3, 11, color(255, 255, 255, 0));
+		render->filled_rect(inner_area.x + 5 + a, inner_area.y + inner_area.h + 15, 3, 11, theme::text.alpha(0));
 
 		// alpha bar slider outline.
-		render->outlined_rect(inner_area.x + 5 + a, inner_area.y + inner_area.h + 15, 3, 11, color(10, 10, 10));
+		render->outlined_rect(inner_area.x + 5 + a, inner_area.y + inner_area.h + 15, 3, 11, theme::marker_outline);
 	}
 }
 
+void color_picker::hash_state(std::uint64_t& hash)
+{
+	hash = hash_value(hash, *this->value);
+	hash = hash_value(hash, this->preview_default);
+	hash = hash_value(hash, this->hue);
+	hash = hash_value(hash, this->saturation);
+	hash = hash_value(hash, this->color_value);
+	hash = hash_value(hash, this->alpha);
+	hash = hash_value(hash, this->alpha_drag);
+	hash = hash_value(hash, this->hue_drag);
+	hash = hash_value(hash, this->color_drag);
+}
+
 void color_picker::think()
 {
+	PROFILE_ELEMENT("color_picker");
+
 	point control_position	= this->parent->draw_position() + this->position + point(125, this->inlined ? -25 : 0);
 	rect picker_area		= { control_position.x, control_position.y, 20, 9 };
 	dimension text_size		= fonts->segoe_ui.text_size(this->get_title());
@@ -1554,7 +1920,7 @@ void color_picker::think()
 		{
 			// set updated colors.
 			this->preview_default	= color::hsv_to_rgb(this->hue, this->saturation, this->color_value);
-			this->preview_default.a	= (this->alpha * 255.f);
+			this->preview_default.a	= std::uint8_t(this->alpha * 255.f);
 		}
 	}
 
@@ -1567,21 +1933,127 @@ void color_picker::update()
 {
 	const dimension picker_size = { 150, 150 };
 
-	// allocate gradient.
-	if (this->gradient.empty())
-		this->gradient = std::vector<color>(picker_size.w * picker_size.h);
+	// the palette only depends on hue, nothing to do while it stays put.
+	if (this->hue == this->palette_hue)
+		return;
+
+	this->palette_hue = this->hue;
+
+	// top row at full value, leftmost and rightmost saturation columns.
+	this->palette[0] = color::hsv_to_rgb(this->hue, 0.f, 1.f).argb();
+	this->palette[1] = color::hsv_to_rgb(this->hue, (picker_size.w - 1) / float(picker_size.w), 1.f).argb();
+}
+
+perf_hud::perf_hud(group* parent, const char* title)
+{
+	this->title		= title;
+	this->size		= { graph_width, graph_height + 30 };
+	this->distance	= { 0, 9 };
+	this->parent	= parent;
+
+	this->graph.fill(-1.f);
+}
 
-	// iterate width.
-	for (int x = 0; x < picker_size.w; x++)
+void perf_hud::draw()
+{
+	PROFILE_ELEMENT("perf_hud");
+
+	point control_position	= this->parent->draw_position() + this->position + point(125, 7);
+	rect graph_area			= { control_position.x, control_position.y, graph_width, graph_height };
+
+	// title.
+	dimension text_size		= fonts->segoe_ui.text_size(this->get_title());
+	fonts->segoe_ui.text(graph_area.x, (graph_area.y - 2) - (text_size.h - 2), this->get_title(), theme::text);
+
+	// graph background.
+	render->filled_rect(graph_area.x, graph_area.y, graph_area.w, graph_area.h, theme::control);
+
+	// 60 fps budget line.
+	const float budget = 1000.f / 60.f;
+
+	if (budget < this->scale)
 	{
-		// iterate height.
-		for (int y = 0; y < picker_size.h; y++)
-		{
-			float saturation	= y / float(picker_size.h);
-			float value			= 1.f - (x / float(picker_size.w));
+		const int budget_y = graph_area.y + graph_area.h - int(budget / this->scale * graph_area.h);
+		render->line(graph_area.x, budget_y, graph_area.x + graph_area.w, budget_y, theme::outline);
+	}
 
-			// write back to array.
-			this->gradient[x * picker_size.w + y] = color::hsv_to_rgb(this->hue, saturation, value);
-		}
+	// frame times, the whole graph goes out as one polyline.
+	this->points.clear();
+
+	for (int i = 0; i < columns; i++)
+	{
+		if (this->graph[i] < 0.f)
+			continue;
+
+		const float height = std::min<float>(this->graph[i] / this->scale, 1.f) * (graph_area.h - 2);
+		this->points.push_back({ graph_area.x + i * 2.f + 1.f, graph_area.y + graph_area.h - 1.f - height });
 	}
+
+	if (this->points.size() > 1)
+		render->polyline(this->points, 1.f, theme::accent_blue);
+
+	// graph outline.
+	render->outlined_rect(graph_area.x, graph_area.y, graph_area.w + 1, graph_area.h + 1, theme::outline);
+
+	// numbers.
+	std::string times	= translate->format("p50 %.2f ms  p99 %.2f ms  max %.2f ms", this->p50, this->p99, this->peak);
+	std::string counts	= translate->format("%u draws  %u glyphs  %u allocs per frame", this->average.draw_calls, this->average.glyphs, this->average.allocations);
+
+	fonts->segoe_ui.text(graph_area.x, graph_area.y + graph_area.h + 3, times.c_str(), theme::text);
+	fonts->segoe_ui.text(graph_area.x, graph_area.y + graph_area.h + 16, counts.c_str(), theme::text_unselected);
+}
+
+void perf_hud::hash_state(std::uint64_t& hash)
+{
+	hash = hash_value(hash, this->version);
+}
+
+void perf_hud::think()
+{
+	PROFILE_ELEMENT("perf_hud");
+
+	// the hud takes no input, so this runs every frame and the next draw sees the new snapshot.
+	this->refresh();
+}
+
+void perf_hud::refresh()
+{
+	const auto now = std::chrono::steady_clock::now();
+	const environment_stats& history = render->stats_history();
+
+	// nothing new to show until a frame ends, which also keeps headless replays that never end one
+	// independent of the clock.
+	if (this->version && (history.frame_count() == this->refreshed_frame || now - this->refreshed < std::chrono::milliseconds(refresh_interval)))
+		return;
+
+	this->refreshed			= now;
+	this->refreshed_frame	= history.frame_count();
+	this->version++;
+
+	const std::size_t frames = history.frames();
+
+	// decimate: each column shows the worst frame of its slice of the history, so spikes survive.
+	const std::size_t length = environment_stats::history_length;
+	float worst = 0.f;
+
+	for (int i = 0; i < columns; i++)
+	{
+		const std::size_t first	= std::size_t(columns - 1 - i) * length / columns;
+		const std::size_t last	= std::size_t(columns - i) * length / columns;
+
+		float column = -1.f;
+
+		for (std::size_t age = first; age < last && age < frames; age++)
+			column = std::max<float>(column, history.history(age).frame_time);
+
+		this->graph[i] = column;
+		worst = std::max<float>(worst, column);
+	}
+
+	// the top of the graph snaps to whole milliseconds so it doesn't twitch with every refresh.
+	this->peak		= worst;
+	this->scale		= std::max<float>(std::ceil(worst), 1.f);
+	this->p50		= history.frame_time_percentile(0.5f);
+	this->p99		= history.frame_time_percentile(0.99f);
+	this->average	= history.average();
 }
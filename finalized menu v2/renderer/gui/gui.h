@@ -3,11 +3,16 @@
 #include "../other/maths.h"
 #include "../other/translate.h"
 #include "../other/color.h"
+#include "../other/hash.h"
+#include "theme.h"
+#include <array>
+#include <chrono>
 
 #define max_key_state 255
 
 namespace gui
 {
+	class input_log;
 	class gui_input
 	{
 	public:
@@ -25,11 +30,24 @@ namespace gui
 		void set_mouse_wheel(int mouse_wheel);
 		int get_mouse_wheel();
 
+		// while scripted, poll_input reads the keys set through script_key instead of the keyboard and the
+		// mouse is only moved by whoever drives the script. lets the gui run headless.
+		void set_scripted(bool enabled);
+		void script_key(const int key, bool down);
+
+		// every poll_input is appended to the log until this is called with nullptr.
+		void set_recorder(input_log* log);
+
 	private:
 		HWND	handle = nullptr;
-		bool	key_state[max_key_state];
-		bool	old_key_state[max_key_state];
+		bool	key_state[max_key_state]		= { };
+		bool	old_key_state[max_key_state]	= { };
 		int		mouse_wheel = 0;
+
+		bool	scripted = false;
+		bool	script_state[max_key_state] = { };
+
+		input_log*	recorder = nullptr;
 	};
 	extern gui_input* input;
 
@@ -50,7 +68,7 @@ namespace gui
 
 	private:
 		bool		opened = true;
-		int			key;
+		int			key = 0;
 		element*	selected = nullptr;
 	};
 	extern gui_event* events;
@@ -58,6 +76,9 @@ namespace gui
 	class element
 	{
 	public:
+		// parents delete their children through element pointers.
+		virtual ~element() { }
+
 		virtual void draw()		= 0;
 		virtual void think()	= 0;
 
@@ -99,8 +120,36 @@ namespace gui
 			return this->parent->draw_position() + this->position;
 		}
 
+		// an element that takes no input thinks every frame its group does, wherever the mouse is.
+		virtual bool takes_input()
+		{
+			return true;
+		}
+
+		// title of the window this element sits in.
+		const char* window_title()
+		{
+			element* top = this;
+
+			while (top->parent)
+				top = top->parent;
+
+			return top->title;
+		}
+
+		// folds everything draw() reads, besides hover, into the hash. a window only re-records its draw list
+		// when the hash changes, so an element whose look depends on more than its children must override this.
+		virtual void hash_state(std::uint64_t& hash)
+		{
+			for (const auto& handle : this->elements)
+			{
+				if (handle)
+					handle->hash_state(hash);
+			}
+		}
+
 	protected:
-		const char*				title;
+		const char*				title = nullptr;
 		point					position;
 		point					offset;
 		dimension				size;
@@ -120,6 +169,13 @@ namespace gui
 		void think();
 		void add(window* handle);
 
+		// drops every window's draw list, for changes hash_state can't see.
+		void invalidate();
+
+		// positions, selections, focus and every bound value. unlike hash_state it doesn't depend on where
+		// anything sits in memory, so runs of the same input in different processes and builds compare.
+		std::uint64_t state_hash();
+
 	private:
 		float					current_time = -1.f;
 		std::vector<window*>	windows;
@@ -139,20 +195,47 @@ namespace gui
 		void draw()				override;
 		void think()			override;
 		point draw_position()	override { return this->position; }
+		void hash_state(std::uint64_t& hash) override;
 
 		void add(tab* handle);
 		void set_default_tab(tab* handle);
 
+		// forces the next draw to record again, call it after changing a bound value from outside the gui.
+		void invalidate() { this->cache_valid = false; }
+
+		// while another window is on top, keep this one in a render target and draw it as a single quad.
+		// the texture is only redrawn when the draw list is, and counts against render's surface budget.
+		// it holds premultiplied color, so translucent widgets composite the same as drawn directly.
+		void set_offscreen(bool enabled);
+
+	private:
+		// records everything the window draws, draw() replays it.
+		void draw_contents();
+
+		// composites the window from its surface, false when it has to be drawn directly instead.
+		bool draw_offscreen();
+
 	private:
 		std::vector<tab*>		tabs;
 		tab*					tab_selected = nullptr;
 		float					last_input_time = 0.f;
+
+		// last recorded draw list and what it was recorded from.
+		draw_list				cache;
+		point					cache_origin;
+		std::uint64_t			cache_state = 0;
+		bool					cache_valid = false;
+
+		render_surface			surface;
+		bool					offscreen = false;
+		bool					topmost = false;
 	};
 
 	class column;
 	class sub_tab;
 	class tab : public element
 	{
+		friend gui_instance;
 	public:
 		tab(const char* title, window* parent, bool has_sub = false);
 		~tab();
@@ -160,6 +243,7 @@ namespace gui
 		void draw()				override;
 		void think()			override;
 		point draw_position()	override { return this->parent->draw_position(); }
+		void hash_state(std::uint64_t& hash) override;
 
 		void add(column* handle);
 		void add(sub_tab* handle);
@@ -199,7 +283,7 @@ namespace gui
 		void add(group* handle);
 
 	private:
-		bool	in_sub;
+		bool	in_sub = false;
 	};
 
 	class group : public element
@@ -211,11 +295,12 @@ namespace gui
 		void draw()				override;
 		void think()			override;
 		point draw_position()	override { return this->parent->draw_position() + this->position + point(20, 20 + this->scroll); }
+		void hash_state(std::uint64_t& hash) override;
 
 		void add(element* handle);
 
 	private:
-		float	scroll;
+		float	scroll = 0.f;
 	};
 
 	class checkbox : public element
@@ -225,6 +310,7 @@ namespace gui
 
 		void draw()					override;
 		void think()				override;
+		void hash_state(std::uint64_t& hash) override;
 
 	private:
 		bool* value;
@@ -237,6 +323,7 @@ namespace gui
 
 		void draw()					override;
 		void think()				override;
+		void hash_state(std::uint64_t& hash) override;
 
 	private:
 		int*			value;
@@ -252,6 +339,7 @@ namespace gui
 
 		void draw()					override;
 		void think()				override;
+		void hash_state(std::uint64_t& hash) override;
 
 	private:
 		float*			value;
@@ -267,6 +355,7 @@ namespace gui
 
 		void draw()					override;
 		void think()				override;
+		void hash_state(std::uint64_t& hash) override;
 
 	private:
 		std::vector<const char*>	list;
@@ -286,18 +375,24 @@ namespace gui
 
 		void draw()					override;
 		void think()				override;
+		void hash_state(std::uint64_t& hash) override;
 
 		void add(const char* title, bool* value);
 
+		// what the closed box shows: the selected titles, cut short with dots, or a dash.
+		std::string label() { return this->construct_list(this->list); }
+
 	private:
 		std::vector<multi_info> list;
 
 		std::string construct_list(const std::vector<multi_info> list)
 		{
+			memory_scope memory(memory_tag::strings);
+
 			// store our final result data.
 			std::string result;
 
-			for (int i = 0; i < list.size(); i++)
+			for (int i = 0; i < int(list.size()); i++)
 			{
 				// does our multibox have more than 20 characters inside it.
 				bool length_exceeded = result.length() >= 20;
@@ -344,6 +439,7 @@ namespace gui
 
 		void draw()					override;
 		void think()				override;
+		void hash_state(std::uint64_t& hash) override;
 
 	private:
 		bool*	value;
@@ -409,6 +505,7 @@ namespace gui
 
 		void draw()					override;
 		void think()				override;
+		void hash_state(std::uint64_t& hash) override;
 
 	private:
 		color				preview_default;
@@ -424,7 +521,9 @@ namespace gui
 		bool				color_drag;
 		bool				inlined;
 
-		std::vector<color>	gradient;
+		// packed argb ends of the palette's top row, the only colors draw samples from it.
+		std::uint32_t		palette[2]		= { };
+		float				palette_hue		= -1.f;
 
 		void reset()
 		{
@@ -435,4 +534,39 @@ namespace gui
 
 		void update();
 	};
+
+	// frame time graph, p50 / p99 frame times, draw calls and allocations per frame, read from the render
+	// statistics history. the snapshot is rebuilt at most every refresh_interval, in between the window
+	// replays its cached draw list, so the hud costs next to nothing.
+	class perf_hud : public element
+	{
+	public:
+		perf_hud(group* parent, const char* title);
+
+		void draw()					override;
+		void think()				override;
+		bool takes_input()			override { return false; }
+		void hash_state(std::uint64_t& hash) override;
+
+	private:
+		static constexpr int	graph_width			= 180;
+		static constexpr int	graph_height		= 40;
+		static constexpr int	columns				= graph_width / 2;
+		static constexpr int	refresh_interval	= 100;	// milliseconds.
+
+		void refresh();
+
+		std::chrono::steady_clock::time_point	refreshed;
+		std::uint64_t							refreshed_frame	= 0;	// statistics frame count at the last refresh.
+		std::uint64_t							version		= 0;
+
+		// worst frame time per column, oldest on the left. negative where the history has no frames yet.
+		std::array<float, columns>				graph;
+		float									scale		= 0.f;	// frame time at the top of the graph.
+		float									p50			= 0.f;
+		float									p99			= 0.f;
+		float									peak		= 0.f;
+		render_stats							average;
+		std::vector<vector_2d>					points;
+	};
 }
@@ -0,0 +1,263 @@
+#include "input_log.h"
+#include <cstdio>
+
+using namespace gui;
+
+// file layout: magic, version, then one record per frame until the end of the data.
+//   varint		time since the previous frame, microseconds.
+//   byte		flags, see below.
+//   2 varints	mouse movement since the previous frame, zigzag encoded.	(input_moved)
+//   varint		wheel, zigzag encoded.										(input_wheel)
+//   varint		count, then that many key codes that changed state.			(input_keys)
+static const std::uint8_t input_magic[4] = { 'g', 'i', 'l', 'g' };
+static constexpr std::uint8_t input_version = 1;
+
+enum input_flags : std::uint8_t
+{
+	input_moved	= 1 << 0,
+	input_wheel	= 1 << 1,
+	input_keys	= 1 << 2
+};
+
+static void write_varint(std::vector<std::uint8_t>& data, std::uint64_t value)
+{
+	for (; value >= 0x80; value >>= 7)
+		data.push_back(std::uint8_t(value | 0x80));
+
+	data.push_back(std::uint8_t(value));
+}
+
+static void write_signed(std::vector<std::uint8_t>& data, std::int64_t value)
+{
+	write_varint(data, (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63));
+}
+
+// reads walk a cursor through the data and fail instead of running off its end.
+static bool read_varint(const std::vector<std::uint8_t>& data, std::size_t& at, std::uint64_t& value)
+{
+	value = 0;
+
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (at >= data.size())
+			return false;
+
+		const std::uint8_t byte = data[at++];
+		value |= std::uint64_t(byte & 0x7f) << shift;
+
+		if (!(byte & 0x80))
+			return true;
+	}
+
+	return false;
+}
+
+static bool read_signed(const std::vector<std::uint8_t>& data, std::size_t& at, std::int64_t& value)
+{
+	std::uint64_t raw;
+
+	if (!read_varint(data, at, raw))
+		return false;
+
+	value = std::int64_t(raw >> 1) ^ -std::int64_t(raw & 1);
+	return true;
+}
+
+void input_log::clear()
+{
+	this->recorded.clear();
+	this->keys.clear();
+	std::memset(this->held, 0, sizeof(this->held));
+	this->started = std::chrono::steady_clock::now();
+
+	this->rewind();
+}
+
+void input_log::record(const point& mouse, int wheel, const bool* keys)
+{
+	input_frame frame;
+	frame.time		= std::uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->started).count());
+	frame.mouse		= mouse;
+	frame.wheel		= wheel;
+	frame.first_key	= std::uint32_t(this->keys.size());
+
+	// only transitions are kept, a held key costs nothing after the frame it went down.
+	for (int i = 0; i < max_key_state; i++)
+	{
+		if (keys[i] == this->held[i])
+			continue;
+
+		this->held[i] = keys[i];
+		this->keys.push_back(std::uint8_t(i));
+	}
+
+	frame.key_count = std::uint32_t(this->keys.size()) - frame.first_key;
+	this->recorded.push_back(frame);
+}
+
+std::vector<std::uint8_t> input_log::encode() const
+{
+	std::vector<std::uint8_t> data(input_magic, input_magic + sizeof(input_magic));
+	data.push_back(input_version);
+
+	input_frame previous;
+
+	for (const auto& frame : this->recorded)
+	{
+		std::uint8_t flags = 0;
+
+		if (frame.mouse != previous.mouse)
+			flags |= input_moved;
+
+		if (frame.wheel)
+			flags |= input_wheel;
+
+		if (frame.key_count)
+			flags |= input_keys;
+
+		write_varint(data, frame.time - previous.time);
+		data.push_back(flags);
+
+		if (flags & input_moved)
+		{
+			write_signed(data, std::int64_t(frame.mouse.x) - previous.mouse.x);
+			write_signed(data, std::int64_t(frame.mouse.y) - previous.mouse.y);
+		}
+
+		if (flags & input_wheel)
+			write_signed(data, frame.wheel);
+
+		if (flags & input_keys)
+		{
+			write_varint(data, frame.key_count);
+			data.insert(data.end(), this->keys.begin() + frame.first_key, this->keys.begin() + frame.first_key + frame.key_count);
+		}
+
+		previous = frame;
+	}
+
+	return data;
+}
+
+bool input_log::decode(const std::vector<std::uint8_t>& data)
+{
+	std::vector<input_frame> frames;
+	std::vector<std::uint8_t> toggled;
+
+	if (data.size() < sizeof(input_magic) + 1 || std::memcmp(data.data(), input_magic, sizeof(input_magic)) || data[sizeof(input_magic)] != input_version)
+		return false;
+
+	std::size_t at = sizeof(input_magic) + 1;
+	input_frame previous;
+
+	while (at < data.size())
+	{
+		input_frame frame = previous;
+		std::uint64_t delta, count;
+		std::int64_t x = 0, y = 0, wheel = 0;
+
+		if (!read_varint(data, at, delta) || at >= data.size())
+			return false;
+
+		const std::uint8_t flags = data[at++];
+
+		if ((flags & input_moved) && (!read_signed(data, at, x) || !read_signed(data, at, y)))
+			return false;
+
+		if ((flags & input_wheel) && !read_signed(data, at, wheel))
+			return false;
+
+		frame.time		= previous.time + delta;
+		frame.mouse		= { int(previous.mouse.x + x), int(previous.mouse.y + y) };
+		frame.wheel		= int(wheel);
+		frame.first_key	= std::uint32_t(toggled.size());
+		frame.key_count	= 0;
+
+		if (flags & input_keys)
+		{
+			if (!read_varint(data, at, count) || count > data.size() - at)
+				return false;
+
+			for (std::uint64_t i = 0; i < count; i++)
+			{
+				if (data[at] >= max_key_state)
+					return false;
+
+				toggled.push_back(data[at++]);
+			}
+
+			frame.key_count = std::uint32_t(count);
+		}
+
+		frames.push_back(frame);
+		previous = frame;
+	}
+
+	this->recorded	= std::move(frames);
+	this->keys		= std::move(toggled);
+
+	// recording on after a load carries on from where the log left the keys.
+	std::memset(this->held, 0, sizeof(this->held));
+
+	for (const std::uint8_t key : this->keys)
+		this->held[key] = !this->held[key];
+
+	this->rewind();
+	return true;
+}
+
+bool input_log::save(const char* path) const
+{
+	std::FILE* file = std::fopen(path, "wb");
+
+	if (!file)
+		return false;
+
+	const std::vector<std::uint8_t> data = this->encode();
+	const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+
+	return std::fclose(file) == 0 && written;
+}
+
+bool input_log::load(const char* path)
+{
+	std::FILE* file = std::fopen(path, "rb");
+
+	if (!file)
+		return false;
+
+	std::vector<std::uint8_t> data;
+	std::uint8_t buffer[4096];
+	std::size_t read = 0;
+
+	while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+		data.insert(data.end(), buffer, buffer + read);
+
+	std::fclose(file);
+	return this->decode(data);
+}
+
+void input_log::rewind()
+{
+	this->cursor = 0;
+	std::memset(this->replay_held, 0, sizeof(this->replay_held));
+}
+
+bool input_log::replay(gui_input* target)
+{
+	if (this->cursor >= this->recorded.size())
+		return false;
+
+	const input_frame& frame = this->recorded[this->cursor++];
+	const std::uint8_t* changed = this->toggled(frame);
+
+	for (std::uint32_t i = 0; i < frame.key_count; i++)
+	{
+		this->replay_held[changed[i]] = !this->replay_held[changed[i]];
+		target->script_key(changed[i], this->replay_held[changed[i]]);
+	}
+
+	target->mouse = frame.mouse;
+	target->set_mouse_wheel(frame.wheel);
+	return true;
+}
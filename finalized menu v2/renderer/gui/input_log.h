@@ -0,0 +1,63 @@
+#pragma once
+#include "gui.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/*
+* input recording and replay.
+* while a log is attached to gui_input, every poll_input appends what the gui is about to read that frame:
+* a timestamp, the mouse, the wheel and the keys that changed since the previous frame. the log packs into
+* a compact binary (varint deltas, a few bytes per frame) and replays through the scripted input, so a
+* session recorded on the desktop can be run headless, as fast as the gui can think and draw it.
+*/
+
+namespace gui
+{
+	// one polled frame, the keys that changed are in the log's key list.
+	struct input_frame
+	{
+		std::uint64_t	time		= 0;	// microseconds since recording started.
+		point			mouse;
+		int				wheel		= 0;
+		std::uint32_t	first_key	= 0;
+		std::uint32_t	key_count	= 0;
+	};
+
+	class input_log
+	{
+	public:
+		// drops what was recorded and starts the clock again.
+		void clear();
+
+		// called by gui_input::poll_input with the state it just polled.
+		void record(const point& mouse, int wheel, const bool* keys);
+
+		std::size_t frames() const { return this->recorded.size(); }
+		const input_frame& frame(std::size_t index) const { return this->recorded[index]; }
+
+		// the key codes that changed state on the given frame.
+		const std::uint8_t* toggled(const input_frame& frame) const { return this->keys.data() + frame.first_key; }
+
+		std::vector<std::uint8_t> encode() const;
+		bool decode(const std::vector<std::uint8_t>& data);
+
+		bool save(const char* path) const;
+		bool load(const char* path);
+
+		// replay starts over from the first frame with every key up.
+		void rewind();
+
+		// sets up the next frame on a scripted input, false once every frame was replayed.
+		bool replay(gui_input* target);
+
+	private:
+		std::vector<input_frame>				recorded;
+		std::vector<std::uint8_t>				keys;
+		bool									held[max_key_state] = { };	// key state after the last recorded frame.
+		std::chrono::steady_clock::time_point	started = std::chrono::steady_clock::now();
+
+		std::size_t								cursor = 0;
+		bool									replay_held[max_key_state] = { };
+	};
+}
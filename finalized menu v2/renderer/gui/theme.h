@@ -0,0 +1,31 @@
+#pragma once
+#include "../other/color.h"
+
+// menu palette, constexpr so every draw call gets its colour folded in at compile time.
+namespace theme
+{
+	// text.
+	constexpr color text				= color(255, 255, 255);
+	constexpr color text_inactive		= color(92, 92, 92);		// tabs that are not selected.
+	constexpr color text_unselected		= color(120, 120, 120);		// dropdown items that are not selected.
+
+	// backgrounds, darkest to lightest.
+	constexpr color marker_outline		= color(10, 10, 10);		// colour picker selectors.
+	constexpr color panel				= color(12, 12, 12);		// tabs bar and group boxes.
+	constexpr color window				= color(20, 20, 20);
+	constexpr color control				= color(25, 25, 25);		// checkboxes, sliders, hovered list items.
+	constexpr color dropdown			= color(30, 30, 30);
+	constexpr color dropdown_hovered	= color(34, 34, 34);
+	constexpr color outline				= color(35, 35, 35);
+	constexpr color device_clear		= color(40, 40, 40);
+	constexpr color scroll_bar			= color(45, 45, 45);
+	constexpr color preview_shadow		= color(50, 50, 35, 150);
+
+	// skeet rgb line, top row and the darker row below it.
+	constexpr color accent_blue			= color(99, 160, 200);
+	constexpr color accent_purple		= color(179, 102, 181);
+	constexpr color accent_yellow		= color(230, 217, 100);
+	constexpr color accent_blue_dark	= color(49, 79, 99);
+	constexpr color accent_purple_dark	= color(89, 50, 90);
+	constexpr color accent_yellow_dark	= color(114, 108, 49);
+}
@@ -1,10 +1,13 @@
 #pragma once
 #include <Windows.h>
 #include <d3d9.h>
-#pragma comment(lib, "d3d9.lib")
-
 #include <d3dx9.h>
+
+// the vcxproj links through these, cmake links the libraries itself.
+#ifdef _MSC_VER
+#pragma comment(lib, "d3d9.lib")
 #pragma comment(lib, "d3dx9.lib")
+#endif
 
 // include window handle.
 #include "window/window.h"
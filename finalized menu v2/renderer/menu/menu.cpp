@@ -20,8 +20,23 @@ void environment_menu::draw_test()
 
 void environment_menu::setup()
 {
+	// start from the same values every time, replayed input depends on it.
+	t_check				= false;
+	t_slider_int		= 0;
+	t_slider_float		= 0.f;
+	t_combo				= 0;
+	t_key				= false;
+	t_key_value			= -1;
+	t_color_picker		= color();
+
+	for (auto& value : t_multi)
+		value = false;
+
 	events->set_key(VK_INSERT);
 
+	// the windows and everything under them, built with the tree's containers, count as the widget tree.
+	memory_scope memory(memory_tag::widget_tree);
+
 	auto main = new gui::window("main", { 100, 100 }, { 700, 600 });
 	{
 		auto tab_2 = new tab("B", main, true);
@@ -48,7 +63,7 @@ void environment_menu::setup()
 				{
 					auto group_3 = new group("group 3", { 270, 230 }, right);
 					{
-
+						group_3->add(new perf_hud(group_3, "performance"));
 					}
 					right->add(group_3);
 
@@ -79,6 +94,9 @@ void environment_menu::setup()
 		main->add(tab_2);
 
 		main->set_default_tab(tab_2);
+
+		// drawn from a texture while the other window is on top.
+		main->set_offscreen(true);
 	}
 	instance->add(main);
 
@@ -138,6 +156,9 @@ void environment_menu::setup()
 		other->add(tab_1);
 
 		other->set_default_tab(tab_1);
+
+		// drawn from a texture while the other window is on top.
+		other->set_offscreen(true);
 	}
 	instance->add(other);
 }
\ No newline at end of file
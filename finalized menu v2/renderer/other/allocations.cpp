@@ -0,0 +1,216 @@
+#include "allocations.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<std::uint64_t> allocations{ 0 };
+
+std::uint64_t allocation_count()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+const char* memory_tag_name(memory_tag tag)
+{
+	switch (tag)
+	{
+	case memory_tag::untagged:			return "untagged";
+	case memory_tag::render_vertices:	return "render vertices";
+	case memory_tag::font:				return "font";
+	case memory_tag::widget_tree:		return "widget tree";
+	case memory_tag::strings:			return "strings";
+	default:							return "unknown";
+	}
+}
+
+#ifdef MEMORY_TRACKING
+// what a tag has outstanding, the last slot holds the total.
+struct memory_counters
+{
+	std::atomic<std::int64_t>	live{ 0 };
+	std::atomic<std::int64_t>	peak{ 0 };
+	std::atomic<std::int64_t>	frame_peak{ 0 };
+	std::atomic<std::uint64_t>	allocations{ 0 };
+};
+
+static memory_counters counters[memory_tags + 1];
+
+// plain data, so it needs no constructor and is safe to read from operator new on any thread.
+static thread_local memory_tag current_tag = memory_tag::untagged;
+
+// kept in front of every allocation, sized so what follows it stays aligned for any type.
+struct alignas(alignof(std::max_align_t)) allocation_header
+{
+	std::size_t	size;
+	memory_tag	tag;
+};
+
+static void raise(std::atomic<std::int64_t>& peak, std::int64_t value)
+{
+	std::int64_t seen = peak.load(std::memory_order_relaxed);
+
+	while (seen < value && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+		;
+}
+
+static void charge(memory_counters& target, std::int64_t size)
+{
+	const std::int64_t live = target.live.fetch_add(size, std::memory_order_relaxed) + size;
+
+	if (size <= 0)
+		return;
+
+	target.allocations.fetch_add(1, std::memory_order_relaxed);
+	raise(target.peak, live);
+	raise(target.frame_peak, live);
+}
+
+static void* allocate(std::size_t size) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+
+	// a size this close to the top would wrap around once the header is added.
+	if (size > SIZE_MAX - sizeof(allocation_header))
+		return nullptr;
+
+	// a zero size request still has to return a unique pointer, the header makes it one.
+	auto header = static_cast<allocation_header*>(std::malloc(sizeof(allocation_header) + size));
+
+	if (!header)
+		return nullptr;
+
+	header->size	= size;
+	header->tag		= current_tag;
+
+	charge(counters[std::size_t(header->tag)], std::int64_t(size));
+	charge(counters[memory_tags], std::int64_t(size));
+
+	return header + 1;
+}
+
+static void release(void* pointer) noexcept
+{
+	if (!pointer)
+		return;
+
+	auto header = static_cast<allocation_header*>(pointer) - 1;
+
+	counters[std::size_t(header->tag)].live.fetch_sub(std::int64_t(header->size), std::memory_order_relaxed);
+	counters[memory_tags].live.fetch_sub(std::int64_t(header->size), std::memory_order_relaxed);
+
+	std::free(header);
+}
+
+static memory_usage usage(const memory_counters& source)
+{
+	memory_usage result;
+	result.live			= source.live.load(std::memory_order_relaxed);
+	result.peak			= source.peak.load(std::memory_order_relaxed);
+	result.frame_peak	= source.frame_peak.load(std::memory_order_relaxed);
+	result.allocations	= source.allocations.load(std::memory_order_relaxed);
+	return result;
+}
+
+memory_usage memory_usage_of(memory_tag tag)
+{
+	return usage(counters[std::min<std::size_t>(std::size_t(tag), memory_tags)]);
+}
+
+memory_usage memory_total()
+{
+	return usage(counters[memory_tags]);
+}
+
+void memory_new_frame()
+{
+	// a free racing this can leave a frame peak a little above live, never below it.
+	for (auto& target : counters)
+		target.frame_peak.store(target.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+memory_scope::memory_scope(memory_tag tag) : previous(current_tag)
+{
+	current_tag = tag;
+}
+
+memory_scope::~memory_scope()
+{
+	current_tag = this->previous;
+}
+#else
+// without tracking new only counts, the allocation is exactly what malloc hands out.
+static void* allocate(std::size_t size) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+
+	// a zero size request still has to return a unique pointer.
+	return std::malloc(size ? size : 1);
+}
+
+static void release(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+#endif
+
+void* operator new(std::size_t size)
+{
+	void* pointer = allocate(size);
+
+	if (!pointer)
+		throw std::bad_alloc();
+
+	return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+	void* pointer = allocate(size);
+
+	if (!pointer)
+		throw std::bad_alloc();
+
+	return pointer;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	release(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	release(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	release(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	release(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	release(pointer);
+}
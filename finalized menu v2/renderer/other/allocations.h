@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// heap allocations made through the global operator new since startup. allocations.cpp replaces the global
+// new / delete operators with ones that count and forward to malloc / free, the counter is a relaxed atomic
+// so the count costs next to nothing.
+std::uint64_t allocation_count();
+
+/*
+* memory accounting by subsystem.
+* every allocation is charged to the tag of the innermost memory_scope open on the calling thread (untagged
+* outside of one) and carries its size and tag in a small header, so freeing it gives the bytes back to the
+* same tag wherever that happens. per tag the live bytes, the peak since startup, the peak since the last
+* memory_new_frame() and the allocation count are kept in relaxed atomics, environment_stats turns them into
+* per frame figures.
+* the header costs every allocation in the process, so all of this is only compiled in with MEMORY_TRACKING
+* defined. without it the scopes compile to nothing and every query reads zero.
+*/
+
+enum class memory_tag : std::uint8_t
+{
+	untagged,
+	render_vertices,	// batches and vertex scratch built while drawing.
+	font,				// glyph rasterizing, text layout and the atlas pages.
+	widget_tree,		// windows, tabs, groups and their elements.
+	strings,			// formatted labels and lists.
+	count
+};
+
+constexpr std::size_t memory_tags = std::size_t(memory_tag::count);
+
+struct memory_usage
+{
+	std::int64_t	live		= 0;	// bytes allocated and not yet freed.
+	std::int64_t	peak		= 0;	// most live bytes since startup.
+	std::int64_t	frame_peak	= 0;	// most live bytes since the last memory_new_frame().
+	std::uint64_t	allocations	= 0;	// since startup.
+};
+
+const char* memory_tag_name(memory_tag tag);
+
+#ifdef MEMORY_TRACKING
+memory_usage memory_usage_of(memory_tag tag);
+
+// every tag summed, the peaks are of the total rather than a sum of peaks.
+memory_usage memory_total();
+
+// starts the frame peaks over from the live bytes.
+void memory_new_frame();
+
+// the tag allocations on this thread are charged to, until the scope closes.
+class memory_scope
+{
+public:
+	explicit memory_scope(memory_tag tag);
+	~memory_scope();
+
+	memory_scope(const memory_scope&) = delete;
+	memory_scope& operator=(const memory_scope&) = delete;
+
+private:
+	memory_tag previous;
+};
+#else
+inline memory_usage memory_usage_of(memory_tag) { return { }; }
+inline memory_usage memory_total() { return { }; }
+inline void memory_new_frame() { }
+
+class memory_scope
+{
+public:
+	explicit memory_scope(memory_tag) { }
+
+	memory_scope(const memory_scope&) = delete;
+	memory_scope& operator=(const memory_scope&) = delete;
+};
+#endif
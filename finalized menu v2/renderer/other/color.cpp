@@ -0,0 +1,521 @@
+#include "color.h"
+#include <algorithm>
+#include <cstring>
+
+/*
+* scalar reference kernels.
+*/
+static void hsv_to_rgb_scalar(const float* hue, const float* saturation, const float* value, std::uint32_t* destination, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+		destination[i] = color::hsv_to_rgb(hue[i], saturation[i], value[i]).argb();
+}
+
+static void rgb_to_hsv_scalar(const std::uint32_t* source, float* hue, float* saturation, float* value, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+		color::rgb_to_hsv(color::from_argb(source[i]), hue[i], saturation[i], value[i]);
+}
+
+// c * a / 255 rounded to nearest, exact for every 8-bit pair.
+static std::uint32_t multiply_255(std::uint32_t c, std::uint32_t a)
+{
+	const std::uint32_t t = c * a + 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+static void premultiply_scalar(const std::uint32_t* source, std::uint32_t* destination, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const std::uint32_t pixel = source[i];
+		const std::uint32_t a = pixel >> 24;
+
+		destination[i] = (a << 24) | (multiply_255((pixel >> 16) & 0xff, a) << 16) | (multiply_255((pixel >> 8) & 0xff, a) << 8) | multiply_255(pixel & 0xff, a);
+	}
+}
+
+// c * 255 / a rounded to nearest and clamped, fully transparent pixels stay black.
+static std::uint32_t divide_255(std::uint32_t c, std::uint32_t a)
+{
+	return a ? std::min<std::uint32_t>(255, (c * 255 + a / 2) / a) : 0;
+}
+
+static void unpremultiply_scalar(const std::uint32_t* source, std::uint32_t* destination, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const std::uint32_t pixel = source[i];
+		const std::uint32_t a = pixel >> 24;
+
+		destination[i] = (a << 24) | (divide_255((pixel >> 16) & 0xff, a) << 16) | (divide_255((pixel >> 8) & 0xff, a) << 8) | divide_255(pixel & 0xff, a);
+	}
+}
+
+// the layouts match, so packing is a copy (see color.h).
+static void pack_scalar(const color* source, std::uint32_t* destination, std::size_t count)
+{
+	std::memcpy(static_cast<void*>(destination), source, count * sizeof(color));
+}
+
+static void unpack_scalar(const std::uint32_t* source, color* destination, std::size_t count)
+{
+	std::memcpy(static_cast<void*>(destination), source, count * sizeof(color));
+}
+
+// t quantized to 0..256.
+static int lerp_weight(float t)
+{
+	return std::min<int>(std::max<int>(int(t * 256.f + 0.5f), 0), 256);
+}
+
+static void lerp_scalar(const std::uint32_t* from, const std::uint32_t* to, int weight, std::uint32_t* destination, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+	{
+		std::uint32_t result = 0;
+
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			const std::uint32_t a = (from[i] >> shift) & 0xff;
+			const std::uint32_t b = (to[i] >> shift) & 0xff;
+
+			result |= ((a * (256 - weight) + b * weight + 128) >> 8) << shift;
+		}
+
+		destination[i] = result;
+	}
+}
+
+#ifdef CPU_X86
+/*
+* sse2 kernels, 4 pixels per step. the float ones work on whole 32-bit pixels, channels are pulled out
+* with shifts and masks so no shuffles are needed. tails go through the scalar kernels.
+*/
+static __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// (n + h * 6) mod 6 -> v - v * s * clamp(min(k, 4 - k), 0, 1), the branchless form of the hsv sextant switch.
+static __m128 hsv_channel_sse2(__m128 n, __m128 h6, __m128 s, __m128 v)
+{
+	const __m128 six	= _mm_set1_ps(6.f);
+	const __m128 x		= _mm_add_ps(n, h6);
+
+	// x is never negative here, so truncating is flooring.
+	const __m128 wraps	= _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_div_ps(x, six)));
+	const __m128 k		= _mm_sub_ps(x, _mm_mul_ps(wraps, six));
+	const __m128 ramp	= _mm_max_ps(_mm_setzero_ps(), _mm_min_ps(_mm_min_ps(k, _mm_sub_ps(_mm_set1_ps(4.f), k)), _mm_set1_ps(1.f)));
+
+	return _mm_sub_ps(v, _mm_mul_ps(_mm_mul_ps(v, s), ramp));
+}
+
+static void hsv_to_rgb_sse2(const float* hue, const float* saturation, const float* value, std::uint32_t* destination, std::size_t count)
+{
+	const __m128 scale = _mm_set1_ps(255.f);
+	const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+	std::size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 h6	= _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(hue + i), _mm_setzero_ps()), _mm_set1_ps(1.f)), _mm_set1_ps(6.f));
+		const __m128 s	= _mm_loadu_ps(saturation + i);
+		const __m128 v	= _mm_loadu_ps(value + i);
+
+		const __m128i r = _mm_cvttps_epi32(_mm_mul_ps(hsv_channel_sse2(_mm_set1_ps(5.f), h6, s, v), scale));
+		const __m128i g = _mm_cvttps_epi32(_mm_mul_ps(hsv_channel_sse2(_mm_set1_ps(3.f), h6, s, v), scale));
+		const __m128i b = _mm_cvttps_epi32(_mm_mul_ps(hsv_channel_sse2(_mm_set1_ps(1.f), h6, s, v), scale));
+
+		const __m128i pixel = _mm_or_si128(_mm_or_si128(alpha, _mm_slli_epi32(r, 16)), _mm_or_si128(_mm_slli_epi32(g, 8), b));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), pixel);
+	}
+
+	hsv_to_rgb_scalar(hue + i, saturation + i, value + i, destination + i, count - i);
+}
+
+static void rgb_to_hsv_sse2(const std::uint32_t* source, float* hue, float* saturation, float* value, std::size_t count)
+{
+	const __m128i mask = _mm_set1_epi32(0xff);
+	const __m128 zero = _mm_setzero_ps();
+	std::size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i pixel = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+
+		const __m128 r = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixel, 16), mask));
+		const __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixel, 8), mask));
+		const __m128 b = _mm_cvtepi32_ps(_mm_and_si128(pixel, mask));
+
+		const __m128 high	= _mm_max_ps(_mm_max_ps(r, g), b);
+		const __m128 low	= _mm_min_ps(_mm_min_ps(r, g), b);
+		const __m128 delta	= _mm_sub_ps(high, low);
+
+		// grey pixels divide by one instead of zero, their hue is masked out below anyway.
+		const __m128 flat	= _mm_cmpeq_ps(delta, zero);
+		const __m128 safe	= _mm_or_ps(_mm_andnot_ps(flat, delta), _mm_and_ps(flat, _mm_set1_ps(1.f)));
+
+		__m128 h_r = _mm_div_ps(_mm_sub_ps(g, b), safe);
+		h_r = _mm_add_ps(h_r, _mm_and_ps(_mm_cmplt_ps(h_r, zero), _mm_set1_ps(6.f)));
+
+		const __m128 h_g = _mm_add_ps(_mm_div_ps(_mm_sub_ps(b, r), safe), _mm_set1_ps(2.f));
+		const __m128 h_b = _mm_add_ps(_mm_div_ps(_mm_sub_ps(r, g), safe), _mm_set1_ps(4.f));
+
+		// same precedence as the scalar version, red wins ties, then green.
+		__m128 h = select_ps(_mm_cmpeq_ps(high, r), h_r, select_ps(_mm_cmpeq_ps(high, g), h_g, h_b));
+		h = _mm_andnot_ps(flat, _mm_div_ps(h, _mm_set1_ps(6.f)));
+
+		const __m128 lit	= _mm_cmpgt_ps(high, zero);
+		const __m128 s		= _mm_and_ps(lit, _mm_div_ps(delta, _mm_or_ps(_mm_and_ps(lit, high), _mm_andnot_ps(lit, _mm_set1_ps(1.f)))));
+
+		_mm_storeu_ps(hue + i, h);
+		_mm_storeu_ps(saturation + i, s);
+		_mm_storeu_ps(value + i, _mm_div_ps(high, _mm_set1_ps(255.f)));
+	}
+
+	rgb_to_hsv_scalar(source + i, hue + i, saturation + i, value + i, count - i);
+}
+
+// two pixels widened to 16-bit lanes (b, g, r, a each), multiplied by their alpha with alpha itself kept.
+static __m128i premultiply_wide_sse2(__m128i wide)
+{
+	const __m128i keep_alpha = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+	const __m128i color_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+
+	__m128i alpha = _mm_shufflelo_epi16(wide, _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm_or_si128(_mm_and_si128(alpha, color_mask), keep_alpha);
+
+	const __m128i t = _mm_add_epi16(_mm_mullo_epi16(wide, alpha), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static void premultiply_sse2(const std::uint32_t* source, std::uint32_t* destination, std::size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	std::size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i pixel = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+		const __m128i low	= premultiply_wide_sse2(_mm_unpacklo_epi8(pixel, zero));
+		const __m128i high	= premultiply_wide_sse2(_mm_unpackhi_epi8(pixel, zero));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_packus_epi16(low, high));
+	}
+
+	premultiply_scalar(source + i, destination + i, count - i);
+}
+
+// exact integer division through floats, the quotient is either exact or far enough from the next integer.
+static __m128i divide_255_sse2(__m128i c, __m128 a, __m128 half, __m128 transparent)
+{
+	const __m128 numerator	= _mm_add_ps(_mm_cvtepi32_ps(_mm_mullo_epi16(c, _mm_set1_epi32(255))), half);
+	const __m128 quotient	= _mm_min_ps(_mm_div_ps(numerator, a), _mm_set1_ps(255.f));
+
+	return _mm_cvttps_epi32(_mm_andnot_ps(transparent, quotient));
+}
+
+static void unpremultiply_sse2(const std::uint32_t* source, std::uint32_t* destination, std::size_t count)
+{
+	const __m128i mask = _mm_set1_epi32(0xff);
+	std::size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i pixel		= _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+		const __m128i alpha		= _mm_srli_epi32(pixel, 24);
+		const __m128 a			= _mm_cvtepi32_ps(alpha);
+		const __m128 transparent = _mm_cmpeq_ps(a, _mm_setzero_ps());
+		const __m128 safe		= _mm_or_ps(_mm_andnot_ps(transparent, a), _mm_and_ps(transparent, _mm_set1_ps(1.f)));
+		const __m128 half		= _mm_cvtepi32_ps(_mm_srli_epi32(alpha, 1));
+
+		// c * 255 fits in 16 bits, so a 16-bit multiply on the 32-bit lanes is enough.
+		const __m128i r = divide_255_sse2(_mm_and_si128(_mm_srli_epi32(pixel, 16), mask), safe, half, transparent);
+		const __m128i g = divide_255_sse2(_mm_and_si128(_mm_srli_epi32(pixel, 8), mask), safe, half, transparent);
+		const __m128i b = divide_255_sse2(_mm_and_si128(pixel, mask), safe, half, transparent);
+
+		const __m128i result = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(alpha, 24), _mm_slli_epi32(r, 16)), _mm_or_si128(_mm_slli_epi32(g, 8), b));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), result);
+	}
+
+	unpremultiply_scalar(source + i, destination + i, count - i);
+}
+
+static void lerp_sse2(const std::uint32_t* from, const std::uint32_t* to, int weight, std::uint32_t* destination, std::size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i weight_to = _mm_set1_epi16(short(weight));
+	const __m128i weight_from = _mm_set1_epi16(short(256 - weight));
+	const __m128i round = _mm_set1_epi16(128);
+	std::size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i));
+		const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(to + i));
+
+		// a * (256 - w) + b * w + 128 stays below 65536, so wrapping 16-bit math is exact.
+		__m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), weight_from), _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), weight_to));
+		__m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), weight_from), _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), weight_to));
+
+		low = _mm_srli_epi16(_mm_add_epi16(low, round), 8);
+		high = _mm_srli_epi16(_mm_add_epi16(high, round), 8);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_packus_epi16(low, high));
+	}
+
+	lerp_scalar(from + i, to + i, weight, destination + i, count - i);
+}
+
+/*
+* avx2 kernels, 8 pixels per step.
+*/
+AVX2_TARGET static __m256 hsv_channel_avx2(__m256 n, __m256 h6, __m256 s, __m256 v)
+{
+	const __m256 six	= _mm256_set1_ps(6.f);
+	const __m256 x		= _mm256_add_ps(n, h6);
+	const __m256 wraps	= _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_div_ps(x, six)));
+	const __m256 k		= _mm256_sub_ps(x, _mm256_mul_ps(wraps, six));
+	const __m256 ramp	= _mm256_max_ps(_mm256_setzero_ps(), _mm256_min_ps(_mm256_min_ps(k, _mm256_sub_ps(_mm256_set1_ps(4.f), k)), _mm256_set1_ps(1.f)));
+
+	return _mm256_sub_ps(v, _mm256_mul_ps(_mm256_mul_ps(v, s), ramp));
+}
+
+AVX2_TARGET static void hsv_to_rgb_avx2(const float* hue, const float* saturation, const float* value, std::uint32_t* destination, std::size_t count)
+{
+	const __m256 scale = _mm256_set1_ps(255.f);
+	const __m256i alpha = _mm256_set1_epi32(int(0xff000000));
+	std::size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 h6	= _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(hue + i), _mm256_setzero_ps()), _mm256_set1_ps(1.f)), _mm256_set1_ps(6.f));
+		const __m256 s	= _mm256_loadu_ps(saturation + i);
+		const __m256 v	= _mm256_loadu_ps(value + i);
+
+		const __m256i r = _mm256_cvttps_epi32(_mm256_mul_ps(hsv_channel_avx2(_mm256_set1_ps(5.f), h6, s, v), scale));
+		const __m256i g = _mm256_cvttps_epi32(_mm256_mul_ps(hsv_channel_avx2(_mm256_set1_ps(3.f), h6, s, v), scale));
+		const __m256i b = _mm256_cvttps_epi32(_mm256_mul_ps(hsv_channel_avx2(_mm256_set1_ps(1.f), h6, s, v), scale));
+
+		const __m256i pixel = _mm256_or_si256(_mm256_or_si256(alpha, _mm256_slli_epi32(r, 16)), _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), pixel);
+	}
+
+	hsv_to_rgb_sse2(hue + i, saturation + i, value + i, destination + i, count - i);
+}
+
+AVX2_TARGET static void rgb_to_hsv_avx2(const std::uint32_t* source, float* hue, float* saturation, float* value, std::size_t count)
+{
+	const __m256i mask = _mm256_set1_epi32(0xff);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.f);
+	std::size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i pixel = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+
+		const __m256 r = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pixel, 16), mask));
+		const __m256 g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pixel, 8), mask));
+		const __m256 b = _mm256_cvtepi32_ps(_mm256_and_si256(pixel, mask));
+
+		const __m256 high	= _mm256_max_ps(_mm256_max_ps(r, g), b);
+		const __m256 low	= _mm256_min_ps(_mm256_min_ps(r, g), b);
+		const __m256 delta	= _mm256_sub_ps(high, low);
+
+		const __m256 flat	= _mm256_cmp_ps(delta, zero, _CMP_EQ_OQ);
+		const __m256 safe	= _mm256_blendv_ps(delta, one, flat);
+
+		__m256 h_r = _mm256_div_ps(_mm256_sub_ps(g, b), safe);
+		h_r = _mm256_add_ps(h_r, _mm256_and_ps(_mm256_cmp_ps(h_r, zero, _CMP_LT_OQ), _mm256_set1_ps(6.f)));
+
+		const __m256 h_g = _mm256_add_ps(_mm256_div_ps(_mm256_sub_ps(b, r), safe), _mm256_set1_ps(2.f));
+		const __m256 h_b = _mm256_add_ps(_mm256_div_ps(_mm256_sub_ps(r, g), safe), _mm256_set1_ps(4.f));
+
+		__m256 h = _mm256_blendv_ps(_mm256_blendv_ps(h_b, h_g, _mm256_cmp_ps(high, g, _CMP_EQ_OQ)), h_r, _mm256_cmp_ps(high, r, _CMP_EQ_OQ));
+		h = _mm256_andnot_ps(flat, _mm256_div_ps(h, _mm256_set1_ps(6.f)));
+
+		const __m256 lit	= _mm256_cmp_ps(high, zero, _CMP_GT_OQ);
+		const __m256 s		= _mm256_and_ps(lit, _mm256_div_ps(delta, _mm256_blendv_ps(one, high, lit)));
+
+		_mm256_storeu_ps(hue + i, h);
+		_mm256_storeu_ps(saturation + i, s);
+		_mm256_storeu_ps(value + i, _mm256_div_ps(high, _mm256_set1_ps(255.f)));
+	}
+
+	rgb_to_hsv_sse2(source + i, hue + i, saturation + i, value + i, count - i);
+}
+
+// unpacks and packs work per 128-bit lane, which undo each other, so the pixel order survives.
+AVX2_TARGET static __m256i premultiply_wide_avx2(__m256i wide)
+{
+	const __m256i keep_alpha = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+	const __m256i color_mask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+
+	__m256i alpha = _mm256_shufflelo_epi16(wide, _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm256_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm256_or_si256(_mm256_and_si256(alpha, color_mask), keep_alpha);
+
+	const __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(wide, alpha), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+AVX2_TARGET static void premultiply_avx2(const std::uint32_t* source, std::uint32_t* destination, std::size_t count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	std::size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i pixel = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+		const __m256i low	= premultiply_wide_avx2(_mm256_unpacklo_epi8(pixel, zero));
+		const __m256i high	= premultiply_wide_avx2(_mm256_unpackhi_epi8(pixel, zero));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_packus_epi16(low, high));
+	}
+
+	premultiply_sse2(source + i, destination + i, count - i);
+}
+
+AVX2_TARGET static __m256i divide_255_avx2(__m256i c, __m256 a, __m256 half, __m256 transparent)
+{
+	const __m256 numerator	= _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_mullo_epi32(c, _mm256_set1_epi32(255))), half);
+	const __m256 quotient	= _mm256_min_ps(_mm256_div_ps(numerator, a), _mm256_set1_ps(255.f));
+
+	return _mm256_cvttps_epi32(_mm256_andnot_ps(transparent, quotient));
+}
+
+AVX2_TARGET static void unpremultiply_avx2(const std::uint32_t* source, std::uint32_t* destination, std::size_t count)
+{
+	const __m256i mask = _mm256_set1_epi32(0xff);
+	std::size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i pixel		= _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+		const __m256i alpha		= _mm256_srli_epi32(pixel, 24);
+		const __m256 a			= _mm256_cvtepi32_ps(alpha);
+		const __m256 transparent = _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_EQ_OQ);
+		const __m256 safe		= _mm256_blendv_ps(a, _mm256_set1_ps(1.f), transparent);
+		const __m256 half		= _mm256_cvtepi32_ps(_mm256_srli_epi32(alpha, 1));
+
+		const __m256i r = divide_255_avx2(_mm256_and_si256(_mm256_srli_epi32(pixel, 16), mask), safe, half, transparent);
+		const __m256i g = divide_255_avx2(_mm256_and_si256(_mm256_srli_epi32(pixel, 8), mask), safe, half, transparent);
+		const __m256i b = divide_255_avx2(_mm256_and_si256(pixel, mask), safe, half, transparent);
+
+		const __m256i result = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(alpha, 24), _mm256_slli_epi32(r, 16)), _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), result);
+	}
+
+	unpremultiply_sse2(source + i, destination + i, count - i);
+}
+
+AVX2_TARGET static void lerp_avx2(const std::uint32_t* from, const std::uint32_t* to, int weight, std::uint32_t* destination, std::size_t count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i weight_to = _mm256_set1_epi16(short(weight));
+	const __m256i weight_from = _mm256_set1_epi16(short(256 - weight));
+	const __m256i round = _mm256_set1_epi16(128);
+	std::size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + i));
+		const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(to + i));
+
+		__m256i low = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(a, zero), weight_from), _mm256_mullo_epi16(_mm256_unpacklo_epi8(b, zero), weight_to));
+		__m256i high = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(a, zero), weight_from), _mm256_mullo_epi16(_mm256_unpackhi_epi8(b, zero), weight_to));
+
+		low = _mm256_srli_epi16(_mm256_add_epi16(low, round), 8);
+		high = _mm256_srli_epi16(_mm256_add_epi16(high, round), 8);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_packus_epi16(low, high));
+	}
+
+	lerp_sse2(from + i, to + i, weight, destination + i, count - i);
+}
+#endif
+
+// an unsupported level falls back to the reference instead of faulting.
+static simd_level usable(simd_level level)
+{
+	return simd_supported(level) ? level : simd_level::scalar;
+}
+
+void color_batch::hsv_to_rgb(const float* hue, const float* saturation, const float* value, std::uint32_t* destination, std::size_t count, simd_level level)
+{
+	switch (usable(level))
+	{
+#ifdef CPU_X86
+	case simd_level::avx2:	hsv_to_rgb_avx2(hue, saturation, value, destination, count); break;
+	case simd_level::sse2:	hsv_to_rgb_sse2(hue, saturation, value, destination, count); break;
+#endif
+	default:				hsv_to_rgb_scalar(hue, saturation, value, destination, count); break;
+	}
+}
+
+void color_batch::rgb_to_hsv(const std::uint32_t* source, float* hue, float* saturation, float* value, std::size_t count, simd_level level)
+{
+	switch (usable(level))
+	{
+#ifdef CPU_X86
+	case simd_level::avx2:	rgb_to_hsv_avx2(source, hue, saturation, value, count); break;
+	case simd_level::sse2:	rgb_to_hsv_sse2(source, hue, saturation, value, count); break;
+#endif
+	default:				rgb_to_hsv_scalar(source, hue, saturation, value, count); break;
+	}
+}
+
+void color_batch::premultiply(const std::uint32_t* source, std::uint32_t* destination, std::size_t count, simd_level level)
+{
+	switch (usable(level))
+	{
+#ifdef CPU_X86
+	case simd_level::avx2:	premultiply_avx2(source, destination, count); break;
+	case simd_level::sse2:	premultiply_sse2(source, destination, count); break;
+#endif
+	default:				premultiply_scalar(source, destination, count); break;
+	}
+}
+
+void color_batch::unpremultiply(const std::uint32_t* source, std::uint32_t* destination, std::size_t count, simd_level level)
+{
+	switch (usable(level))
+	{
+#ifdef CPU_X86
+	case simd_level::avx2:	unpremultiply_avx2(source, destination, count); break;
+	case simd_level::sse2:	unpremultiply_sse2(source, destination, count); break;
+#endif
+	default:				unpremultiply_scalar(source, destination, count); break;
+	}
+}
+
+void color_batch::pack(const color* source, std::uint32_t* destination, std::size_t count, simd_level level)
+{
+	// a copy at every level.
+	(void)level;
+	pack_scalar(source, destination, count);
+}
+
+void color_batch::unpack(const std::uint32_t* source, color* destination, std::size_t count, simd_level level)
+{
+	// a copy at every level.
+	(void)level;
+	unpack_scalar(source, destination, count);
+}
+
+void color_batch::lerp(const std::uint32_t* from, const std::uint32_t* to, float t, std::uint32_t* destination, std::size_t count, simd_level level)
+{
+	const int weight = lerp_weight(t);
+
+	switch (usable(level))
+	{
+#ifdef CPU_X86
+	case simd_level::avx2:	lerp_avx2(from, to, weight, destination, count); break;
+	case simd_level::sse2:	lerp_sse2(from, to, weight, destination, count); break;
+#endif
+	default:				lerp_scalar(from, to, weight, destination, count); break;
+	}
+}
@@ -1,18 +1,38 @@
 #pragma once
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "platform.h"
+#include "cpu.h"
 
+/*
+* 32-bit color, stored in the byte order of a d3dcolor (b, g, r, a on little endian). argb() is written
+* with shifts so it stays constexpr, on little endian the compiler turns it into a single 32-bit load and
+* vertex generation never repacks channels. everything is constexpr, so color literals and the theme
+* constants (gui/theme.h) are folded at compile time.
+*/
 class color
 {
 public:
-    color() : r{ 0 }, g{ 0 }, b{ 0 }, a{ 255 } { };
-    color(int r, int g, int b, int a = 255) : r{ r }, g{ g }, b{ b }, a{ a } { };
+	constexpr color() : b{ 0 }, g{ 0 }, r{ 0 }, a{ 255 } { }
+	constexpr color(int r, int g, int b, int a = 255) : b{ std::uint8_t(b) }, g{ std::uint8_t(g) }, r{ std::uint8_t(r) }, a{ std::uint8_t(a) } { }
 
-    // get color function.
-    D3DCOLOR argb() { return D3DCOLOR_ARGB(this->a, this->r, this->g, this->b); }
-    color rgba() { return color(this->r, this->g, this->b, this->a); }
+	// equality operators.
+	constexpr bool operator==(const color& c) const { return c.r == this->r && c.g == this->g && c.b == this->b && c.a == this->a; }
+	constexpr bool operator!=(const color& c) const { return !(*this == c); }
 
-    // set color function.
-    color set(int r, int g, int b, int a = 255) { return color(r, g, b, a); }
+	// get color function.
+	constexpr D3DCOLOR argb() const { return (D3DCOLOR(this->a) << 24) | (D3DCOLOR(this->r) << 16) | (D3DCOLOR(this->g) << 8) | D3DCOLOR(this->b); }
+	constexpr color rgba() const { return *this; }
+
+	// unpack a d3dcolor.
+	static constexpr color from_argb(D3DCOLOR argb) { return color((argb >> 16) & 0xff, (argb >> 8) & 0xff, argb & 0xff, (argb >> 24) & 0xff); }
+
+	// set color function.
+	static constexpr color set(int r, int g, int b, int a = 255) { return color(r, g, b, a); }
+
+	// same colour with a different alpha.
+	constexpr color alpha(int a) const { return color(this->r, this->g, this->b, a); }
 
 	/*
 	* information credit: https://programmingdesignsystems.com/color/color-models-and-color-spaces/index.html#:~:text=HSV%20is%20a%20cylindrical%20color,on%20the%20RGB%20color%20circle.
@@ -25,7 +45,7 @@ public:
 	*/
 	static color hsv(float hue, float saturation, float value, float alpha)
 	{
-		float r, g, b;
+		float r = 0.f, g = 0.f, b = 0.f;
 
 		/*
 		float	h = hue / 360,
@@ -33,7 +53,8 @@ public:
 				v = value / 100;
 		*/
 
-		float	h = hue,
+		// hue is clamped to 0..1 like the simd kernels in color.cpp do, nan included, so the sextant is 0..6.
+		float	h = hue > 0.f ? (hue < 1.f ? hue : 1.f) : 0.f,
 				s = saturation,
 				v = value;
 
@@ -53,13 +74,7 @@ public:
 		case 5: r = v, g = p, b = q; break;
 		}
 
-		color result;
-		result.r = r * 255;
-		result.g = g * 255;
-		result.b = b * 255;
-		result.a = alpha;
-
-		return result;
+		return color(int(r * 255), int(g * 255), int(b * 255), int(alpha));
 	}
 
 	static color hsv_to_rgb(float h, float s, float v)
@@ -67,5 +82,64 @@ public:
 		return hsv(h, s, v, 255.f);
 	}
 
-    int r, g, b, a;
+	// inverse of hsv, hue, saturation and value come back in 0..1.
+	static void rgb_to_hsv(const color& c, float& hue, float& saturation, float& value)
+	{
+		float	r = float(c.r),
+				g = float(c.g),
+				b = float(c.b);
+
+		float	high	= r > g ? (r > b ? r : b) : (g > b ? g : b),
+				low		= r < g ? (r < b ? r : b) : (g < b ? g : b),
+				delta	= high - low;
+
+		value		= high / 255.f;
+		saturation	= high > 0.f ? delta / high : 0.f;
+
+		if (delta == 0.f)
+			hue = 0.f;
+		else if (high == r)
+		{
+			hue = (g - b) / delta;
+
+			if (hue < 0.f)
+				hue += 6.f;
+		}
+		else if (high == g)
+			hue = (b - r) / delta + 2.f;
+		else
+			hue = (r - g) / delta + 4.f;
+
+		hue /= 6.f;
+	}
+
+	// declared in memory order, see above.
+	std::uint8_t b, g, r, a;
 };
+
+static_assert(sizeof(color) == sizeof(D3DCOLOR), "color must stay layout compatible with d3dcolor");
+
+/*
+* batch color kernels over arrays, dispatched at runtime to scalar, sse2 or avx2 (see cpu.h).
+* packed colors are d3dcolor argb, which is also the layout of color itself. the scalar kernels are the reference: the integer kernels match them
+* exactly, the float hsv conversions stay within one 8-bit step (rgb) or 1e-5 (hsv) of them.
+*/
+namespace color_batch
+{
+	// hsv in 0..1 to opaque packed colors, same results as color::hsv_to_rgb.
+	void hsv_to_rgb(const float* hue, const float* saturation, const float* value, std::uint32_t* destination, std::size_t count, simd_level level = simd_best());
+
+	// packed colors to hsv in 0..1, same results as color::rgb_to_hsv.
+	void rgb_to_hsv(const std::uint32_t* source, float* hue, float* saturation, float* value, std::size_t count, simd_level level = simd_best());
+
+	// straight to premultiplied alpha and back, rounded to nearest.
+	void premultiply(const std::uint32_t* source, std::uint32_t* destination, std::size_t count, simd_level level = simd_best());
+	void unpremultiply(const std::uint32_t* source, std::uint32_t* destination, std::size_t count, simd_level level = simd_best());
+
+	// color to packed and back, both are straight copies since the layouts match.
+	void pack(const color* source, std::uint32_t* destination, std::size_t count, simd_level level = simd_best());
+	void unpack(const std::uint32_t* source, color* destination, std::size_t count, simd_level level = simd_best());
+
+	// per channel blend from -> to, t in 0..1 is quantized to 1/256 steps.
+	void lerp(const std::uint32_t* from, const std::uint32_t* to, float t, std::uint32_t* destination, std::size_t count, simd_level level = simd_best());
+}
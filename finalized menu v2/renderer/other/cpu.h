@@ -0,0 +1,97 @@
+#pragma once
+
+/*
+* runtime simd detection shared by the vectorized kernels (atlas conversion, color batches).
+* sse2 is the x86 baseline, avx2 is only reported when the cpu has it and the os saves ymm registers.
+*/
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_X86
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// msvc lets any function use avx2 intrinsics, gcc and clang want the target spelled out.
+#if defined(CPU_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+enum class simd_level : int
+{
+	scalar,
+	sse2,
+	avx2
+};
+
+inline const char* simd_name(simd_level level)
+{
+	switch (level)
+	{
+	case simd_level::scalar:	return "scalar";
+	case simd_level::sse2:		return "sse2";
+	case simd_level::avx2:		return "avx2";
+	}
+
+	return "unknown";
+}
+
+#ifdef CPU_X86
+inline bool cpu_has_avx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+
+	if (info[0] < 7)
+		return false;
+
+	// avx2 needs the cpu flag and the os saving ymm registers.
+	__cpuid(info, 1);
+	const bool osxsave	= (info[2] & (1 << 27)) != 0;
+	const bool avx		= (info[2] & (1 << 28)) != 0;
+
+	if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+inline bool simd_supported(simd_level level)
+{
+	switch (level)
+	{
+	case simd_level::scalar:
+		return true;
+
+#ifdef CPU_X86
+	case simd_level::sse2:
+		// every x64 cpu has it, 32-bit builds assume it like the rest of the project does.
+		return true;
+
+	case simd_level::avx2:
+	{
+		static const bool supported = cpu_has_avx2();
+		return supported;
+	}
+#endif
+
+	default:
+		return false;
+	}
+}
+
+// best level the running cpu supports.
+inline simd_level simd_best()
+{
+	static const simd_level best = simd_supported(simd_level::avx2) ? simd_level::avx2 : simd_supported(simd_level::sse2) ? simd_level::sse2 : simd_level::scalar;
+	return best;
+}
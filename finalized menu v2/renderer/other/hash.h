@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64-bit fnv-1a style hash, cheap enough to run over widget state every frame for dirty tracking.
+constexpr std::uint64_t hash_seed = 0xcbf29ce484222325ull;
+
+inline std::uint64_t hash_bytes(std::uint64_t hash, const void* data, std::size_t size)
+{
+	const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+
+	// bulk data (whole frames of vertices) goes a word at a time, folding the high half back down so
+	// every bit of the word reaches every bit of the hash. the tail is plain fnv-1a.
+	for (; size >= 8; bytes += 8, size -= 8)
+	{
+		std::uint64_t word;
+		std::memcpy(&word, bytes, 8);
+
+		hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+		hash ^= hash >> 32;
+	}
+
+	for (std::size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+// folds a trivially copyable value (ints, floats, pointers, colors) into the hash.
+template <class T>
+inline std::uint64_t hash_value(std::uint64_t hash, const T& value)
+{
+	return hash_bytes(hash, &value, sizeof(value));
+}
+
+inline std::uint64_t hash_string(std::uint64_t hash, const char* text)
+{
+	if (!text)
+		return hash_value(hash, 0);
+
+	for (; *text; text++)
+	{
+		hash ^= std::uint8_t(*text);
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
@@ -0,0 +1,130 @@
+#include "histogram.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// index of the highest set bit, value must not be zero.
+static int highest_bit(std::uint64_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return int(index);
+#else
+	return 63 - __builtin_clzll(value);
+#endif
+}
+
+std::size_t histogram::bucket_index(std::uint64_t value)
+{
+	// the first 128 buckets are one value wide, after that each run of 128 is twice as wide as the last.
+	if (value < sub_buckets)
+		return std::size_t(value);
+
+	const int shift = highest_bit(value) - precision_bits;
+	return std::size_t(shift + 1) * sub_buckets + std::size_t(value >> shift) - sub_buckets;
+}
+
+std::uint64_t histogram::bucket_lowest(std::size_t index)
+{
+	if (index < sub_buckets)
+		return index;
+
+	const int shift = int(index / sub_buckets) - 1;
+	return (std::uint64_t(index % sub_buckets) + sub_buckets) << shift;
+}
+
+std::uint64_t histogram::bucket_highest(std::size_t index)
+{
+	if (index < sub_buckets)
+		return index;
+
+	const int shift = int(index / sub_buckets) - 1;
+	return bucket_lowest(index) + (1ull << shift) - 1;
+}
+
+void histogram::record(std::uint64_t value)
+{
+	value = std::min<std::uint64_t>(value, max_value);
+
+	this->buckets[bucket_index(value)]++;
+	this->total++;
+	this->sum		+= value;
+	this->lowest	= std::min<std::uint64_t>(this->lowest, value);
+	this->highest	= std::max<std::uint64_t>(this->highest, value);
+}
+
+void histogram::merge(const histogram& other)
+{
+	for (std::size_t i = 0; i < bucket_count; i++)
+		this->buckets[i] += other.buckets[i];
+
+	this->total		+= other.total;
+	this->sum		+= other.sum;
+	this->lowest	= std::min<std::uint64_t>(this->lowest, other.lowest);
+	this->highest	= std::max<std::uint64_t>(this->highest, other.highest);
+}
+
+void histogram::reset()
+{
+	this->buckets.fill(0);
+	this->total		= 0;
+	this->sum		= 0;
+	this->lowest	= max_value;
+	this->highest	= 0;
+}
+
+std::uint64_t histogram::percentile(double fraction) const
+{
+	if (!this->total)
+		return 0;
+
+	// the value of rank n in sorted order, ranks counted from 1 like hdr histogram does.
+	const double wanted	= std::min<double>(std::max<double>(fraction, 0.0), 1.0) * double(this->total);
+	const std::uint64_t rank = std::max<std::uint64_t>(1, std::uint64_t(wanted + 0.5));
+	std::uint64_t seen = 0;
+
+	for (std::size_t i = 0; i < bucket_count; i++)
+	{
+		seen += this->buckets[i];
+
+		// the top of the bucket, clamped so the tail never reads past what was actually recorded.
+		if (seen >= rank)
+			return std::min<std::uint64_t>(bucket_highest(i), this->highest);
+	}
+
+	return this->highest;
+}
+
+void histogram::print(std::FILE* file, double scale) const
+{
+	std::fprintf(file, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+
+	std::uint64_t seen = 0;
+	double variance = 0.0;
+
+	for (std::size_t i = 0; i < bucket_count && seen < this->total; i++)
+	{
+		if (!this->buckets[i])
+			continue;
+
+		const double middle = (double(bucket_lowest(i)) + double(bucket_highest(i))) * 0.5 - this->mean();
+		variance += middle * middle * double(this->buckets[i]);
+
+		seen += this->buckets[i];
+
+		const double fraction	= double(seen) / double(this->total);
+		const double value		= double(std::min<std::uint64_t>(bucket_highest(i), this->highest)) / scale;
+
+		if (seen < this->total)
+			std::fprintf(file, "%12.3f %2.12f %10llu %14.2f\n", value, fraction, static_cast<unsigned long long>(seen), 1.0 / (1.0 - fraction));
+		else
+			std::fprintf(file, "%12.3f %2.12f %10llu\n", value, fraction, static_cast<unsigned long long>(seen));
+	}
+
+	std::fprintf(file, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", this->mean() / scale, (this->total ? std::sqrt(variance / double(this->total)) : 0.0) / scale);
+	std::fprintf(file, "#[Max     = %12.3f, Total count    = %12llu]\n", double(this->highest) / scale, static_cast<unsigned long long>(this->total));
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/*
+* log-linear histogram, in the style of hdr histogram.
+* values are counted into buckets that double in width every 128 of them, so any value up to max_value is
+* held to within 1/128 (under 1%) of itself in a fixed 32 kb, however long the session runs. recording is a
+* couple of shifts and an increment, percentiles walk the buckets. used for timings in nanoseconds, where
+* the tail (the p99 and up) is what an average hides.
+*/
+
+class histogram
+{
+public:
+	static constexpr int			precision_bits	= 7;
+	static constexpr std::uint64_t	sub_buckets		= 1ull << precision_bits;
+	static constexpr int			range_bits		= 36;	// about 68 seconds in nanoseconds.
+	static constexpr std::uint64_t	max_value		= (1ull << range_bits) - 1;
+	static constexpr std::size_t	bucket_count	= std::size_t(range_bits - precision_bits + 1) * sub_buckets;
+
+	// values above max_value are counted as max_value.
+	void record(std::uint64_t value);
+
+	// adds every value another histogram holds.
+	void merge(const histogram& other);
+
+	void reset();
+
+	std::uint64_t count() const { return this->total; }
+	std::uint64_t min() const { return this->total ? this->lowest : 0; }
+	std::uint64_t max() const { return this->highest; }
+	double mean() const { return this->total ? double(this->sum) / double(this->total) : 0.0; }
+
+	// value at or below which the given fraction (0..1) of the recorded values fall, to bucket precision.
+	// never above max(), 1.0 gives the largest value recorded.
+	std::uint64_t percentile(double fraction) const;
+
+	// hdr histogram's percentile distribution text (value, percentile, total count, 1/(1-percentile)), one line
+	// per occupied bucket, values divided by scale. the output plots with hdr histogram's plotter.
+	void print(std::FILE* file, double scale = 1.0) const;
+
+	static std::size_t bucket_index(std::uint64_t value);
+
+	// smallest and largest value counted into a bucket.
+	static std::uint64_t bucket_lowest(std::size_t index);
+	static std::uint64_t bucket_highest(std::size_t index);
+
+private:
+	std::array<std::uint64_t, bucket_count>	buckets	= { };
+	std::uint64_t							total	= 0;
+	std::uint64_t							sum		= 0;
+	std::uint64_t							lowest	= max_value;
+	std::uint64_t							highest	= 0;
+};
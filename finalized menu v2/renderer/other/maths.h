@@ -1,5 +1,6 @@
 #pragma once
 #include <cmath>
+#include "platform.h"
 
 // this is vector 2d but renamed it from 'vector' to 'point' for less confusion.
 // it was only made for drawing 2d objects and calculating 2d objects position.
@@ -0,0 +1,321 @@
+#pragma once
+
+/*
+* the handful of win32 / d3d9 types used by the portable parts (fonts, atlas packing, colors, maths, the gui).
+* on windows these come from the real headers, everywhere else we define just enough of them
+* so text layout, glyph rasterization and the gui can be built and exercised without a device.
+* there the renderer draws into a null device and input only comes from gui_input's scripted keys.
+*/
+#ifdef _WIN32
+#include <Windows.h>
+#include <d3d9.h>
+#else
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+typedef std::uint8_t	BYTE;
+typedef std::uint16_t	WORD;
+typedef std::uint32_t	DWORD;
+typedef std::int32_t	LONG;
+typedef std::int32_t	HRESULT;
+typedef int				INT;
+typedef unsigned int	UINT;
+typedef float			FLOAT;
+typedef char			TCHAR;
+typedef DWORD			D3DCOLOR;
+
+struct SIZE
+{
+	LONG cx;
+	LONG cy;
+};
+
+#define _T(x)							x
+#define TEXT(x)							x
+
+#define S_OK							((HRESULT)0)
+#define E_FAIL							((HRESULT)0x80004005)
+#define SUCCEEDED(hr)					(((HRESULT)(hr)) >= 0)
+#define FAILED(hr)						(((HRESULT)(hr)) < 0)
+
+#define FW_NORMAL						400
+#define FW_BOLD							700
+
+#define ZeroMemory(destination, length)	std::memset((destination), 0, (length))
+#define D3DCOLOR_ARGB(a, r, g, b)		((D3DCOLOR)((((a) & 0xff) << 24) | (((r) & 0xff) << 16) | (((g) & 0xff) << 8) | ((b) & 0xff)))
+
+typedef std::int16_t	SHORT;
+typedef int				BOOL;
+typedef unsigned long	ULONG;
+typedef void*			HWND;
+typedef std::uintptr_t	WPARAM;
+typedef std::intptr_t	LPARAM;
+
+#define TRUE							1
+#define FALSE							0
+
+#define LOWORD(l)						((WORD)(((std::uintptr_t)(l)) & 0xffff))
+#define HIWORD(l)						((WORD)((((std::uintptr_t)(l)) >> 16) & 0xffff))
+#define GET_WHEEL_DELTA_WPARAM(w)		((short)HIWORD(w))
+#define WHEEL_DELTA						120
+
+#define WM_KEYDOWN						0x0100
+#define WM_KEYUP						0x0101
+#define WM_SYSKEYDOWN					0x0104
+#define WM_SYSKEYUP						0x0105
+#define WM_MOUSEMOVE					0x0200
+#define WM_LBUTTONDOWN					0x0201
+#define WM_LBUTTONUP					0x0202
+#define WM_RBUTTONDOWN					0x0204
+#define WM_RBUTTONUP					0x0205
+#define WM_MBUTTONDOWN					0x0207
+#define WM_MBUTTONUP					0x0208
+#define WM_MOUSEWHEEL					0x020a
+
+#define VK_LBUTTON						0x01
+#define VK_RBUTTON						0x02
+#define VK_MBUTTON						0x04
+#define VK_XBUTTON1						0x05
+#define VK_XBUTTON2						0x06
+#define VK_ESCAPE						0x1b
+#define VK_PRIOR						0x21
+#define VK_NEXT							0x22
+#define VK_END							0x23
+#define VK_HOME							0x24
+#define VK_LEFT							0x25
+#define VK_UP							0x26
+#define VK_RIGHT						0x27
+#define VK_DOWN							0x28
+#define VK_INSERT						0x2d
+#define VK_DELETE						0x2e
+#define VK_LWIN							0x5b
+#define VK_RWIN							0x5c
+#define VK_APPS							0x5d
+#define VK_DIVIDE						0x6f
+#define VK_NUMLOCK						0x90
+#define VK_RCONTROL						0xa3
+#define VK_RMENU						0xa5
+
+#define MAPVK_VK_TO_VSC					0
+#define KF_EXTENDED						0x0100
+
+// no keyboard or foreground window to ask, key names fall back to the gui's own.
+inline SHORT GetAsyncKeyState(int) { return 0; }
+inline SHORT GetKeyState(int) { return 0; }
+inline HWND GetForegroundWindow() { return nullptr; }
+inline UINT MapVirtualKey(UINT, UINT) { return 0; }
+inline int GetKeyNameText(LONG, char*, int) { return 0; }
+
+// bounded copy matching the msvc secure crt overload we use.
+template <std::size_t size>
+inline int strncpy_s(char (&destination)[size], const char* source, std::size_t count)
+{
+	std::size_t length = 0;
+
+	while (length < count && length + 1 < size && source[length])
+	{
+		destination[length] = source[length];
+		length++;
+	}
+
+	destination[length] = '\0';
+	return 0;
+}
+
+inline int vsprintf_s(char* destination, std::size_t size, const char* format, va_list arguments)
+{
+	return std::vsnprintf(destination, size, format, arguments);
+}
+
+#define CP_UTF8							65001
+
+// utf-16 to utf-8 and back for the basic multilingual plane, what text_translate passes through.
+// like the win32 calls, a zero size asks for the length only.
+inline int WideCharToMultiByte(UINT, DWORD, const wchar_t* source, int count, char* destination, int size, const char*, BOOL*)
+{
+	int length = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		const std::uint32_t c	= std::uint32_t(source[i]) & 0xffff;
+		const int bytes			= c < 0x80 ? 1 : c < 0x800 ? 2 : 3;
+
+		if (size && length + bytes <= size)
+		{
+			char* out = destination + length;
+
+			if (bytes == 1)
+				out[0] = char(c);
+			else if (bytes == 2)
+			{
+				out[0] = char(0xc0 | (c >> 6));
+				out[1] = char(0x80 | (c & 0x3f));
+			}
+			else
+			{
+				out[0] = char(0xe0 | (c >> 12));
+				out[1] = char(0x80 | ((c >> 6) & 0x3f));
+				out[2] = char(0x80 | (c & 0x3f));
+			}
+		}
+
+		length += bytes;
+	}
+
+	return length;
+}
+
+inline int MultiByteToWideChar(UINT, DWORD, const char* source, int count, wchar_t* destination, int size)
+{
+	int length = 0;
+
+	for (int i = 0; i < count; length++)
+	{
+		const std::uint8_t lead	= std::uint8_t(source[i]);
+		const int bytes			= lead < 0xc0 ? 1 : lead < 0xe0 ? 2 : 3;
+		std::uint32_t c			= bytes == 1 ? lead : bytes == 2 ? lead & 0x1f : lead & 0x0f;
+
+		for (int j = 1; j < bytes && i + j < count; j++)
+			c = (c << 6) | (std::uint8_t(source[i + j]) & 0x3f);
+
+		if (size && length < size)
+			destination[length] = wchar_t(c);
+
+		i += bytes;
+	}
+
+	return length;
+}
+
+// d3d9 for the renderer, backed by a null device.
+#define D3DFVF_XYZRHW					0x004
+#define D3DFVF_DIFFUSE					0x040
+#define D3DFVF_TEX1						0x100
+
+#define D3DUSAGE_RENDERTARGET			0x00000001L
+#define D3DCLEAR_TARGET					0x00000001L
+
+enum D3DPRIMITIVETYPE
+{
+	D3DPT_LINELIST		= 2,
+	D3DPT_TRIANGLELIST	= 4,
+	D3DPT_TRIANGLESTRIP	= 5
+};
+
+enum D3DFORMAT
+{
+	D3DFMT_A8R8G8B8		= 21,
+	D3DFMT_INDEX16		= 101
+};
+
+enum D3DPOOL
+{
+	D3DPOOL_DEFAULT		= 0
+};
+
+typedef DWORD D3DFVF;
+
+struct D3DVIEWPORT9
+{
+	DWORD	X;
+	DWORD	Y;
+	DWORD	Width;
+	DWORD	Height;
+	float	MinZ;
+	float	MaxZ;
+};
+
+struct D3DRECT
+{
+	LONG x1, y1, x2, y2;
+};
+
+// reference counted like com objects, the last release deletes.
+class null_resource
+{
+public:
+	virtual ~null_resource() { }
+
+	ULONG AddRef() { return ++this->references; }
+
+	ULONG Release()
+	{
+		const ULONG left = --this->references;
+
+		if (left == 0)
+			delete this;
+
+		return left;
+	}
+
+private:
+	ULONG references = 1;
+};
+
+class IDirect3DSurface9 : public null_resource { };
+
+class IDirect3DTexture9 : public null_resource
+{
+public:
+	HRESULT GetSurfaceLevel(UINT, IDirect3DSurface9** surface)
+	{
+		*surface = new IDirect3DSurface9;
+		return S_OK;
+	}
+};
+
+typedef IDirect3DTexture9*	LPDIRECT3DTEXTURE9;
+typedef IDirect3DSurface9*	LPDIRECT3DSURFACE9;
+
+// takes every call the renderer makes and draws nothing. the viewport and the render target are kept,
+// so clipping and surfaces behave, and draw calls are counted for whoever wants to check them.
+class IDirect3DDevice9
+{
+public:
+	IDirect3DDevice9(DWORD width, DWORD height) : viewport{ 0, 0, width, height, 0.f, 1.f }, target(new IDirect3DSurface9) { }
+	~IDirect3DDevice9() { this->target->Release(); }
+
+	IDirect3DDevice9(const IDirect3DDevice9&) = delete;
+	IDirect3DDevice9& operator=(const IDirect3DDevice9&) = delete;
+
+	HRESULT GetViewport(D3DVIEWPORT9* handle) { *handle = this->viewport; return S_OK; }
+	HRESULT SetViewport(const D3DVIEWPORT9* handle) { this->viewport = *handle; return S_OK; }
+
+	HRESULT DrawPrimitiveUP(D3DPRIMITIVETYPE, UINT, const void*, UINT) { this->draw_calls++; return S_OK; }
+	HRESULT DrawIndexedPrimitiveUP(D3DPRIMITIVETYPE, UINT, UINT, UINT, const void*, D3DFORMAT, const void*, UINT) { this->draw_calls++; return S_OK; }
+
+	HRESULT SetTexture(DWORD, IDirect3DTexture9*) { return S_OK; }
+	HRESULT SetFVF(D3DFVF) { return S_OK; }
+	HRESULT Clear(DWORD, const D3DRECT*, DWORD, D3DCOLOR, float, DWORD) { return S_OK; }
+
+	HRESULT CreateTexture(UINT, UINT, UINT, DWORD, D3DFORMAT, D3DPOOL, IDirect3DTexture9** texture, void*)
+	{
+		*texture = new IDirect3DTexture9;
+		return S_OK;
+	}
+
+	HRESULT GetRenderTarget(DWORD, IDirect3DSurface9** surface)
+	{
+		this->target->AddRef();
+		*surface = this->target;
+		return S_OK;
+	}
+
+	HRESULT SetRenderTarget(DWORD, IDirect3DSurface9* surface)
+	{
+		surface->AddRef();
+		this->target->Release();
+		this->target = surface;
+		return S_OK;
+	}
+
+	std::uint64_t draw_calls = 0;
+
+private:
+	D3DVIEWPORT9		viewport;
+	IDirect3DSurface9*	target;		// the back buffer until a surface is set.
+};
+#endif
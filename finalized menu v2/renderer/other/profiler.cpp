@@ -0,0 +1,208 @@
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+
+environment_profiler* profiler = new environment_profiler;
+
+static const std::chrono::steady_clock::time_point profiler_epoch = std::chrono::steady_clock::now();
+
+// scopes currently open on this thread.
+static thread_local std::uint32_t scope_depth = 0;
+
+std::uint64_t environment_profiler::now() const
+{
+	return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profiler_epoch).count());
+}
+
+environment_profiler::thread_buffer* environment_profiler::local()
+{
+	static thread_local thread_buffer* buffer = nullptr;
+
+	if (buffer)
+		return buffer;
+
+	// first event on this thread, the only time recording locks.
+	std::lock_guard<std::mutex> guard(this->lock);
+
+	this->buffers.emplace_back(new thread_buffer);
+	buffer = this->buffers.back().get();
+	buffer->thread = std::uint32_t(this->buffers.size());
+	return buffer;
+}
+
+void environment_profiler::record(const profile_event& event)
+{
+	thread_buffer* buffer = this->local();
+
+	const std::uint64_t head = buffer->head.load(std::memory_order_relaxed);
+
+	// head is the sequence of a seqlock per slot: a reader that sees any of the bytes written below also sees
+	// the head this event will be published over, and knows the slot it copied was being reused.
+	std::atomic_thread_fence(std::memory_order_release);
+
+	buffer->events[head % capacity] = event;
+	buffer->events[head % capacity].thread = buffer->thread;
+
+	// publishes the event to readers.
+	buffer->head.store(head + 1, std::memory_order_release);
+}
+
+std::vector<profile_event> environment_profiler::snapshot() const
+{
+	std::vector<profile_event> events;
+	std::lock_guard<std::mutex> guard(this->lock);
+
+	for (const auto& buffer : this->buffers)
+	{
+		const std::uint64_t head	= buffer->head.load(std::memory_order_acquire);
+		const std::uint64_t tail	= buffer->tail.load(std::memory_order_relaxed);
+		const std::uint64_t first	= std::max<std::uint64_t>(tail, head > capacity ? head - capacity : 0);
+		const std::size_t copied	= events.size();
+
+		for (std::uint64_t i = first; i < head; i++)
+			events.push_back(buffer->events[i % capacity]);
+
+		// the owner keeps recording while this copies and may lap it any number of times. whatever it can
+		// have started writing by now, up to and including event `after`, is dropped instead of read torn.
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		const std::uint64_t after	= buffer->head.load(std::memory_order_relaxed);
+		const std::uint64_t valid	= after + 1 > capacity ? after + 1 - capacity : 0;
+
+		if (valid > first)
+			events.erase(events.begin() + std::ptrdiff_t(copied), events.begin() + std::ptrdiff_t(copied + std::min<std::uint64_t>(valid - first, head - first)));
+	}
+
+	return events;
+}
+
+std::vector<profile_total> environment_profiler::totals(profile_group group) const
+{
+	const std::vector<profile_event> events = this->snapshot();
+
+	// self time: a scope finishes after everything nested in it, so per thread the time of finished children
+	// is summed per depth and taken off their parent when it finishes.
+	std::map<std::uint32_t, std::vector<std::uint64_t>> children;
+	std::map<std::string, profile_total> sums;
+
+	for (const auto& event : events)
+	{
+		std::vector<std::uint64_t>& nested = children[event.thread];
+
+		if (nested.size() < event.depth + 2)
+			nested.resize(event.depth + 2, 0);
+
+		const std::uint64_t inner = std::min<std::uint64_t>(nested[event.depth + 1], event.duration);
+		nested[event.depth + 1]	= 0;
+		nested[event.depth]		+= event.duration;
+
+		const char* key = group == profile_group::category ? event.category : group == profile_group::window ? event.window : event.name;
+
+		if (!key)
+			key = "-";
+
+		profile_total& total = sums[key];
+		total.key	= key;
+		total.count++;
+		total.total	+= event.duration;
+		total.self	+= event.duration - inner;
+		total.max	= std::max<std::uint64_t>(total.max, event.duration);
+	}
+
+	std::vector<profile_total> result;
+
+	for (const auto& sum : sums)
+		result.push_back(sum.second);
+
+	std::sort(result.begin(), result.end(), [](const profile_total& a, const profile_total& b) {
+		return a.total > b.total;
+		});
+
+	return result;
+}
+
+// names are widget titles, keep the json valid whatever they contain.
+static void write_string(std::FILE* file, const char* text)
+{
+	std::fputc('"', file);
+
+	for (; text && *text; text++)
+	{
+		const unsigned char c = static_cast<unsigned char>(*text);
+
+		if (c == '"' || c == '\\')
+			std::fprintf(file, "\\%c", c);
+		else if (c < 0x20)
+			std::fprintf(file, "\\u%04x", c);
+		else
+			std::fputc(c, file);
+	}
+
+	std::fputc('"', file);
+}
+
+bool environment_profiler::export_trace(const char* path) const
+{
+	std::FILE* file = std::fopen(path, "wb");
+
+	if (!file)
+		return false;
+
+	const std::vector<profile_event> events = this->snapshot();
+
+	std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+
+	for (std::size_t i = 0; i < events.size(); i++)
+	{
+		const profile_event& event = events[i];
+
+		// complete events, timestamps in microseconds.
+		std::fputs(i ? ",\n{\"name\":" : "\n{\"name\":", file);
+		write_string(file, event.name);
+		std::fputs(",\"cat\":", file);
+		write_string(file, event.category);
+		std::fprintf(file, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u", event.start / 1000.0, event.duration / 1000.0, event.thread);
+
+		if (event.window)
+		{
+			std::fputs(",\"args\":{\"window\":", file);
+			write_string(file, event.window);
+			std::fputc('}', file);
+		}
+
+		std::fputc('}', file);
+	}
+
+	std::fputs("\n]}\n", file);
+	return std::fclose(file) == 0;
+}
+
+void environment_profiler::clear()
+{
+	std::lock_guard<std::mutex> guard(this->lock);
+
+	for (const auto& buffer : this->buffers)
+		buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+profile_scope::profile_scope(const char* name, const char* category, const char* window)
+{
+	this->event.name		= name;
+	this->event.category	= category;
+	this->event.window		= window;
+	this->event.depth		= scope_depth++;
+	this->event.thread		= 0;
+	this->event.duration	= 0;
+	this->event.start		= profiler->now();
+}
+
+profile_scope::~profile_scope()
+{
+	this->event.duration = profiler->now() - this->event.start;
+	scope_depth--;
+
+	profiler->record(this->event);
+}
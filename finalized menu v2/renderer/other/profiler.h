@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/*
+* scoped cpu profiler.
+* PROFILE_SCOPE / PROFILE_ELEMENT time the enclosing scope and write one event into a ring buffer owned by
+* the calling thread, so recording never takes a lock. the buffers can be exported as chrome trace json
+* (chrome://tracing, ui.perfetto.dev) or aggregated per subsystem / widget type, per window or per name.
+* without PROFILER defined every macro compiles to nothing.
+*/
+
+// one finished scope. names are static strings or widget titles, both outlive the profiler's use of them.
+struct profile_event
+{
+	const char*		name;
+	const char*		category;		// subsystem or widget type.
+	const char*		window;			// title of the window the scope ran under, nullptr outside the gui.
+	std::uint64_t	start;			// nanoseconds since the profiler started.
+	std::uint64_t	duration;
+	std::uint32_t	thread;
+	std::uint32_t	depth;			// scopes open on the thread when this one started.
+};
+
+enum class profile_group : int
+{
+	category,
+	window,
+	name
+};
+
+// summed events sharing a key. self time leaves out the time spent in nested scopes.
+struct profile_total
+{
+	const char*		key;
+	std::size_t		count	= 0;
+	std::uint64_t	total	= 0;
+	std::uint64_t	self	= 0;
+	std::uint64_t	max		= 0;
+};
+
+class environment_profiler
+{
+public:
+	// events each thread keeps, older ones get overwritten.
+	static constexpr std::size_t capacity = 1 << 16;
+
+	std::uint64_t now() const;
+
+	void record(const profile_event& event);
+
+	// every event still held, per thread in the order they finished. safe while other threads record, events
+	// their owner overwrote during the copy are left out rather than returned half written.
+	std::vector<profile_event> snapshot() const;
+
+	// totals sorted by total time, largest first.
+	std::vector<profile_total> totals(profile_group group) const;
+
+	bool export_trace(const char* path) const;
+
+	// drops what was recorded so far, threads keep their buffers.
+	void clear();
+
+private:
+	struct thread_buffer
+	{
+		std::array<profile_event, capacity>	events;
+		std::atomic<std::uint64_t>			head{ 0 };	// events ever written, only the owner stores it.
+		std::atomic<std::uint64_t>			tail{ 0 };	// events before this were cleared.
+		std::uint32_t						thread = 0;
+	};
+
+	thread_buffer* local();
+
+	mutable std::mutex							lock;		// guards buffers, only taken when a thread records its first event.
+	std::vector<std::unique_ptr<thread_buffer>>	buffers;
+};
+
+extern environment_profiler* profiler;
+
+// times its own lifetime.
+class profile_scope
+{
+public:
+	profile_scope(const char* name, const char* category, const char* window = nullptr);
+	~profile_scope();
+
+	profile_scope(const profile_scope&) = delete;
+	profile_scope& operator=(const profile_scope&) = delete;
+
+private:
+	profile_event event;
+};
+
+#ifdef PROFILER
+#define PROFILE_JOIN_INNER(a, b)				a##b
+#define PROFILE_JOIN(a, b)						PROFILE_JOIN_INNER(a, b)
+#define PROFILE_SCOPE(name, category)			profile_scope PROFILE_JOIN(profile_, __LINE__)(name, category)
+// inside element members: the widget's title under its type, attributed to the window it belongs to.
+#define PROFILE_ELEMENT(type)					profile_scope PROFILE_JOIN(profile_, __LINE__)(this->title ? this->title : type, type, this->window_title())
+#else
+#define PROFILE_SCOPE(name, category)			((void)0)
+#define PROFILE_ELEMENT(type)					((void)0)
+#endif
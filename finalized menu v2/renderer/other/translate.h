@@ -1,5 +1,8 @@
 #pragma once
-#include <Windows.h>
+#include "platform.h"
+#include "allocations.h"
+#include <cstdarg>
+#include <cstring>
 #include <string>
 #include <algorithm>
 #include <sstream>
@@ -63,7 +66,7 @@ public:
 	std::string binary(unsigned char* binary_data)
 	{
 		std::string ascii_data;
-		std::stringstream ss(*binary_data);
+		std::stringstream ss(reinterpret_cast<const char*>(binary_data));
 
 		while (ss.good()) 
 		{
@@ -85,6 +88,8 @@ public:
 		va_list arguments;
 		va_start(arguments, layout);
 		vsprintf_s(buffer, sizeof(buffer), layout, arguments);
+
+		memory_scope memory(memory_tag::strings);
 		std::string result = buffer;
 		va_end(arguments);
 
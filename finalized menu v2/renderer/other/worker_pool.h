@@ -0,0 +1,105 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// small fixed-size thread pool for startup work (glyph rasterization, atlas conversion).
+// jobs must not touch the device, uploads stay on the thread that owns it.
+class worker_pool
+{
+public:
+	explicit worker_pool(unsigned count = std::thread::hardware_concurrency())
+	{
+		// hardware_concurrency is allowed to report 0.
+		if (count == 0)
+			count = 1;
+
+		for (unsigned i = 0; i < count; i++)
+			this->threads.emplace_back([this]() { this->worker(); });
+	}
+
+	~worker_pool()
+	{
+		{
+			std::lock_guard<std::mutex> guard(this->lock);
+			this->stopping = true;
+		}
+
+		this->wake.notify_all();
+
+		for (auto& thread : this->threads)
+			thread.join();
+	}
+
+	worker_pool(const worker_pool&) = delete;
+	worker_pool& operator=(const worker_pool&) = delete;
+
+	unsigned size() const { return unsigned(this->threads.size()); }
+
+	void push(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> guard(this->lock);
+			this->jobs.push_back(std::move(job));
+		}
+
+		this->wake.notify_one();
+	}
+
+	// blocks until every queued job has finished.
+	void wait()
+	{
+		std::unique_lock<std::mutex> guard(this->lock);
+		this->idle.wait(guard, [this]() { return this->jobs.empty() && this->busy == 0; });
+	}
+
+	// runs body(0 .. count - 1) across the pool and waits for all of them.
+	void for_each(int count, const std::function<void(int)>& body)
+	{
+		for (int i = 0; i < count; i++)
+			this->push([&body, i]() { body(i); });
+
+		this->wait();
+	}
+
+private:
+	void worker()
+	{
+		for (;;)
+		{
+			std::function<void()> job;
+
+			{
+				std::unique_lock<std::mutex> guard(this->lock);
+				this->wake.wait(guard, [this]() { return this->stopping || !this->jobs.empty(); });
+
+				if (this->jobs.empty())
+					return;
+
+				job = std::move(this->jobs.front());
+				this->jobs.pop_front();
+				this->busy++;
+			}
+
+			job();
+
+			{
+				std::lock_guard<std::mutex> guard(this->lock);
+				this->busy--;
+			}
+
+			this->idle.notify_all();
+		}
+	}
+
+	std::vector<std::thread>			threads;
+	std::deque<std::function<void()>>	jobs;
+	std::mutex							lock;
+	std::condition_variable				wake;
+	std::condition_variable				idle;
+	int									busy		= 0;
+	bool								stopping	= false;
+};
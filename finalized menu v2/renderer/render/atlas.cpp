@@ -0,0 +1,517 @@
+#include "atlas.h"
+#include "draw_list.h"
+#include "stats.h"
+#include "font.h"
+#include "../other/allocations.h"
+#include "../other/profiler.h"
+#include "../other/worker_pool.h"
+#include <algorithm>
+#include <cstring>
+
+environment_atlas* atlas = new environment_atlas;
+
+// text vertices the shared vertex buffer holds before a batch has to be split.
+#define MAX_NUM_VERTICES (1024 * 6)
+
+// smallest page we bother creating.
+#define MIN_PAGE_SIZE 256
+
+// rows converted per job, keeps jobs coarse enough that queueing them is noise.
+#define CONVERT_ROWS 64
+
+void atlas_packer::reset(int width, int height)
+{
+	this->width		= width;
+	this->height	= height;
+
+	// start with a single flat skyline spanning the whole page.
+	this->nodes.clear();
+	this->nodes.push_back({ 0, 0, width });
+}
+
+int atlas_packer::fit(std::size_t index, int w, int h)
+{
+	int x = this->nodes[index].x;
+
+	if (x + w > this->width)
+		return -1;
+
+	// the rect rests on the tallest node it spans.
+	int y			= this->nodes[index].y;
+	int remaining	= w;
+
+	for (std::size_t i = index; remaining > 0; i++)
+	{
+		if (i >= this->nodes.size())
+			return -1;
+
+		y			= std::max<int>(y, this->nodes[i].y);
+		remaining  -= this->nodes[i].w;
+	}
+
+	if (y + h > this->height)
+		return -1;
+
+	return y;
+}
+
+bool atlas_packer::insert(int w, int h, int& x, int& y)
+{
+	int best_index	= -1;
+	int best_y		= 0;
+	int best_w		= 0;
+
+	// bottom-left: lowest resting point wins, narrowest node breaks ties.
+	for (std::size_t i = 0; i < this->nodes.size(); i++)
+	{
+		int fit_y = this->fit(i, w, h);
+
+		if (fit_y < 0)
+			continue;
+
+		if (best_index < 0 || fit_y < best_y || (fit_y == best_y && this->nodes[i].w < best_w))
+		{
+			best_index	= int(i);
+			best_y		= fit_y;
+			best_w		= this->nodes[i].w;
+		}
+	}
+
+	if (best_index < 0)
+		return false;
+
+	x = this->nodes[best_index].x;
+	y = best_y;
+
+	// raise the skyline under the new rect.
+	this->nodes.insert(this->nodes.begin() + best_index, { x, y + h, w });
+
+	for (std::size_t i = best_index + 1; i < this->nodes.size(); i++)
+	{
+		skyline& previous	= this->nodes[i - 1];
+		skyline& node		= this->nodes[i];
+
+		if (node.x >= previous.x + previous.w)
+			break;
+
+		int shrink = previous.x + previous.w - node.x;
+		node.x += shrink;
+		node.w -= shrink;
+
+		if (node.w > 0)
+			break;
+
+		this->nodes.erase(this->nodes.begin() + i);
+		i--;
+	}
+
+	// merge neighbours sitting at the same height.
+	for (std::size_t i = 0; i + 1 < this->nodes.size(); i++)
+	{
+		if (this->nodes[i].y != this->nodes[i + 1].y)
+			continue;
+
+		this->nodes[i].w += this->nodes[i + 1].w;
+		this->nodes.erase(this->nodes.begin() + i + 1);
+		i--;
+	}
+
+	return true;
+}
+
+void environment_atlas::add(environment_font* font)
+{
+	if (!font)
+		return;
+
+	this->fonts.push_back(font);
+}
+
+void environment_atlas::build(int max_size)
+{
+	memory_scope memory(memory_tag::font);
+
+	struct item
+	{
+		environment_font*	font;
+		int					index;
+		int					w, h;
+	};
+
+	std::vector<item> remaining;
+
+	for (auto font : this->fonts)
+	{
+		for (int i = 0; i < 128 - 32; i++)
+		{
+			const atlas_bitmap& glyph = font->glyphs[i];
+
+			// keep a pixel of padding so filtered text doesn't bleed into neighbours.
+			if (glyph.w > 0 && glyph.h > 0)
+				remaining.push_back({ font, i, glyph.w + 1, glyph.h + 1 });
+		}
+	}
+
+	// tallest first keeps the skyline flat.
+	std::sort(remaining.begin(), remaining.end(), [](const item& a, const item& b) {
+		return a.h != b.h ? a.h > b.h : a.w > b.w;
+		});
+
+	this->pages.clear();
+	atlas_packer packer;
+
+	while (!remaining.empty())
+	{
+		// find the smallest page that holds everything left, otherwise fill a page of the largest size.
+		int size = std::min<int>(MIN_PAGE_SIZE, max_size);
+		std::vector<std::pair<int, int>> placed;
+
+		for (;; size *= 2)
+		{
+			size = std::min<int>(size, max_size);
+			packer.reset(size, size);
+			placed.clear();
+
+			for (const auto& handle : remaining)
+			{
+				int x = -1, y = -1;
+				packer.insert(handle.w, handle.h, x, y);
+				placed.push_back({ x, y });
+			}
+
+			bool fits = std::all_of(placed.begin(), placed.end(), [](const std::pair<int, int>& p) { return p.first >= 0; });
+
+			if (fits || size >= max_size)
+				break;
+		}
+
+		atlas_page page;
+		page.size	= size;
+		page.pixels.assign(std::size_t(size) * size, 0);
+
+		std::vector<item> leftover;
+		const int page_index = int(this->pages.size());
+
+		for (std::size_t i = 0; i < remaining.size(); i++)
+		{
+			const item& handle	= remaining[i];
+			const int x			= placed[i].first;
+			const int y			= placed[i].second;
+
+			if (x < 0)
+			{
+				leftover.push_back(handle);
+				continue;
+			}
+
+			const atlas_bitmap& glyph = handle.font->glyphs[handle.index];
+
+			// copy the glyph cell into the page.
+			for (int row = 0; row < glyph.h; row++)
+				std::copy_n(&glyph.pixels[std::size_t(row) * glyph.w], glyph.w, &page.pixels[std::size_t(y + row) * size + x]);
+
+			page.used += std::size_t(glyph.w) * glyph.h;
+
+			handle.font->iTexPage[handle.index]		= page_index;
+			handle.font->fTexCoords[handle.index][0] = float(x) / size;
+			handle.font->fTexCoords[handle.index][1] = float(y) / size;
+			handle.font->fTexCoords[handle.index][2] = float(x + glyph.w) / size;
+			handle.font->fTexCoords[handle.index][3] = float(y + glyph.h) / size;
+		}
+
+		// a glyph larger than the largest page can never be placed, drop it instead of looping forever.
+		if (leftover.size() == remaining.size())
+			break;
+
+		this->pages.push_back(std::move(page));
+		remaining = std::move(leftover);
+	}
+}
+
+void environment_atlas::set_format(atlas_format format)
+{
+	if (format == this->format)
+		return;
+
+	this->format = format;
+
+	for (auto& page : this->pages)
+		page.texels.clear();
+}
+
+void environment_atlas::convert(worker_pool* workers)
+{
+	memory_scope memory(memory_tag::font);
+
+	struct band
+	{
+		atlas_page*	page;
+		int			row;
+	};
+
+	std::vector<band> bands;
+	const std::size_t texel_size = std::size_t(atlas_format_size(this->format));
+
+	for (auto& page : this->pages)
+	{
+		page.texels.resize(page.pixels.size() * texel_size);
+
+		for (int row = 0; row < page.size; row += CONVERT_ROWS)
+			bands.push_back({ &page, row });
+	}
+
+	auto convert_band = [this, &bands, texel_size](int index)
+	{
+		atlas_page& page		= *bands[index].page;
+		const std::size_t first	= std::size_t(bands[index].row) * page.size;
+		const std::size_t last	= std::size_t(std::min<int>(bands[index].row + CONVERT_ROWS, page.size)) * page.size;
+
+		convert_coverage(this->format, &page.pixels[first], &page.texels[first * texel_size], last - first);
+	};
+
+	if (workers)
+		workers->for_each(int(bands.size()), convert_band);
+	else
+	{
+		for (int i = 0; i < int(bands.size()); i++)
+			convert_band(i);
+	}
+}
+
+#ifdef _WIN32
+HRESULT environment_atlas::setup_device_objects(LPDIRECT3DDEVICE9 device)
+{
+	this->device = device;
+
+	D3DFORMAT texture_format = D3DFMT_A4R4G4B4;
+
+	if (this->format == atlas_format::a8)
+		texture_format = D3DFMT_A8;
+	else if (this->format == atlas_format::a8r8g8b8)
+		texture_format = D3DFMT_A8R8G8B8;
+
+	for (auto& page : this->pages)
+	{
+		const std::size_t row_size = std::size_t(page.size) * atlas_format_size(this->format);
+
+		// pages that were never converted (or changed format) are converted here on the device thread.
+		if (page.texels.size() != std::size_t(page.size) * row_size)
+			this->convert();
+
+		HRESULT hr = this->device->CreateTexture(page.size, page.size, 1, D3DUSAGE_DYNAMIC, texture_format, D3DPOOL_DEFAULT, &page.texture, nullptr);
+
+		if (FAILED(hr))
+			return hr;
+
+		// lock the surface and copy the converted rows in.
+		D3DLOCKED_RECT locked;
+		page.texture->LockRect(0, &locked, nullptr, 0);
+		BYTE* destination_row = (BYTE*)locked.pBits;
+
+		for (int y = 0; y < page.size; y++)
+		{
+			std::memcpy(destination_row, &page.texels[std::size_t(y) * row_size], row_size);
+			destination_row += locked.Pitch;
+		}
+
+		page.texture->UnlockRect(0);
+	}
+
+	return S_OK;
+}
+
+HRESULT environment_atlas::restore_device_objects()
+{
+	HRESULT hr;
+
+	// create vertex buffer for the letters.
+	if (FAILED(hr = this->device->CreateVertexBuffer(MAX_NUM_VERTICES * sizeof(FONT2DVERTEX), D3DUSAGE_WRITEONLY | D3DUSAGE_DYNAMIC, 0, D3DPOOL_DEFAULT, &this->vertex_buffer, nullptr)))
+		return hr;
+
+	// create the state blocks for rendering text, the page texture is bound per batch.
+	for (UINT which = 0; which < 2; which++)
+	{
+		this->device->BeginStateBlock();
+		this->device->SetTexture(0, nullptr);
+		this->device->SetRenderState(D3DRS_ZENABLE, FALSE);
+		this->device->SetRenderState(D3DRS_ALPHABLENDENABLE, TRUE);
+		this->device->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
+		this->device->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
+		this->device->SetRenderState(D3DRS_ALPHATESTENABLE, TRUE);
+		this->device->SetRenderState(D3DRS_ALPHAREF, 0x08);
+		this->device->SetRenderState(D3DRS_ALPHAFUNC, D3DCMP_GREATEREQUAL);
+		this->device->SetRenderState(D3DRS_FILLMODE, D3DFILL_SOLID);
+		this->device->SetRenderState(D3DRS_CULLMODE, D3DCULL_CCW);
+		this->device->SetRenderState(D3DRS_STENCILENABLE, FALSE);
+		this->device->SetRenderState(D3DRS_CLIPPING, TRUE);
+		this->device->SetRenderState(D3DRS_CLIPPLANEENABLE, FALSE);
+		this->device->SetRenderState(D3DRS_VERTEXBLEND, D3DVBF_DISABLE);
+		this->device->SetRenderState(D3DRS_INDEXEDVERTEXBLENDENABLE, FALSE);
+		this->device->SetRenderState(D3DRS_FOGENABLE, FALSE);
+		this->device->SetRenderState(D3DRS_COLORWRITEENABLE, D3DCOLORWRITEENABLE_RED | D3DCOLORWRITEENABLE_GREEN | D3DCOLORWRITEENABLE_BLUE | D3DCOLORWRITEENABLE_ALPHA);
+		// alpha-only pages have no colour to modulate with, take the vertex colour as is.
+		this->device->SetTextureStageState(0, D3DTSS_COLOROP, this->format == atlas_format::a8 ? D3DTOP_SELECTARG2 : D3DTOP_MODULATE);
+		this->device->SetTextureStageState(0, D3DTSS_COLORARG1, D3DTA_TEXTURE);
+		this->device->SetTextureStageState(0, D3DTSS_COLORARG2, D3DTA_DIFFUSE);
+		this->device->SetTextureStageState(0, D3DTSS_ALPHAOP, D3DTOP_MODULATE);
+		this->device->SetTextureStageState(0, D3DTSS_ALPHAARG1, D3DTA_TEXTURE);
+		this->device->SetTextureStageState(0, D3DTSS_ALPHAARG2, D3DTA_DIFFUSE);
+		this->device->SetTextureStageState(0, D3DTSS_TEXCOORDINDEX, 0);
+		this->device->SetTextureStageState(0, D3DTSS_TEXTURETRANSFORMFLAGS, D3DTTFF_DISABLE);
+		this->device->SetTextureStageState(1, D3DTSS_COLOROP, D3DTOP_DISABLE);
+		this->device->SetTextureStageState(1, D3DTSS_ALPHAOP, D3DTOP_DISABLE);
+		this->device->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_POINT);
+		this->device->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_POINT);
+		this->device->SetSamplerState(0, D3DSAMP_MIPFILTER, D3DTEXF_NONE);
+
+		if (which == 0)
+			this->device->EndStateBlock(&this->state_saved);
+		else
+			this->device->EndStateBlock(&this->state_draw);
+	}
+
+	return S_OK;
+}
+
+HRESULT environment_atlas::invalidate_device_objects()
+{
+	// anything still queued belongs to the old device.
+	this->batch.clear();
+	this->batch_page = -1;
+
+	SAFE_RELEASE(this->vertex_buffer);
+	SAFE_RELEASE(this->state_saved);
+	SAFE_RELEASE(this->state_draw);
+
+	return S_OK;
+}
+
+HRESULT environment_atlas::delete_device_objects()
+{
+	for (auto& page : this->pages)
+		SAFE_RELEASE(page.texture);
+
+	this->device = nullptr;
+
+	return S_OK;
+}
+#endif
+
+void environment_atlas::push(int page, bool filtered, const FONT2DVERTEX* vertices, int count)
+{
+	if (this->capture)
+	{
+		this->capture->add_text(page, filtered, vertices, count);
+		return;
+	}
+
+	// a different page or filter needs different states, send what we have first.
+	if (!this->batch.empty() && (page != this->batch_page || filtered != this->batch_filtered))
+		this->flush();
+
+	this->batch_page		= page;
+	this->batch_filtered	= filtered;
+
+	memory_scope memory(memory_tag::render_vertices);
+	this->batch.insert(this->batch.end(), vertices, vertices + count);
+
+	statistics->current().glyphs += std::uint32_t(count / 6);
+}
+
+void environment_atlas::flush()
+{
+	if (this->batch.empty())
+		return;
+
+	PROFILE_SCOPE("flush", "atlas");
+
+#ifdef _WIN32
+	if (!this->device || !this->vertex_buffer || this->batch_page < 0 || this->batch_page >= int(this->pages.size()))
+	{
+		this->batch.clear();
+		return;
+	}
+
+	// set up renderstate.
+	this->state_saved->Capture();
+	this->state_draw->Apply();
+	this->device->SetTexture(0, this->pages[this->batch_page].texture);
+
+	// the draw state block going on and the saved one coming back, plus the page texture.
+	statistics->current().state_changes		+= 2;
+	statistics->current().texture_switches	+= 1;
+	this->device->SetFVF(D3DFVF_FONT2DVERTEX);
+	this->device->SetPixelShader(nullptr);
+	this->device->SetStreamSource(0, this->vertex_buffer, 0, sizeof(FONT2DVERTEX));
+
+	// set filter states.
+	if (this->batch_filtered)
+	{
+		this->device->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_LINEAR);
+		this->device->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR);
+	}
+
+	// upload and draw, only split when the batch outgrows the vertex buffer.
+	for (std::size_t offset = 0; offset < this->batch.size(); offset += MAX_NUM_VERTICES)
+	{
+		const std::size_t count = std::min<std::size_t>(MAX_NUM_VERTICES, this->batch.size() - offset);
+
+		FONT2DVERTEX* vertices = nullptr;
+		this->vertex_buffer->Lock(0, UINT(count * sizeof(FONT2DVERTEX)), (void**)&vertices, D3DLOCK_DISCARD);
+		std::copy_n(this->batch.data() + offset, count, vertices);
+		this->vertex_buffer->Unlock();
+
+		this->device->DrawPrimitive(D3DPT_TRIANGLELIST, 0, UINT(count / 3));
+		statistics->draw(count, sizeof(FONT2DVERTEX));
+
+		if (offset > 0)
+			statistics->current().overflow_flushes++;
+	}
+
+	// restore the modified renderstates.
+	this->state_saved->Apply();
+#else
+	// no device to draw with, count the batch as the device path would so headless runs see the same batching.
+	statistics->current().state_changes		+= 2;
+	statistics->current().texture_switches	+= 1;
+
+	for (std::size_t offset = 0; offset < this->batch.size(); offset += MAX_NUM_VERTICES)
+	{
+		statistics->draw(std::min<std::size_t>(MAX_NUM_VERTICES, this->batch.size() - offset), sizeof(FONT2DVERTEX));
+
+		if (offset > 0)
+			statistics->current().overflow_flushes++;
+	}
+#endif
+
+	this->batch.clear();
+}
+
+atlas_occupancy environment_atlas::occupancy()
+{
+	atlas_occupancy result;
+	result.pages = int(this->pages.size());
+
+	for (const auto& page : this->pages)
+	{
+		result.used		+= page.used;
+		result.total	+= std::size_t(page.size) * page.size;
+	}
+
+	// what the old one-texture-per-font sizing would have allocated.
+	for (auto font : this->fonts)
+	{
+		std::size_t size = 256;
+
+		if (font->dwFontHeight > 60)
+			size = 2048;
+		else if (font->dwFontHeight > 30)
+			size = 1024;
+		else if (font->dwFontHeight > 15)
+			size = 512;
+
+		result.legacy += size * size;
+	}
+
+	return result;
+}
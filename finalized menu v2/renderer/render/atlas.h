@@ -0,0 +1,139 @@
+#pragma once
+#include "../other/platform.h"
+#include "convert.h"
+#include <cstdint>
+#include <vector>
+
+/*
+* shared glyph atlas.
+* every registered font rasterizes its glyphs into small coverage bitmaps, the atlas packs all of them
+* into as few pages as possible using a skyline packer and owns the page textures.
+* since every font samples from the same page, text drawn in different fonts can share one draw call.
+* packing and batching are portable, only the page textures and the draw itself need d3d9.
+*/
+
+// text vertex, shared by every font drawing into the atlas batch.
+struct FONT2DVERTEX
+{
+	FLOAT	x, y, z, rhw;
+	DWORD	color;
+	FLOAT	tu, tv;
+};
+
+#define D3DFVF_FONT2DVERTEX (D3DFVF_XYZRHW | D3DFVF_DIFFUSE | D3DFVF_TEX1)
+
+inline FONT2DVERTEX InitFont2DVertex(FLOAT x, FLOAT y, D3DCOLOR color, FLOAT tu, FLOAT tv)
+{
+	FONT2DVERTEX v;
+	v.x		= x;
+	v.y		= y;
+	v.z		= 1.0f;
+	v.rhw	= 1.0f;
+	v.color = color;
+	v.tu	= tu;
+	v.tv	= tv;
+	return v;
+}
+
+// single glyph cell rasterized by a font, 8-bit coverage.
+struct atlas_bitmap
+{
+	int							w = 0;
+	int							h = 0;
+	std::vector<std::uint8_t>	pixels;
+};
+
+// skyline bottom-left rectangle packer.
+class atlas_packer
+{
+public:
+	void reset(int width, int height);
+	bool insert(int w, int h, int& x, int& y);
+
+private:
+	struct skyline
+	{
+		int x, y, w;
+	};
+
+	// returns the lowest y a rect of width w can sit at when placed on node index, or -1 if it doesn't fit.
+	int fit(std::size_t index, int w, int h);
+
+	std::vector<skyline>	nodes;
+	int						width	= 0;
+	int						height	= 0;
+};
+
+struct atlas_page
+{
+	int							size	= 0;
+	std::size_t					used	= 0;	// pixels covered by glyph cells.
+	std::vector<std::uint8_t>	pixels;			// 8-bit coverage, kept so device resets don't re-rasterize.
+	std::vector<std::uint8_t>	texels;			// pixels in the atlas format, converted off the device thread so uploads are a copy.
+#ifdef _WIN32
+	LPDIRECT3DTEXTURE9			texture = nullptr;
+#endif
+};
+
+struct atlas_occupancy
+{
+	int			pages	= 0;
+	std::size_t used	= 0;	// pixels covered by glyph cells.
+	std::size_t total	= 0;	// pixels allocated by atlas pages.
+	std::size_t legacy	= 0;	// pixels the old texture-per-font layout would have allocated.
+
+	float ratio() const { return this->total ? float(this->used) / float(this->total) : 0.f; }
+};
+
+class environment_font;
+class worker_pool;
+class draw_list;
+class environment_atlas
+{
+public:
+	void add(environment_font* font);
+	void build(int max_size);
+
+	// texture format the pages get uploaded in, set it before the device objects are created.
+	void set_format(atlas_format format);
+	atlas_format get_format() const { return this->format; }
+
+	// convert every page into its texture format, spread across the pool when one is given.
+	void convert(worker_pool* workers = nullptr);
+
+#ifdef _WIN32
+	HRESULT setup_device_objects(LPDIRECT3DDEVICE9 device);
+	HRESULT restore_device_objects();
+	HRESULT invalidate_device_objects();
+	HRESULT delete_device_objects();
+#endif
+
+	// queue glyph vertices, consecutive text calls sharing a page and filter end up in one draw call.
+	void push(int page, bool filtered, const FONT2DVERTEX* vertices, int count);
+	void flush();
+
+	// while set, pushed glyphs are recorded into the list instead of being batched for the device.
+	void set_capture(draw_list* list) { this->capture = list; }
+
+	atlas_occupancy occupancy();
+
+private:
+	std::vector<environment_font*>	fonts;
+	std::vector<atlas_page>			pages;
+	atlas_format					format					= atlas_format::a4r4g4b4;
+
+#ifdef _WIN32
+	LPDIRECT3DDEVICE9				device					= nullptr;
+	LPDIRECT3DVERTEXBUFFER9			vertex_buffer			= nullptr;
+	LPDIRECT3DSTATEBLOCK9			state_saved				= nullptr;
+	LPDIRECT3DSTATEBLOCK9			state_draw				= nullptr;
+#endif
+
+	// pending text batch.
+	std::vector<FONT2DVERTEX>		batch;
+	int								batch_page				= -1;
+	bool							batch_filtered			= false;
+	draw_list*						capture					= nullptr;
+};
+
+extern environment_atlas* atlas;
@@ -0,0 +1,241 @@
+#include "batch.h"
+#include <algorithm>
+#include <cmath>
+
+// writes one quad in triangle strip order, which the shared index list turns into two triangles.
+static vertex* emit_quad(vertex* out, int x, int y, int w, int h, DWORD colour)
+{
+	out[0] = vertex({ x - 0.5f, y - 0.5f }, { 0.f, 1.f }, colour);
+	out[1] = vertex({ x + w - 0.5f, y - 0.5f }, { 0.f, 1.f }, colour);
+	out[2] = vertex({ x - 0.5f, y + h - 0.5f }, { 0.f, 1.f }, colour);
+	out[3] = vertex({ x + w - 0.5f, y + h - 0.5f }, { 0.f, 1.f }, colour);
+
+	return out + 4;
+}
+
+const std::vector<std::uint16_t>& rect_batch::quad_indices()
+{
+	static const std::vector<std::uint16_t> indices = []() {
+		std::vector<std::uint16_t> list(max_batch_quads * 6);
+
+		for (std::size_t i = 0; i < max_batch_quads; i++)
+		{
+			const std::uint16_t first = std::uint16_t(i * 4);
+
+			list[i * 6 + 0] = first + 0;
+			list[i * 6 + 1] = first + 1;
+			list[i * 6 + 2] = first + 2;
+			list[i * 6 + 3] = first + 2;
+			list[i * 6 + 4] = first + 1;
+			list[i * 6 + 5] = first + 3;
+		}
+
+		return list;
+	}();
+
+	return indices;
+}
+
+void rect_batch::filled(const rect_instance* rects, std::size_t count, std::vector<vertex>& vertices)
+{
+	const std::size_t first = vertices.size();
+	vertices.resize(first + count * 4);
+
+	vertex* out = vertices.data() + first;
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const rect& area = rects[i].area;
+		out = emit_quad(out, area.x, area.y, area.w, area.h, rects[i].colour.argb());
+	}
+}
+
+void rect_batch::outlined(const rect_instance* rects, std::size_t count, std::vector<vertex>& vertices)
+{
+	const std::size_t first = vertices.size();
+	vertices.resize(first + count * 16);
+
+	vertex* out = vertices.data() + first;
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const rect& area	= rects[i].area;
+		const DWORD colour	= rects[i].colour.argb();
+
+		// top, left, right, bottom, in the order outlined_rect draws them.
+		out = emit_quad(out, area.x, area.y, area.w, 1, colour);
+		out = emit_quad(out, area.x, area.y, 1, area.h, colour);
+		out = emit_quad(out, area.x + area.w - 1, area.y, 1, area.h, colour);
+		out = emit_quad(out, area.x, area.y + area.h - 1, area.w, 1, colour);
+	}
+}
+
+// unit normal of the segment a -> b, zero for a degenerate segment.
+static vector_2d segment_normal(const vector_2d& a, const vector_2d& b)
+{
+	const float dx		= b.x - a.x;
+	const float dy		= b.y - a.y;
+	const float length	= std::sqrt(dx * dx + dy * dy);
+
+	if (length <= 1e-6f)
+		return { 0.f, 0.f };
+
+	return { -dy / length, dx / length };
+}
+
+/*
+* normal to offset point i by, miter joined with its neighbours.
+* the averaged normal shrinks with the turn angle, dividing by its squared length restores the miter length,
+* which is clipped to miter_limit half widths so sharp turns don't spike.
+*/
+static vector_2d join_normal(const vector_2d* points, std::size_t count, std::size_t i, bool closed)
+{
+	const float miter_limit = 4.f;
+
+	const bool has_previous	= closed || i > 0;
+	const bool has_next		= closed || i + 1 < count;
+
+	const vector_2d previous	= has_previous ? segment_normal(points[(i + count - 1) % count], points[i]) : vector_2d();
+	const vector_2d next		= has_next ? segment_normal(points[i], points[(i + 1) % count]) : vector_2d();
+
+	// open ends and repeated points only have the one segment to go by.
+	if (!has_previous || (previous.x == 0.f && previous.y == 0.f))
+		return next;
+
+	if (!has_next || (next.x == 0.f && next.y == 0.f))
+		return previous;
+
+	vector_2d normal = (previous + next) * 0.5f;
+	const float length_squared = normal.x * normal.x + normal.y * normal.y;
+
+	if (length_squared > 1e-6f)
+		normal *= std::min<float>(1.f / length_squared, miter_limit);
+
+	return normal;
+}
+
+void line_batch::polyline(const vector_2d* points, std::size_t count, std::size_t first, std::size_t last, float thickness, color colour, bool closed, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices)
+{
+	const std::size_t segments = segment_count(count, closed);
+
+	if (last > segments)
+		last = segments;
+
+	if (first >= last)
+		return;
+
+	// the solid core is a pixel narrower than the line, the fringe adds half a pixel back on each side.
+	const float half		= thickness * 0.5f;
+	const float core		= half > 0.5f ? half - 0.5f : 0.f;
+	const float fringe		= half + 0.5f;
+
+	const DWORD solid		= colour.argb();
+	const DWORD clear		= colour.alpha(0).argb();
+
+	const std::size_t base		= vertices.size();
+	const std::size_t local		= last - first + 1;
+
+	vertices.resize(base + local * 4);
+	vertex* out = vertices.data() + base;
+
+	for (std::size_t k = 0; k < local; k++)
+	{
+		const std::size_t i = (first + k) % count;
+		const vector_2d& p = points[i];
+		const vector_2d normal = join_normal(points, count, i, closed);
+
+		const float x = p.x - 0.5f;
+		const float y = p.y - 0.5f;
+
+		out[0] = vertex({ x + normal.x * fringe, y + normal.y * fringe }, { 0.f, 1.f }, clear);
+		out[1] = vertex({ x + normal.x * core, y + normal.y * core }, { 0.f, 1.f }, solid);
+		out[2] = vertex({ x - normal.x * core, y - normal.y * core }, { 0.f, 1.f }, solid);
+		out[3] = vertex({ x - normal.x * fringe, y - normal.y * fringe }, { 0.f, 1.f }, clear);
+		out += 4;
+	}
+
+	// three quads per segment: outer fringe, core, inner fringe.
+	const std::size_t index_base = indices.size();
+	indices.resize(index_base + (local - 1) * 18);
+
+	std::uint16_t* index = indices.data() + index_base;
+
+	for (std::size_t k = 0; k + 1 < local; k++)
+	{
+		const std::uint16_t a = std::uint16_t(base + k * 4);
+		const std::uint16_t b = std::uint16_t(a + 4);
+
+		for (std::uint16_t strip = 0; strip < 3; strip++)
+		{
+			*index++ = a + strip;
+			*index++ = a + strip + 1;
+			*index++ = b + strip + 1;
+			*index++ = a + strip;
+			*index++ = b + strip + 1;
+			*index++ = b + strip;
+		}
+	}
+}
+
+void fill_batch::convex(const vector_2d* points, std::size_t count, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices)
+{
+	if (count < 3)
+		return;
+
+	// segment normals face inwards on a clockwise (screen space) polygon, flip them so the fringe goes out.
+	float area = 0.f;
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const vector_2d& a = points[i];
+		const vector_2d& b = points[(i + 1) % count];
+		area += a.x * b.y - b.x * a.y;
+	}
+
+	const float outwards	= area > 0.f ? -0.5f : 0.5f;
+	const DWORD solid		= colour.argb();
+	const DWORD clear		= colour.alpha(0).argb();
+
+	// two vertices per point: solid half a pixel inside the edge, clear half a pixel outside.
+	const std::size_t base = vertices.size();
+	vertices.resize(base + count * 2);
+
+	vertex* out = vertices.data() + base;
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const vector_2d normal = join_normal(points, count, i, true) * outwards;
+		const float x = points[i].x - 0.5f;
+		const float y = points[i].y - 0.5f;
+
+		out[0] = vertex({ x - normal.x, y - normal.y }, { 0.f, 1.f }, solid);
+		out[1] = vertex({ x + normal.x, y + normal.y }, { 0.f, 1.f }, clear);
+		out += 2;
+	}
+
+	// fan over the solid vertices, then one fringe quad per edge.
+	const std::size_t index_base = indices.size();
+	indices.resize(index_base + (count - 2) * 3 + count * 6);
+
+	std::uint16_t* index = indices.data() + index_base;
+
+	for (std::size_t i = 1; i + 1 < count; i++)
+	{
+		*index++ = std::uint16_t(base);
+		*index++ = std::uint16_t(base + i * 2);
+		*index++ = std::uint16_t(base + i * 2 + 2);
+	}
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const std::uint16_t a = std::uint16_t(base + i * 2);
+		const std::uint16_t b = std::uint16_t(base + ((i + 1) % count) * 2);
+
+		*index++ = a;
+		*index++ = a + 1;
+		*index++ = b + 1;
+		*index++ = a;
+		*index++ = b + 1;
+		*index++ = b;
+	}
+}
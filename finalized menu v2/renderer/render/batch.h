@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../other/maths.h"
+#include "../other/color.h"
+
+/*
+* bulk geometry: rectangles, polylines and convex fills.
+* every rect becomes 4 vertices of an indexed triangle list, so thousands of boxes go out in one draw call
+* per max_batch_quads instead of one DrawPrimitiveUP each. vertex generation has no device dependency,
+* which keeps it measurable off windows (see benchmark/rect_batch.cpp and benchmark/polyline.cpp).
+*/
+
+// one rectangle of a bulk draw.
+struct rect_instance
+{
+	rect	area;
+	color	colour;
+};
+
+// quads one draw can address with 16-bit indices.
+constexpr std::size_t max_batch_quads = 65536 / 4;
+
+namespace rect_batch
+{
+	// 0 1 2, 2 1 3 for each of max_batch_quads quads, built once and shared by every draw.
+	const std::vector<std::uint16_t>& quad_indices();
+
+	// append 4 vertices per rect, same pixel mapping as environment_render::filled_rect.
+	void filled(const rect_instance* rects, std::size_t count, std::vector<vertex>& vertices);
+
+	// append the 4 one pixel edges environment_render::outlined_rect draws, 16 vertices per rect.
+	void outlined(const rect_instance* rects, std::size_t count, std::vector<vertex>& vertices);
+}
+
+// polyline points one indexed draw can address, 4 vertices per point.
+constexpr std::size_t max_polyline_points = 65536 / 4;
+
+namespace line_batch
+{
+	/*
+	* thick anti-aliased polyline.
+	* every point gets 4 vertices across the line: a transparent edge, the two sides of the solid core and the
+	* other transparent edge, so each side fades out over one pixel without relying on the device's line aa.
+	* interior points join with a miter along the averaged normal (clamped so sharp turns don't spike), the
+	* ends are butt caps. closed lines also join the last point back to the first.
+	*
+	* segments first .. last - 1 are tessellated, joins still look at the points outside that range, so a long
+	* line split into pieces of at most max_polyline_points points lines up seamlessly. indices point into
+	* vertices as a whole, so several shapes can share one draw while they stay under 65536 vertices.
+	*/
+	void polyline(const vector_2d* points, std::size_t count, std::size_t first, std::size_t last, float thickness, color colour, bool closed, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices);
+
+	// segments a line of count points has.
+	inline std::size_t segment_count(std::size_t count, bool closed) { return count < 2 ? 0 : (closed ? count : count - 1); }
+}
+
+namespace fill_batch
+{
+	// filled convex polygon with a one pixel anti-aliased fringe, either winding. 2 vertices per point,
+	// indices point into vertices as a whole like line_batch::polyline.
+	void convex(const vector_2d* points, std::size_t count, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices);
+}
@@ -0,0 +1,224 @@
+#include "convert.h"
+#include <cstring>
+
+int atlas_format_size(atlas_format format)
+{
+	switch (format)
+	{
+	case atlas_format::a4r4g4b4:	return 2;
+	case atlas_format::a8:			return 1;
+	case atlas_format::a8r8g8b8:	return 4;
+	}
+
+	return 0;
+}
+
+const char* atlas_format_name(atlas_format format)
+{
+	switch (format)
+	{
+	case atlas_format::a4r4g4b4:	return "a4r4g4b4";
+	case atlas_format::a8:			return "a8";
+	case atlas_format::a8r8g8b8:	return "a8r8g8b8";
+	}
+
+	return "unknown";
+}
+
+/*
+* scalar reference.
+* empty coverage becomes a fully transparent black texel, anything else is white with the coverage as alpha.
+*/
+static void convert_scalar(atlas_format format, const std::uint8_t* source, void* destination, std::size_t count)
+{
+	switch (format)
+	{
+	case atlas_format::a4r4g4b4:
+	{
+		std::uint16_t* texels = static_cast<std::uint16_t*>(destination);
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			// 4-bit measure of pixel intensity.
+			const std::uint8_t alpha = source[i] >> 4;
+			texels[i] = alpha > 0 ? std::uint16_t((alpha << 12) | 0x0fff) : 0x0000;
+		}
+
+		break;
+	}
+
+	case atlas_format::a8:
+		std::memcpy(destination, source, count);
+		break;
+
+	case atlas_format::a8r8g8b8:
+	{
+		std::uint32_t* texels = static_cast<std::uint32_t*>(destination);
+
+		for (std::size_t i = 0; i < count; i++)
+			texels[i] = source[i] > 0 ? (std::uint32_t(source[i]) << 24) | 0x00ffffff : 0x00000000;
+
+		break;
+	}
+	}
+}
+
+#ifdef CPU_X86
+// 16 texels per step, the tail is left to the scalar kernel.
+static void convert_sse2(atlas_format format, const std::uint8_t* source, void* destination, std::size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	std::size_t i = 0;
+
+	switch (format)
+	{
+	case atlas_format::a4r4g4b4:
+	{
+		std::uint16_t* texels = static_cast<std::uint16_t*>(destination);
+		const __m128i low_bits = _mm_set1_epi16(0x0fff);
+
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i coverage = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+
+			for (int half = 0; half < 2; half++)
+			{
+				const __m128i wide		= half ? _mm_unpackhi_epi8(coverage, zero) : _mm_unpacklo_epi8(coverage, zero);
+				const __m128i alpha		= _mm_srli_epi16(wide, 4);
+				const __m128i texel		= _mm_or_si128(_mm_slli_epi16(alpha, 12), low_bits);
+				const __m128i empty		= _mm_cmpeq_epi16(alpha, zero);
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(texels + i + half * 8), _mm_andnot_si128(empty, texel));
+			}
+		}
+
+		break;
+	}
+
+	case atlas_format::a8:
+		std::memcpy(destination, source, count);
+		return;
+
+	case atlas_format::a8r8g8b8:
+	{
+		std::uint32_t* texels = static_cast<std::uint32_t*>(destination);
+		const __m128i low_bits = _mm_set1_epi32(0x00ffffff);
+
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i coverage = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+
+			// interleaving with zero below the coverage moves it into the top byte of each lane.
+			const __m128i words[2] = { _mm_unpacklo_epi8(zero, coverage), _mm_unpackhi_epi8(zero, coverage) };
+
+			for (int quarter = 0; quarter < 4; quarter++)
+			{
+				const __m128i& word	= words[quarter / 2];
+				const __m128i alpha	= (quarter & 1) ? _mm_unpackhi_epi16(zero, word) : _mm_unpacklo_epi16(zero, word);
+				const __m128i empty	= _mm_cmpeq_epi32(alpha, zero);
+				const __m128i texel	= _mm_or_si128(alpha, low_bits);
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(texels + i + quarter * 4), _mm_andnot_si128(empty, texel));
+			}
+		}
+
+		break;
+	}
+	}
+
+	const std::size_t size = std::size_t(atlas_format_size(format));
+	convert_scalar(format, source + i, static_cast<std::uint8_t*>(destination) + i * size, count - i);
+}
+
+// 32 texels per step, widened with zero extension instead of unpacks since those work per 128-bit lane.
+AVX2_TARGET static void convert_avx2(atlas_format format, const std::uint8_t* source, void* destination, std::size_t count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	std::size_t i = 0;
+
+	switch (format)
+	{
+	case atlas_format::a4r4g4b4:
+	{
+		std::uint16_t* texels = static_cast<std::uint16_t*>(destination);
+		const __m256i low_bits = _mm256_set1_epi16(0x0fff);
+
+		for (; i + 32 <= count; i += 32)
+		{
+			for (int half = 0; half < 2; half++)
+			{
+				const __m128i coverage	= _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + half * 16));
+				const __m256i alpha		= _mm256_srli_epi16(_mm256_cvtepu8_epi16(coverage), 4);
+				const __m256i texel		= _mm256_or_si256(_mm256_slli_epi16(alpha, 12), low_bits);
+				const __m256i empty		= _mm256_cmpeq_epi16(alpha, zero);
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(texels + i + half * 16), _mm256_andnot_si256(empty, texel));
+			}
+		}
+
+		break;
+	}
+
+	case atlas_format::a8:
+		std::memcpy(destination, source, count);
+		return;
+
+	case atlas_format::a8r8g8b8:
+	{
+		std::uint32_t* texels = static_cast<std::uint32_t*>(destination);
+		const __m256i low_bits = _mm256_set1_epi32(0x00ffffff);
+
+		for (; i + 32 <= count; i += 32)
+		{
+			for (int quarter = 0; quarter < 4; quarter++)
+			{
+				const __m128i coverage	= _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i + quarter * 8));
+				const __m256i alpha		= _mm256_slli_epi32(_mm256_cvtepu8_epi32(coverage), 24);
+				const __m256i empty		= _mm256_cmpeq_epi32(alpha, zero);
+				const __m256i texel		= _mm256_or_si256(alpha, low_bits);
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(texels + i + quarter * 8), _mm256_andnot_si256(empty, texel));
+			}
+		}
+
+		break;
+	}
+	}
+
+	const std::size_t size = std::size_t(atlas_format_size(format));
+	convert_scalar(format, source + i, static_cast<std::uint8_t*>(destination) + i * size, count - i);
+}
+#endif
+
+void convert_coverage(atlas_format format, const std::uint8_t* source, void* destination, std::size_t count, convert_kernel kernel)
+{
+	// nothing to convert, and the buffers of an empty page may well be null, which memcpy doesn't accept.
+	if (count == 0)
+		return;
+
+	// an unsupported request falls back to the reference instead of faulting.
+	if (!simd_supported(kernel))
+		kernel = convert_kernel::scalar;
+
+	switch (kernel)
+	{
+#ifdef CPU_X86
+	case convert_kernel::avx2:
+		convert_avx2(format, source, destination, count);
+		break;
+
+	case convert_kernel::sse2:
+		convert_sse2(format, source, destination, count);
+		break;
+#endif
+
+	default:
+		convert_scalar(format, source, destination, count);
+		break;
+	}
+}
+
+void convert_coverage(atlas_format format, const std::uint8_t* source, void* destination, std::size_t count)
+{
+	convert_coverage(format, source, destination, count, simd_best());
+}
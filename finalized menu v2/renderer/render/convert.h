@@ -0,0 +1,29 @@
+#pragma once
+#include "../other/cpu.h"
+#include <cstddef>
+#include <cstdint>
+
+/*
+* atlas pixel conversion kernels.
+* glyph pages are kept as 8-bit coverage and converted into the texture format right before upload,
+* which happens on every build and every device reset. the scalar kernel is the reference, the sse2 and
+* avx2 kernels must match it bit for bit (see benchmark/atlas_convert.cpp).
+*/
+
+// texture formats the atlas can upload into.
+enum class atlas_format : int
+{
+	a4r4g4b4,	// 16-bit, white with 4-bit alpha.
+	a8,			// 8-bit alpha only.
+	a8r8g8b8	// 32-bit, white with 8-bit alpha.
+};
+
+typedef simd_level convert_kernel;
+
+// bytes per texel of a format.
+int atlas_format_size(atlas_format format);
+const char* atlas_format_name(atlas_format format);
+
+// convert count coverage values into count texels of the given format, the overload without a kernel picks simd_best().
+void convert_coverage(atlas_format format, const std::uint8_t* source, void* destination, std::size_t count, convert_kernel kernel);
+void convert_coverage(atlas_format format, const std::uint8_t* source, void* destination, std::size_t count);
@@ -0,0 +1,221 @@
+#include "draw_list.h"
+#include "../other/hash.h"
+
+void draw_list::clear()
+{
+	// capacity is kept, a window re-records into the same list.
+	this->commands.clear();
+	this->vertices.clear();
+	this->indices.clear();
+	this->glyphs.clear();
+	this->probes.clear();
+}
+
+void draw_list::add_quad(const vertex* quad)
+{
+	if (this->commands.empty() || this->commands.back().type != draw_command_type::quads)
+	{
+		draw_command command;
+		command.type	= draw_command_type::quads;
+		command.first	= this->vertices.size();
+		this->commands.push_back(command);
+	}
+
+	this->vertices.insert(this->vertices.end(), quad, quad + 4);
+	this->commands.back().count += 4;
+}
+
+void draw_list::add_line(const vertex* line)
+{
+	if (this->commands.empty() || this->commands.back().type != draw_command_type::lines)
+	{
+		draw_command command;
+		command.type	= draw_command_type::lines;
+		command.first	= this->vertices.size();
+		this->commands.push_back(command);
+	}
+
+	this->vertices.insert(this->vertices.end(), line, line + 2);
+	this->commands.back().count += 2;
+}
+
+void draw_list::add_geometry(const vertex* geometry, std::size_t vertex_count, const std::uint16_t* geometry_indices, std::size_t index_count)
+{
+	if (index_count == 0)
+		return;
+
+	// indices are relative to the command's first vertex, so merging stops where 16 bits run out.
+	const bool merge = !this->commands.empty() && this->commands.back().type == draw_command_type::geometry
+		&& this->commands.back().count + vertex_count <= 65536;
+
+	if (!merge)
+	{
+		draw_command command;
+		command.type		= draw_command_type::geometry;
+		command.first		= this->vertices.size();
+		command.first_index	= this->indices.size();
+		this->commands.push_back(command);
+	}
+
+	draw_command& command = this->commands.back();
+	const std::size_t base = command.count;
+
+	for (std::size_t i = 0; i < index_count; i++)
+		this->indices.push_back(std::uint16_t(base + geometry_indices[i]));
+
+	this->vertices.insert(this->vertices.end(), geometry, geometry + vertex_count);
+	command.count		+= vertex_count;
+	command.index_count	+= index_count;
+}
+
+void draw_list::add_text(int page, bool filtered, const FONT2DVERTEX* glyphs, int count)
+{
+	// same rule as the atlas batch: one command per run of page and filter.
+	if (this->commands.empty() || this->commands.back().type != draw_command_type::text
+		|| this->commands.back().page != page || this->commands.back().filtered != filtered)
+	{
+		draw_command command;
+		command.type		= draw_command_type::text;
+		command.first		= this->glyphs.size();
+		command.page		= page;
+		command.filtered	= filtered;
+		this->commands.push_back(command);
+	}
+
+	this->glyphs.insert(this->glyphs.end(), glyphs, glyphs + count);
+	this->commands.back().count += std::size_t(count);
+}
+
+void draw_list::start_clip(const rect& area)
+{
+	draw_command command;
+	command.type	= draw_command_type::clip_start;
+	command.clip	= area;
+	this->commands.push_back(command);
+}
+
+void draw_list::end_clip()
+{
+	draw_command command;
+	command.type	= draw_command_type::clip_end;
+	this->commands.push_back(command);
+}
+
+void draw_list::add_surface(void* texture, std::uint32_t version, const rect& area)
+{
+	draw_command command;
+	command.type	= draw_command_type::surface;
+	command.texture	= texture;
+	command.version	= version;
+	command.clip	= area;
+	this->commands.push_back(command);
+}
+
+void draw_list::append(const draw_list& list)
+{
+	for (const auto& command : list.commands)
+	{
+		switch (command.type)
+		{
+		case draw_command_type::quads:
+			for (std::size_t i = 0; i < command.count; i += 4)
+				this->add_quad(list.vertices.data() + command.first + i);
+			break;
+
+		case draw_command_type::lines:
+			for (std::size_t i = 0; i < command.count; i += 2)
+				this->add_line(list.vertices.data() + command.first + i);
+			break;
+
+		case draw_command_type::geometry:
+			this->add_geometry(list.vertices.data() + command.first, command.count, list.indices.data() + command.first_index, command.index_count);
+			break;
+
+		case draw_command_type::text:
+			this->add_text(command.page, command.filtered, list.glyphs.data() + command.first, int(command.count));
+			break;
+
+		case draw_command_type::clip_start:
+			this->start_clip(command.clip);
+			break;
+
+		case draw_command_type::clip_end:
+			this->end_clip();
+			break;
+
+		case draw_command_type::surface:
+			this->add_surface(command.texture, command.version, command.clip);
+			break;
+		}
+	}
+}
+
+void draw_list::add_probe(const rect& area, bool inside)
+{
+	this->probes.push_back({ area, inside });
+}
+
+void draw_list::translate(int x, int y)
+{
+	if (x == 0 && y == 0)
+		return;
+
+	const float dx = float(x), dy = float(y);
+
+	for (auto& v : this->vertices)
+	{
+		v.position.x += dx;
+		v.position.y += dy;
+	}
+
+	for (auto& glyph : this->glyphs)
+	{
+		glyph.x += dx;
+		glyph.y += dy;
+	}
+
+	for (auto& command : this->commands)
+	{
+		command.clip.x += x;
+		command.clip.y += y;
+	}
+
+	for (auto& test : this->probes)
+	{
+		test.area.x += x;
+		test.area.y += y;
+	}
+}
+
+std::size_t draw_list::memory() const
+{
+	return this->commands.capacity() * sizeof(draw_command) + this->vertices.capacity() * sizeof(vertex)
+		+ this->indices.capacity() * sizeof(std::uint16_t) + this->glyphs.capacity() * sizeof(FONT2DVERTEX)
+		+ this->probes.capacity() * sizeof(draw_probe);
+}
+
+std::uint64_t draw_list::hash() const
+{
+	std::uint64_t hash = hash_seed;
+
+	// field by field, the padding inside draw_command is not part of what gets drawn.
+	for (const auto& command : this->commands)
+	{
+		hash = hash_value(hash, command.type);
+		hash = hash_value(hash, command.count);
+		hash = hash_value(hash, command.index_count);
+		hash = hash_value(hash, command.page);
+		hash = hash_value(hash, command.filtered);
+		hash = hash_value(hash, command.clip.x);
+		hash = hash_value(hash, command.clip.y);
+		hash = hash_value(hash, command.clip.w);
+		hash = hash_value(hash, command.clip.h);
+		hash = hash_value(hash, command.texture);
+		hash = hash_value(hash, command.version);
+	}
+
+	hash = hash_bytes(hash, this->vertices.data(), this->vertices.size() * sizeof(vertex));
+	hash = hash_bytes(hash, this->indices.data(), this->indices.size() * sizeof(std::uint16_t));
+	hash = hash_bytes(hash, this->glyphs.data(), this->glyphs.size() * sizeof(FONT2DVERTEX));
+	return hash;
+}
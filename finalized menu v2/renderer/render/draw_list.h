@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "atlas.h"
+#include "batch.h"
+
+/*
+* retained draw list.
+* while environment_render is capturing into a list, every primitive and every glyph batch is appended here
+* instead of going to the device. the list can then be replayed as often as needed, translated when its owner
+* moved. consecutive primitives of the same kind merge into one command, so a replay usually needs far fewer
+* draw calls than drawing the same thing immediately.
+*
+* a list also remembers the hover tests (gui_input::in_bound) made while it was recorded. if the mouse
+* would now give a different answer for any of them, the list no longer matches what a fresh draw would
+* produce, the owner checks them before replaying.
+*/
+
+enum class draw_command_type : int
+{
+	quads,		// 4 vertices each in strip order, drawn through rect_batch::quad_indices.
+	lines,		// line list.
+	geometry,	// indexed triangles (polylines, shapes).
+	text,		// glyph vertices for one atlas page.
+	clip_start,
+	clip_end,
+	surface		// a render target composited as one textured quad over clip.
+};
+
+struct draw_command
+{
+	draw_command_type	type;
+	std::size_t			first			= 0;	// first vertex (text: first glyph vertex).
+	std::size_t			count			= 0;	// vertices.
+	std::size_t			first_index		= 0;	// geometry only.
+	std::size_t			index_count		= 0;
+	int					page			= 0;	// text only.
+	bool				filtered		= false;
+	rect				clip;					// clip_start and surface.
+	void*				texture			= nullptr;	// surface only.
+	std::uint32_t		version			= 0;	// surface only, changes whenever the texture was redrawn.
+};
+
+// a hover test made while recording and its answer.
+struct draw_probe
+{
+	rect	area;
+	bool	inside;
+};
+
+class draw_list
+{
+public:
+	void clear();
+	bool empty() const { return this->commands.empty(); }
+
+	void add_quad(const vertex* quad);
+	void add_line(const vertex* line);
+	void add_geometry(const vertex* geometry, std::size_t vertex_count, const std::uint16_t* geometry_indices, std::size_t index_count);
+	void add_geometry(const std::vector<vertex>& geometry, const std::vector<std::uint16_t>& geometry_indices) { this->add_geometry(geometry.data(), geometry.size(), geometry_indices.data(), geometry_indices.size()); }
+	void add_text(int page, bool filtered, const FONT2DVERTEX* glyphs, int count);
+	void start_clip(const rect& area);
+	void end_clip();
+	void add_surface(void* texture, std::uint32_t version, const rect& area);
+
+	// appends every command of another list, merging where the kinds line up. hover tests are not copied.
+	void append(const draw_list& list);
+
+	// hover tests made while recording.
+	void add_probe(const rect& area, bool inside);
+
+	// shifts every vertex, clip and hover test.
+	void translate(int x, int y);
+
+	// bytes held by the list, capacity included.
+	std::size_t memory() const;
+
+	// hash of everything that ends up on screen: commands, positions, colors, glyphs and clips.
+	std::uint64_t hash() const;
+
+	std::vector<draw_command>	commands;
+	std::vector<vertex>			vertices;
+	std::vector<std::uint16_t>	indices;
+	std::vector<FONT2DVERTEX>	glyphs;
+	std::vector<draw_probe>		probes;
+};
@@ -1,62 +1,20 @@
 #include "font.h"
+#include "truetype.h"
+#include "../other/allocations.h"
+#include "../other/profiler.h"
 
 //-----------------------------------------------------------------------------
 // File: D3DFont.cpp
 //
 // Desc: Texture-based font class
 //-----------------------------------------------------------------------------
-#include <DirectXMath.h>
 #include <stdio.h>
-#include <tchar.h>
 #include <cmath>
 
-
-using namespace ::DirectX;
-
-
-//-----------------------------------------------------------------------------
-// Custom vertex types for rendering text
-//-----------------------------------------------------------------------------
-#define MAX_NUM_VERTICES (50*6)
-
-struct FONT2DVERTEX
-{
-    XMFLOAT4 p;
-    DWORD    color;
-    FLOAT    tu, tv;
-};
-
-struct FONT3DVERTEX
-{
-    XMFLOAT3 p;
-    XMFLOAT3 n;
-    FLOAT    tu, tv;
-};
-
-#define D3DFVF_FONT2DVERTEX (D3DFVF_XYZRHW|D3DFVF_DIFFUSE|D3DFVF_TEX1)
-#define D3DFVF_FONT3DVERTEX (D3DFVF_XYZ|D3DFVF_NORMAL|D3DFVF_TEX1)
-
-inline FONT2DVERTEX InitFont2DVertex(const XMFLOAT4& p, D3DCOLOR color, FLOAT tu, FLOAT tv)
-{
-    FONT2DVERTEX v;
-    v.p = p;
-    v.color = color;
-    v.tu = tu;
-    v.tv = tv;
-    return v;
-}
-
-inline FONT3DVERTEX InitFont3DVertex(const XMFLOAT3& p, const XMFLOAT3& n, FLOAT tu, FLOAT tv)
-{
-    FONT3DVERTEX v;
-    v.p = p;
-    v.n = n;
-    v.tu = tu;
-    v.tv = tv;
-    return v;
-}
-
-
+#ifdef _WIN32
+#include <tchar.h>
+#include "render.h"
+#endif
 
 
 //-----------------------------------------------------------------------------
@@ -71,14 +29,11 @@ environment_font::environment_font(const TCHAR* strFontName, DWORD dwHeight, DWO
     this->dwFontWeight = dwWeight;
     this->dwFontFlags = dwFlags;
     this->dwSpacing = 0;
+    this->fTextScale = 1.0f;
 
-
-    this->pd3dDevice = nullptr;
-    this->pTexture = nullptr;
-    this->pVB = nullptr;
-
-    this->pStateBlockSaved = nullptr;
-    this->pStateBlockDrawString = nullptr;
+    ZeroMemory(this->fTexCoords, sizeof(this->fTexCoords));
+    ZeroMemory(this->iTexPage, sizeof(this->iTexPage));
+    ZeroMemory(this->fAdvance, sizeof(this->fAdvance));
 }
 
 
@@ -90,74 +45,30 @@ environment_font::environment_font(const TCHAR* strFontName, DWORD dwHeight, DWO
 //-----------------------------------------------------------------------------
 environment_font::~environment_font()
 {
-    this->invalidate_device_objects();
-    this->delete_device_objects();
 }
 
 
 
 
 //-----------------------------------------------------------------------------
-// Name: InitDeviceObjects()
-// Desc: Initializes device-dependent objects, including the vertex buffer used
-//       for rendering text and the texture map which stores the font image.
+// Name: setup_glyphs()
+// Desc: Rasterizes every printable character into its own glyph cell. The
+//       cells are packed into the shared atlas pages by environment_atlas.
 //-----------------------------------------------------------------------------
-HRESULT environment_font::setup_device_objects(LPDIRECT3DDEVICE9 pd3dDevice)
+#ifdef _WIN32
+HRESULT environment_font::setup_glyphs()
 {
-    HRESULT hr;
-
-    // Keep a local copy of the device
-    this->pd3dDevice = pd3dDevice;
-
-    // Establish the font and texture size
-    this->fTextScale = 1.0f; // Draw fonts into texture without scaling
-
-    // Large fonts need larger textures
-    if (this->dwFontHeight > 60)
-        this->dwTexWidth = this->dwTexHeight = 2048;
-    else if (this->dwFontHeight > 30)
-        this->dwTexWidth = this->dwTexHeight = 1024;
-    else if (this->dwFontHeight > 15)
-        this->dwTexWidth = this->dwTexHeight = 512;
-    else
-        this->dwTexWidth = this->dwTexHeight = 256;
-
-    // If requested texture is too big, use a smaller texture and smaller font,
-    // and scale up when rendering.
-    D3DCAPS9 d3dCaps;
-    this->pd3dDevice->GetDeviceCaps(&d3dCaps);
-
-    if (this->dwTexWidth > d3dCaps.MaxTextureWidth) {
-        this->fTextScale = FLOAT(d3dCaps.MaxTextureWidth) / FLOAT(this->dwTexWidth);
-        this->dwTexWidth = this->dwTexHeight = d3dCaps.MaxTextureWidth;
-    }
+    PROFILE_SCOPE("rasterize", "font");
+    memory_scope memory(memory_tag::font);
 
-    // Create a new texture for the font
-    hr = this->pd3dDevice->CreateTexture(this->dwTexWidth, this->dwTexHeight, 1, D3DUSAGE_DYNAMIC, D3DFMT_A4R4G4B4, D3DPOOL_DEFAULT,
-        &this->pTexture, nullptr);
-    if (FAILED(hr))
-        return hr;
+    // Draw fonts into the cells without scaling
+    this->fTextScale = 1.0f;
 
-    // Prepare to create a bitmap
-    DWORD* pBitmapBits;
-    BITMAPINFO bmi;
-    ZeroMemory(&bmi.bmiHeader, sizeof(BITMAPINFOHEADER));
-    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-    bmi.bmiHeader.biWidth = int(this->dwTexWidth);
-    bmi.bmiHeader.biHeight = -int(this->dwTexHeight);
-    bmi.bmiHeader.biPlanes = 1;
-    bmi.bmiHeader.biCompression = BI_RGB;
-    bmi.bmiHeader.biBitCount = 32;
-
-    // Create a DC and a bitmap for the font
-    HDC     hDC = CreateCompatibleDC(nullptr);
-    HBITMAP hbmBitmap = CreateDIBSection(hDC, &bmi, DIB_RGB_COLORS, (void**)&pBitmapBits, nullptr, 0);
+    // Create a DC for the font
+    HDC hDC = CreateCompatibleDC(nullptr);
 
-    // Sanity checks
     if (hDC == nullptr)
         return E_FAIL;
-    if (hbmBitmap == nullptr)
-        return E_FAIL;
 
     SetMapMode(hDC, MM_TEXT);
 
@@ -170,182 +81,184 @@ HRESULT environment_font::setup_device_objects(LPDIRECT3DDEVICE9 pd3dDevice)
         this->dwFontHeight > 8 ? CLEARTYPE_NATURAL_QUALITY : ANTIALIASED_QUALITY, VARIABLE_PITCH,
         this->strFontName);
 
-    if (nullptr == hFont)
+    if (nullptr == hFont) {
+        DeleteDC(hDC);
         return E_FAIL;
+    }
 
-    HGDIOBJ hbmOld = SelectObject(hDC, hbmBitmap);
     HGDIOBJ hFontOld = SelectObject(hDC, hFont);
 
-    // Set text properties
-    SetTextColor(hDC, RGB(255, 255, 255));
-    SetBkColor(hDC, 0x00000000);
-    SetTextAlign(hDC, TA_TOP);
-
-    // Loop through all printable character and output them to the bitmap..
-    // Meanwhile, keep track of the corresponding tex coords for each character.
-    DWORD x = 0;
-    DWORD y = 0;
+    // Measure every printable character first, so a single scratch bitmap can
+    // hold the largest cell.
     TCHAR str[2] = _T("x");
     SIZE  size;
+    SIZE  sizes[128 - 32];
+    LONG  lCellWidth = 0;
+    LONG  lCellHeight = 0;
 
     // Calculate the spacing between characters based on line height
     GetTextExtentPoint32(hDC, TEXT(" "), 1, &size);
-    x = this->dwSpacing = (DWORD)ceil(size.cy * 0.3f);
+    this->dwSpacing = (DWORD)ceil(size.cy * 0.3f);
 
     for (TCHAR c = 32; c < 127; c++) {
         str[0] = c;
-        GetTextExtentPoint32(hDC, str, 1, &size);
+        GetTextExtentPoint32(hDC, str, 1, &sizes[c - 32]);
+
+        lCellWidth = max(lCellWidth, sizes[c - 32].cx + LONG(2 * this->dwSpacing));
+        lCellHeight = max(lCellHeight, sizes[c - 32].cy);
+    }
 
-        if ((DWORD)(x + size.cx + this->dwSpacing) > this->dwTexWidth) {
-            x = this->dwSpacing;
-            y += size.cy + 1;
+    // Real pen advances, fractional for outline fonts. Bitmap fonts can't
+    // report them, so fall back to the measured cell
+    ABCFLOAT abc[128 - 32];
+
+    if (GetCharABCWidthsFloat(hDC, 32, 126, abc)) {
+        for (int i = 0; i < 127 - 32; i++)
+            this->fAdvance[i] = abc[i].abcfA + abc[i].abcfB + abc[i].abcfC;
+    }
+    else {
+        for (int i = 0; i < 127 - 32; i++)
+            this->fAdvance[i] = (FLOAT)sizes[i].cx;
+    }
+
+    // Kerning pairs between printable characters
+    this->vKerning.clear();
+    DWORD dwPairs = GetKerningPairs(hDC, 0, nullptr);
+
+    if (dwPairs > 0) {
+        std::vector<KERNINGPAIR> pairs(dwPairs);
+        dwPairs = GetKerningPairs(hDC, dwPairs, pairs.data());
+
+        for (DWORD i = 0; i < dwPairs; i++) {
+            const KERNINGPAIR& pair = pairs[i];
+
+            if (pair.wFirst < 32 || pair.wFirst >= 127 || pair.wSecond < 32 || pair.wSecond >= 127 || pair.iKernAmount == 0)
+                continue;
+
+            if (this->vKerning.empty())
+                this->vKerning.assign((128 - 32) * (128 - 32), 0.0f);
+
+            this->vKerning[(pair.wFirst - 32) * (128 - 32) + (pair.wSecond - 32)] = (FLOAT)pair.iKernAmount;
         }
+    }
 
-        ExtTextOut(hDC, x + 0, y + 0, ETO_OPAQUE, nullptr, str, 1, nullptr);
+    // Prepare to create a bitmap
+    DWORD* pBitmapBits;
+    BITMAPINFO bmi;
+    ZeroMemory(&bmi.bmiHeader, sizeof(BITMAPINFOHEADER));
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = int(lCellWidth);
+    bmi.bmiHeader.biHeight = -int(lCellHeight);
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    bmi.bmiHeader.biBitCount = 32;
 
-        this->fTexCoords[c - 32][0] = ((FLOAT)(x + 0 - this->dwSpacing)) / this->dwTexWidth;
-        this->fTexCoords[c - 32][1] = ((FLOAT)(y + 0 + 0)) / this->dwTexHeight;
-        this->fTexCoords[c - 32][2] = ((FLOAT)(x + size.cx + this->dwSpacing)) / this->dwTexWidth;
-        this->fTexCoords[c - 32][3] = ((FLOAT)(y + size.cy + 0)) / this->dwTexHeight;
+    HBITMAP hbmBitmap = CreateDIBSection(hDC, &bmi, DIB_RGB_COLORS, (void**)&pBitmapBits, nullptr, 0);
 
-        x += size.cx + (2 * this->dwSpacing);
+    // Sanity checks
+    if (hbmBitmap == nullptr) {
+        SelectObject(hDC, hFontOld);
+        DeleteObject(hFont);
+        DeleteDC(hDC);
+        return E_FAIL;
     }
 
-    // Lock the surface and write the alpha values for the set pixels
-    D3DLOCKED_RECT d3dlr;
-    this->pTexture->LockRect(0, &d3dlr, 0, 0);
-    BYTE* pDstRow = (BYTE*)d3dlr.pBits;
-    WORD* pDst16;
-    BYTE  bAlpha; // 4-bit measure of pixel intensity
-
-    for (y = 0; y < this->dwTexHeight; y++) {
-        pDst16 = (WORD*)pDstRow;
-        for (x = 0; x < this->dwTexWidth; x++) {
-            bAlpha = (BYTE)((pBitmapBits[this->dwTexWidth * y + x] & 0xff) >> 4);
-            if (bAlpha > 0) {
-                *pDst16++ = (WORD)((bAlpha << 12) | 0x0fff);
-            }
-            else {
-                *pDst16++ = 0x0000;
-            }
+    HGDIOBJ hbmOld = SelectObject(hDC, hbmBitmap);
+
+    // Set text properties
+    SetTextColor(hDC, RGB(255, 255, 255));
+    SetBkColor(hDC, 0x00000000);
+    SetTextAlign(hDC, TA_TOP);
+
+    // Loop through all printable character and output them to the scratch
+    // bitmap, then keep the intensity of each cell for the atlas.
+    for (TCHAR c = 32; c < 127; c++) {
+        str[0] = c;
+
+        ZeroMemory(pBitmapBits, lCellWidth * lCellHeight * sizeof(DWORD));
+        ExtTextOut(hDC, this->dwSpacing, 0, ETO_OPAQUE, nullptr, str, 1, nullptr);
+        GdiFlush();
+
+        atlas_bitmap& glyph = this->glyphs[c - 32];
+        glyph.w = sizes[c - 32].cx + 2 * this->dwSpacing;
+        glyph.h = sizes[c - 32].cy;
+        glyph.pixels.resize(glyph.w * glyph.h);
+
+        for (int y = 0; y < glyph.h; y++) {
+            for (int x = 0; x < glyph.w; x++)
+                glyph.pixels[glyph.w * y + x] = (BYTE)(pBitmapBits[lCellWidth * y + x] & 0xff);
         }
-        pDstRow += d3dlr.Pitch;
     }
 
-    // Done updating texture, so clean up used objects
-    this->pTexture->UnlockRect(0);
+    // Done rasterizing, so clean up used objects
     SelectObject(hDC, hbmOld);
     SelectObject(hDC, hFontOld);
     DeleteObject(hbmBitmap);
     DeleteObject(hFont);
     DeleteDC(hDC);
 
-    // this->iHeight = static_cast<int>([this]()
-    //    {
-    //        SIZE size;
-    //        this->GetTextExtent("WJ", &size);
-    //        return size.cy;
-    //    }());
-
     return S_OK;
 }
+#endif
 
 
 
 
 //-----------------------------------------------------------------------------
-// Name: RestoreDeviceObjects()
-// Desc:
+// Name: setup_glyphs()
+// Desc: Portable path, rasterizes the printable characters from a TrueType
+//       face into the same cells and spacing the GDI path produces, so the
+//       atlas and the text metrics don't care which one filled them. The
+//       face is only read, so several fonts can rasterize at once.
+//       Weight and italic come from the face itself, pass the matching file.
 //-----------------------------------------------------------------------------
-HRESULT environment_font::restore_device_objects()
+HRESULT environment_font::setup_glyphs(const truetype_font& face)
 {
-    HRESULT hr;
-
-    // Create vertex buffer for the letters
-    int vertexSize = max(sizeof(FONT2DVERTEX), sizeof(FONT3DVERTEX));
-    if (FAILED(hr = this->pd3dDevice->CreateVertexBuffer(MAX_NUM_VERTICES * vertexSize,
-        D3DUSAGE_WRITEONLY | D3DUSAGE_DYNAMIC, 0,
-        D3DPOOL_DEFAULT, &this->pVB, nullptr))) {
-        return hr;
-    }
+    PROFILE_SCOPE("rasterize", "font");
+    memory_scope memory(memory_tag::font);
 
-    // Create the state blocks for rendering text
-    for (UINT which = 0; which < 2; which++) {
-        this->pd3dDevice->BeginStateBlock();
-        this->pd3dDevice->SetTexture(0, this->pTexture);
-
-        if (D3DFONT_ZENABLE & this->dwFontFlags)
-            this->pd3dDevice->SetRenderState(D3DRS_ZENABLE, TRUE);
-        else
-            this->pd3dDevice->SetRenderState(D3DRS_ZENABLE, FALSE);
-
-        this->pd3dDevice->SetRenderState(D3DRS_ALPHABLENDENABLE, TRUE);
-        this->pd3dDevice->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
-        this->pd3dDevice->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
-        this->pd3dDevice->SetRenderState(D3DRS_ALPHATESTENABLE, TRUE);
-        this->pd3dDevice->SetRenderState(D3DRS_ALPHAREF, 0x08);
-        this->pd3dDevice->SetRenderState(D3DRS_ALPHAFUNC, D3DCMP_GREATEREQUAL);
-        this->pd3dDevice->SetRenderState(D3DRS_FILLMODE, D3DFILL_SOLID);
-        this->pd3dDevice->SetRenderState(D3DRS_CULLMODE, D3DCULL_CCW);
-        this->pd3dDevice->SetRenderState(D3DRS_STENCILENABLE, FALSE);
-        this->pd3dDevice->SetRenderState(D3DRS_CLIPPING, TRUE);
-        this->pd3dDevice->SetRenderState(D3DRS_CLIPPLANEENABLE, FALSE);
-        this->pd3dDevice->SetRenderState(D3DRS_VERTEXBLEND, D3DVBF_DISABLE);
-        this->pd3dDevice->SetRenderState(D3DRS_INDEXEDVERTEXBLENDENABLE, FALSE);
-        this->pd3dDevice->SetRenderState(D3DRS_FOGENABLE, FALSE);
-        this->pd3dDevice->SetRenderState(D3DRS_COLORWRITEENABLE,
-            D3DCOLORWRITEENABLE_RED | D3DCOLORWRITEENABLE_GREEN |
-            D3DCOLORWRITEENABLE_BLUE | D3DCOLORWRITEENABLE_ALPHA);
-        this->pd3dDevice->SetTextureStageState(0, D3DTSS_COLOROP, D3DTOP_MODULATE);
-        this->pd3dDevice->SetTextureStageState(0, D3DTSS_COLORARG1, D3DTA_TEXTURE);
-        this->pd3dDevice->SetTextureStageState(0, D3DTSS_COLORARG2, D3DTA_DIFFUSE);
-        this->pd3dDevice->SetTextureStageState(0, D3DTSS_ALPHAOP, D3DTOP_MODULATE);
-        this->pd3dDevice->SetTextureStageState(0, D3DTSS_ALPHAARG1, D3DTA_TEXTURE);
-        this->pd3dDevice->SetTextureStageState(0, D3DTSS_ALPHAARG2, D3DTA_DIFFUSE);
-        this->pd3dDevice->SetTextureStageState(0, D3DTSS_TEXCOORDINDEX, 0);
-        this->pd3dDevice->SetTextureStageState(0, D3DTSS_TEXTURETRANSFORMFLAGS, D3DTTFF_DISABLE);
-        this->pd3dDevice->SetTextureStageState(1, D3DTSS_COLOROP, D3DTOP_DISABLE);
-        this->pd3dDevice->SetTextureStageState(1, D3DTSS_ALPHAOP, D3DTOP_DISABLE);
-        this->pd3dDevice->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_POINT);
-        this->pd3dDevice->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_POINT);
-        this->pd3dDevice->SetSamplerState(0, D3DSAMP_MIPFILTER, D3DTEXF_NONE);
-
-        if (which == 0)
-            this->pd3dDevice->EndStateBlock(&this->pStateBlockSaved);
-        else
-            this->pd3dDevice->EndStateBlock(&this->pStateBlockDrawString);
-    }
+    if (!face.valid())
+        return E_FAIL;
 
-    return S_OK;
-}
+    // Draw fonts into the cells without scaling
+    this->fTextScale = 1.0f;
 
+    // Same em size GDI picks for a negative height at 96 dpi
+    FLOAT fScale = face.scale_for_em(this->dwFontHeight * 96.0f / 72.0f);
+    LONG  lAscent = (LONG)std::roundf(face.ascent() * fScale);
+    LONG  lCellHeight = lAscent + (LONG)std::roundf(face.descent() * fScale);
 
+    // Calculate the spacing between characters based on line height
+    this->dwSpacing = (DWORD)ceil(lCellHeight * 0.3f);
 
+    for (int c = 32; c < 127; c++) {
+        int iGlyph = face.glyph_index(c);
 
-//-----------------------------------------------------------------------------
-// Name: InvalidateDeviceObjects()
-// Desc: Destroys all device-dependent objects
-//-----------------------------------------------------------------------------
-HRESULT environment_font::invalidate_device_objects()
-{
-    SAFE_RELEASE(this->pVB);
-    SAFE_RELEASE(this->pStateBlockSaved);
-    SAFE_RELEASE(this->pStateBlockDrawString);
+        atlas_bitmap& glyph = this->glyphs[c - 32];
+        glyph.w = (int)std::roundf(face.advance(iGlyph) * fScale) + 2 * this->dwSpacing;
+        glyph.h = lCellHeight;
 
-    return S_OK;
-}
+        face.rasterize(iGlyph, fScale, (FLOAT)this->dwSpacing, (FLOAT)lAscent, glyph);
 
+        this->fAdvance[c - 32] = face.advance(iGlyph) * fScale;
+    }
 
+    // Kerning pairs between printable characters
+    this->vKerning.clear();
 
+    for (int first = 32; first < 127; first++) {
+        for (int second = 32; second < 127; second++) {
+            int iKern = face.kerning(face.glyph_index(first), face.glyph_index(second));
 
-//-----------------------------------------------------------------------------
-// Name: DeleteDeviceObjects()
-// Desc: Destroys all device-dependent objects
-//-----------------------------------------------------------------------------
-HRESULT environment_font::delete_device_objects()
-{
-    SAFE_RELEASE(this->pTexture);
-    this->pd3dDevice = nullptr;
+            if (iKern == 0)
+                continue;
+
+            if (this->vKerning.empty())
+                this->vKerning.assign((128 - 32) * (128 - 32), 0.0f);
+
+            this->vKerning[(first - 32) * (128 - 32) + (second - 32)] = iKern * fScale;
+        }
+    }
 
     return S_OK;
 }
@@ -362,40 +275,117 @@ HRESULT environment_font::GetTextExtent(const char* strText, SIZE* pSize)
     if (nullptr == strText || nullptr == pSize)
         return E_FAIL;
 
-    FLOAT fRowWidth = 0.0f;
-    FLOAT fRowHeight = (this->fTexCoords[0][3] - this->fTexCoords[0][1]) * this->dwTexHeight;
     FLOAT fWidth = 0.0f;
-    FLOAT fHeight = fRowHeight;
+    FLOAT fHeight = 0.0f;
+    this->layout(strText, color(), 0L, false, &fWidth, &fHeight);
+
+    pSize->cx = (LONG)std::ceil(fWidth);
+    pSize->cy = (LONG)fHeight;
+
+    return S_OK;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// Name: layout()
+// Desc: Walks the string once, moving the pen by the real advance of each
+//       glyph plus kerning. Returns the widest row and the block height, and
+//       with bEmit also leaves the glyph quads in the layout scratch with the
+//       block starting at (0, 0), merged into runs per atlas page.
+//-----------------------------------------------------------------------------
+void environment_font::layout(const char* strText, color dwColor, DWORD dwFlags, bool bEmit, FLOAT* pWidth, FLOAT* pHeight)
+{
+    FLOAT fLineHeight = (FLOAT)this->glyphs[0].h;
+    FLOAT fPen = 0.0f;
+    FLOAT fRow = 0.0f;
+    FLOAT fWidth = 0.0f;
+    FLOAT fHeight = fLineHeight;
+    INT   iPrevious = -1;
+
+    if (bEmit) {
+        this->vLayoutVertices.clear();
+        this->vLayoutRuns.clear();
+    }
+
+    D3DCOLOR dwText = dwColor.argb();
+    D3DCOLOR dwShadow = (DWORD)((dwText >> 24 & 255) * 0.6f) << 24;
 
     while (*strText) {
         TCHAR c = *strText++;
 
         if (c == _T('\n')) {
-            fRowWidth = 0.0f;
-            fHeight += fRowHeight;
+            fPen = 0.0f;
+            fRow += fLineHeight;
+            fHeight += fLineHeight;
+            iPrevious = -1;
         }
 
         if ((c - 32) < 0 || (c - 32) >= 128 - 32)
             continue;
 
-        FLOAT tx1 = this->fTexCoords[c - 32][0];
-        FLOAT tx2 = this->fTexCoords[c - 32][2];
+        INT i = c - 32;
+
+        if (iPrevious >= 0 && !this->vKerning.empty())
+            fPen += this->vKerning[iPrevious * (128 - 32) + i];
+
+        if (bEmit && c != _T(' ')) {
+            FLOAT tx1 = this->fTexCoords[i][0];
+            FLOAT ty1 = this->fTexCoords[i][1];
+            FLOAT tx2 = this->fTexCoords[i][2];
+            FLOAT ty2 = this->fTexCoords[i][3];
+
+            FLOAT w = this->glyphs[i].w / this->fTextScale;
+            FLOAT h = this->glyphs[i].h / this->fTextScale;
+
+            // Glyphs land on whole pixels, the fraction stays in the pen
+            FLOAT sx = std::roundf(fPen) - this->dwSpacing;
+            FLOAT sy = fRow;
 
-        fRowWidth += (tx2 - tx1) * this->dwTexWidth - 2 * this->dwSpacing;
+            // Extend the current run while the glyph sits on the same page
+            if (this->vLayoutRuns.empty() || this->vLayoutRuns.back().iPage != this->iTexPage[i])
+                this->vLayoutRuns.push_back({ this->iTexPage[i], (INT)this->vLayoutVertices.size(), 0 });
 
-        if (fRowWidth > fWidth)
-            fWidth = fRowWidth;
+            size_t first = this->vLayoutVertices.size();
+
+            if (dwFlags & CD3DFONT_DROPSHADOW) {
+                this->vLayoutVertices.push_back(InitFont2DVertex(sx + 0 + 0.5f, sy + h + 0.5f, dwShadow, tx1, ty2));
+                this->vLayoutVertices.push_back(InitFont2DVertex(sx + 0 + 0.5f, sy + 0 + 0.5f, dwShadow, tx1, ty1));
+                this->vLayoutVertices.push_back(InitFont2DVertex(sx + w + 0.5f, sy + h + 0.5f, dwShadow, tx2, ty2));
+                this->vLayoutVertices.push_back(InitFont2DVertex(sx + w + 0.5f, sy + 0 + 0.5f, dwShadow, tx2, ty1));
+                this->vLayoutVertices.push_back(InitFont2DVertex(sx + w + 0.5f, sy + h + 0.5f, dwShadow, tx2, ty2));
+                this->vLayoutVertices.push_back(InitFont2DVertex(sx + 0 + 0.5f, sy + 0 + 0.5f, dwShadow, tx1, ty1));
+            }
+
+            this->vLayoutVertices.push_back(InitFont2DVertex(sx + 0 - 0.5f, sy + h - 0.5f, dwText, tx1, ty2));
+            this->vLayoutVertices.push_back(InitFont2DVertex(sx + 0 - 0.5f, sy + 0 - 0.5f, dwText, tx1, ty1));
+            this->vLayoutVertices.push_back(InitFont2DVertex(sx + w - 0.5f, sy + h - 0.5f, dwText, tx2, ty2));
+            this->vLayoutVertices.push_back(InitFont2DVertex(sx + w - 0.5f, sy + 0 - 0.5f, dwText, tx2, ty1));
+            this->vLayoutVertices.push_back(InitFont2DVertex(sx + w - 0.5f, sy + h - 0.5f, dwText, tx2, ty2));
+            this->vLayoutVertices.push_back(InitFont2DVertex(sx + 0 - 0.5f, sy + 0 - 0.5f, dwText, tx1, ty1));
+
+            this->vLayoutRuns.back().iCount += (INT)(this->vLayoutVertices.size() - first);
+        }
+
+        fPen += this->fAdvance[i];
+        iPrevious = i;
+
+        if (fPen > fWidth)
+            fWidth = fPen;
     }
 
-    pSize->cx = (int)fWidth;
-    pSize->cy = (int)fHeight;
+    if (pWidth)
+        *pWidth = fWidth;
 
-    return S_OK;
+    if (pHeight)
+        *pHeight = fHeight;
 }
 
 
 
 
+#ifdef _WIN32
 //-----------------------------------------------------------------------------
 // Name: DrawStringScaled()
 // Desc: Draws scaled 2D text.  Note that x and y are in viewport coordinates
@@ -406,25 +396,14 @@ HRESULT environment_font::GetTextExtent(const char* strText, SIZE* pSize)
 //-----------------------------------------------------------------------------
 HRESULT environment_font::text_scaled(FLOAT x, FLOAT y, FLOAT fXScale, FLOAT fYScale, const char* strText, color dwColor, DWORD dwFlags)
 {
-    if (this->pd3dDevice == nullptr)
-        return E_FAIL;
+    PROFILE_SCOPE("text", "font");
+    memory_scope memory(memory_tag::font);
 
-    // Set up renderstate
-    this->pStateBlockSaved->Capture();
-    this->pStateBlockDrawString->Apply();
-    this->pd3dDevice->SetFVF(D3DFVF_FONT2DVERTEX);
-    this->pd3dDevice->SetPixelShader(nullptr);
-    this->pd3dDevice->SetStreamSource(0, this->pVB, 0, sizeof(FONT2DVERTEX));
-
-    // Set filter states
-    if (dwFlags & CD3DFONT_FILTERED) {
-        this->pd3dDevice->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_LINEAR);
-        this->pd3dDevice->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR);
-    }
+    if (this->glyphs[0].h == 0)
+        return E_FAIL;
 
-    D3DVIEWPORT9 vp;
-    this->pd3dDevice->GetViewport(&vp);
-    FLOAT fLineHeight = (this->fTexCoords[0][3] - this->fTexCoords[0][1]) * this->dwTexHeight;
+    D3DVIEWPORT9 vp = render->handle();
+    FLOAT fLineHeight = (FLOAT)this->glyphs[0].h;
 
     // Center the text block
     if (dwFlags & CD3DFONT_CENTERED_X) {
@@ -448,10 +427,9 @@ HRESULT environment_font::text_scaled(FLOAT x, FLOAT y, FLOAT fXScale, FLOAT fYS
     sx -= this->dwSpacing * (fXScale * vp.Height) / fLineHeight;
     FLOAT fStartX = sx;
 
-    // Fill vertex buffer
-    FONT2DVERTEX* pVertices;
-    DWORD         dwNumTriangles = 0L;
-    this->pVB->Lock(0, 0, (void**)&pVertices, D3DLOCK_DISCARD);
+    // Queue the glyphs into the shared atlas batch
+    FONT2DVERTEX vertices[12];
+    bool bFiltered = (dwFlags & CD3DFONT_FILTERED) != 0;
 
     while (*strText) {
         TCHAR c = *strText++;
@@ -469,54 +447,41 @@ HRESULT environment_font::text_scaled(FLOAT x, FLOAT y, FLOAT fXScale, FLOAT fYS
         FLOAT tx2 = this->fTexCoords[c - 32][2];
         FLOAT ty2 = this->fTexCoords[c - 32][3];
 
-        FLOAT w = (tx2 - tx1) * this->dwTexWidth;
-        FLOAT h = (ty2 - ty1) * this->dwTexHeight;
+        FLOAT w = (FLOAT)this->glyphs[c - 32].w;
+        FLOAT h = (FLOAT)this->glyphs[c - 32].h;
 
         w *= (fXScale * vp.Height) / fLineHeight;
         h *= (fYScale * vp.Height) / fLineHeight;
 
         if (c != _T(' ')) {
+            FONT2DVERTEX* pVertices = vertices;
+
             if (dwFlags & CD3DFONT_DROPSHADOW) {
                 auto shadow = (DWORD)((dwColor.argb() >> 24 & 255) * 0.6f) << 24;
-                *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + 0 + 0.5f, sy + h + 0.5f, 1.0f, 1.0f), shadow, tx1, ty2);
-                *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + 0 + 0.5f, sy + 0 + 0.5f, 1.0f, 1.0f), shadow, tx1, ty1);
-                *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + w + 0.5f, sy + h + 0.5f, 1.0f, 1.0f), shadow, tx2, ty2);
-                *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + w + 0.5f, sy + 0 + 0.5f, 1.0f, 1.0f), shadow, tx2, ty1);
-                *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + w + 0.5f, sy + h + 0.5f, 1.0f, 1.0f), shadow, tx2, ty2);
-                *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + 0 + 0.5f, sy + 0 + 0.5f, 1.0f, 1.0f), shadow, tx1, ty1);
-                dwNumTriangles += 2;
+                *pVertices++ = InitFont2DVertex(sx + 0 + 0.5f, sy + h + 0.5f, shadow, tx1, ty2);
+                *pVertices++ = InitFont2DVertex(sx + 0 + 0.5f, sy + 0 + 0.5f, shadow, tx1, ty1);
+                *pVertices++ = InitFont2DVertex(sx + w + 0.5f, sy + h + 0.5f, shadow, tx2, ty2);
+                *pVertices++ = InitFont2DVertex(sx + w + 0.5f, sy + 0 + 0.5f, shadow, tx2, ty1);
+                *pVertices++ = InitFont2DVertex(sx + w + 0.5f, sy + h + 0.5f, shadow, tx2, ty2);
+                *pVertices++ = InitFont2DVertex(sx + 0 + 0.5f, sy + 0 + 0.5f, shadow, tx1, ty1);
             }
 
-            *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + 0 - 0.5f, sy + h - 0.5f, 1.0f, 1.0f), dwColor.argb(), tx1, ty2);
-            *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + 0 - 0.5f, sy + 0 - 0.5f, 1.0f, 1.0f), dwColor.argb(), tx1, ty1);
-            *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + w - 0.5f, sy + h - 0.5f, 1.0f, 1.0f), dwColor.argb(), tx2, ty2);
-            *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + w - 0.5f, sy + 0 - 0.5f, 1.0f, 1.0f), dwColor.argb(), tx2, ty1);
-            *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + w - 0.5f, sy + h - 0.5f, 1.0f, 1.0f), dwColor.argb(), tx2, ty2);
-            *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + 0 - 0.5f, sy + 0 - 0.5f, 1.0f, 1.0f), dwColor.argb(), tx1, ty1);
-            dwNumTriangles += 2;
-
-            if (dwNumTriangles * 3 > (MAX_NUM_VERTICES - 6)) {
-                // Unlock, render, and relock the vertex buffer
-                this->pVB->Unlock();
-                this->pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, dwNumTriangles);
-                this->pVB->Lock(0, 0, (void**)&pVertices, D3DLOCK_DISCARD);
-                dwNumTriangles = 0L;
-            }
+            *pVertices++ = InitFont2DVertex(sx + 0 - 0.5f, sy + h - 0.5f, dwColor.argb(), tx1, ty2);
+            *pVertices++ = InitFont2DVertex(sx + 0 - 0.5f, sy + 0 - 0.5f, dwColor.argb(), tx1, ty1);
+            *pVertices++ = InitFont2DVertex(sx + w - 0.5f, sy + h - 0.5f, dwColor.argb(), tx2, ty2);
+            *pVertices++ = InitFont2DVertex(sx + w - 0.5f, sy + 0 - 0.5f, dwColor.argb(), tx2, ty1);
+            *pVertices++ = InitFont2DVertex(sx + w - 0.5f, sy + h - 0.5f, dwColor.argb(), tx2, ty2);
+            *pVertices++ = InitFont2DVertex(sx + 0 - 0.5f, sy + 0 - 0.5f, dwColor.argb(), tx1, ty1);
+
+            atlas->push(this->iTexPage[c - 32], bFiltered, vertices, int(pVertices - vertices));
         }
 
-        sx += w - (2 * this->dwSpacing) * (fXScale * vp.Height) / fLineHeight;
+        sx += this->fAdvance[c - 32] * (fXScale * vp.Height) / fLineHeight;
     }
 
-    // Unlock and render the vertex buffer
-    this->pVB->Unlock();
-    if (dwNumTriangles > 0)
-        this->pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, dwNumTriangles);
-
-    // Restore the modified renderstates
-    this->pStateBlockSaved->Apply();
-
     return S_OK;
 }
+#endif
 
 HRESULT environment_font::text(int sx, int sy, const char* strText, color dwColor, DWORD dwFlags)
 {
@@ -525,7 +490,8 @@ HRESULT environment_font::text(int sx, int sy, const char* strText, color dwColo
 
 dimension environment_font::text_size(const char* text)
 {
-    SIZE size;
+    // GetTextExtent leaves size alone when it fails, which then measures as nothing.
+    SIZE size = { 0, 0 };
     this->GetTextExtent(text, &size);
     return dimension{ size.cx, size.cy };
 }
@@ -536,105 +502,37 @@ dimension environment_font::text_size(const char* text)
 //-----------------------------------------------------------------------------
 HRESULT environment_font::text(FLOAT sx, FLOAT sy, const char* strText, color dwColor, DWORD dwFlags)
 {
-    if (this->pd3dDevice == nullptr)
+    PROFILE_SCOPE("text", "font");
+    memory_scope memory(memory_tag::font);
+
+    if (this->glyphs[0].h == 0)
         return E_FAIL;
 
-    // Setup renderstate
-    this->pStateBlockSaved->Capture();
-    this->pStateBlockDrawString->Apply();
-    this->pd3dDevice->SetFVF(D3DFVF_FONT2DVERTEX);
-    this->pd3dDevice->SetPixelShader(nullptr);
-    this->pd3dDevice->SetStreamSource(0, this->pVB, 0, sizeof(FONT2DVERTEX));
-
-    // Set filter states
-    if (dwFlags & CD3DFONT_FILTERED) {
-        this->pd3dDevice->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_LINEAR);
-        this->pd3dDevice->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR);
-    }
+    // Lay the text out once, centering uses the size it measured on the way
+    FLOAT fWidth = 0.0f;
+    FLOAT fHeight = 0.0f;
+    this->layout(strText, dwColor, dwFlags, true, &fWidth, &fHeight);
 
     // Center the text block
-    if (dwFlags & CD3DFONT_CENTERED_X) {
-        SIZE sz;
-        GetTextExtent(strText, &sz);
-        sx -= (FLOAT)sz.cx * 0.5f;
-        sx = std::roundf(sx);
-    }
+    if (dwFlags & CD3DFONT_CENTERED_X)
+        sx = std::roundf(sx - fWidth * 0.5f);
 
-    if (dwFlags & CD3DFONT_CENTERED_Y) {
-        SIZE sz;
-        GetTextExtent(strText, &sz);
-        sy -= (FLOAT)sz.cy * 0.5f;
-        sy = std::roundf(sy);
-    }
+    if (dwFlags & CD3DFONT_CENTERED_Y)
+        sy = std::roundf(sy - fHeight * 0.5f);
 
-    // Adjust for character spacing
-    sx -= this->dwSpacing;
-    FLOAT fStartX = sx;
-
-    // Fill vertex buffer
-    FONT2DVERTEX* pVertices = nullptr;
-    DWORD         dwNumTriangles = 0;
-    this->pVB->Lock(0, 0, (void**)&pVertices, D3DLOCK_DISCARD);
+    // Move the block into place and queue it into the shared atlas batch
+    bool bFiltered = (dwFlags & CD3DFONT_FILTERED) != 0;
 
-    while (*strText) {
-        TCHAR c = *strText++;
+    for (const auto& run : this->vLayoutRuns) {
+        FONT2DVERTEX* pVertices = &this->vLayoutVertices[run.iFirst];
 
-        if (c == _T('\n')) {
-            sx = fStartX;
-            sy += (this->fTexCoords[0][3] - this->fTexCoords[0][1]) * this->dwTexHeight;
+        for (INT v = 0; v < run.iCount; v++) {
+            pVertices[v].x += sx;
+            pVertices[v].y += sy;
         }
 
-        if ((c - 32) < 0 || (c - 32) >= 128 - 32)
-            continue;
-
-        FLOAT tx1 = this->fTexCoords[c - 32][0];
-        FLOAT ty1 = this->fTexCoords[c - 32][1];
-        FLOAT tx2 = this->fTexCoords[c - 32][2];
-        FLOAT ty2 = this->fTexCoords[c - 32][3];
-
-        FLOAT w = (tx2 - tx1) * this->dwTexWidth / this->fTextScale;
-        FLOAT h = (ty2 - ty1) * this->dwTexHeight / this->fTextScale;
-
-        if (c != _T(' ')) {
-            if (dwFlags & CD3DFONT_DROPSHADOW) {
-                auto shadow = (DWORD)((dwColor.argb() >> 24 & 255) * 0.6f) << 24;
-                *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + 0 + 0.5f, sy + h + 0.5f, 1.0f, 1.0f), shadow, tx1, ty2);
-                *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + 0 + 0.5f, sy + 0 + 0.5f, 1.0f, 1.0f), shadow, tx1, ty1);
-                *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + w + 0.5f, sy + h + 0.5f, 1.0f, 1.0f), shadow, tx2, ty2);
-                *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + w + 0.5f, sy + 0 + 0.5f, 1.0f, 1.0f), shadow, tx2, ty1);
-                *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + w + 0.5f, sy + h + 0.5f, 1.0f, 1.0f), shadow, tx2, ty2);
-                *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + 0 + 0.5f, sy + 0 + 0.5f, 1.0f, 1.0f), shadow, tx1, ty1);
-                dwNumTriangles += 2;
-            }
-
-            *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + 0 - 0.5f, sy + h - 0.5f, 1.0f, 1.0f), dwColor.argb(), tx1, ty2);
-            *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + 0 - 0.5f, sy + 0 - 0.5f, 1.0f, 1.0f), dwColor.argb(), tx1, ty1);
-            *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + w - 0.5f, sy + h - 0.5f, 1.0f, 1.0f), dwColor.argb(), tx2, ty2);
-            *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + w - 0.5f, sy + 0 - 0.5f, 1.0f, 1.0f), dwColor.argb(), tx2, ty1);
-            *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + w - 0.5f, sy + h - 0.5f, 1.0f, 1.0f), dwColor.argb(), tx2, ty2);
-            *pVertices++ = InitFont2DVertex(XMFLOAT4(sx + 0 - 0.5f, sy + 0 - 0.5f, 1.0f, 1.0f), dwColor.argb(), tx1, ty1);
-            dwNumTriangles += 2;
-
-            if (dwNumTriangles * 3 > (MAX_NUM_VERTICES - 6)) {
-                // Unlock, render, and relock the vertex buffer
-                this->pVB->Unlock();
-                this->pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, dwNumTriangles);
-                pVertices = nullptr;
-                this->pVB->Lock(0, 0, (void**)&pVertices, D3DLOCK_DISCARD);
-                dwNumTriangles = 0L;
-            }
-        }
-
-        sx += w - (2 * this->dwSpacing);
+        atlas->push(run.iPage, bFiltered, pVertices, run.iCount);
     }
 
-    // Unlock and render the vertex buffer
-    this->pVB->Unlock();
-    if (dwNumTriangles > 0)
-        this->pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, dwNumTriangles);
-
-    // Restore the modified renderstates
-    this->pStateBlockSaved->Apply();
-
     return S_OK;
 }
@@ -1,7 +1,9 @@
 #pragma once
-#include <d3dx9.h>
+#include "../other/platform.h"
 #include "../other/color.h"
 #include "../other/maths.h"
+#include "atlas.h"
+#include <vector>
 
 /*
 * thanks nvidia for ready-to-use solution!
@@ -32,35 +34,54 @@ enum font_flags
 
 
 
+class truetype_font;
+
 //-----------------------------------------------------------------------------
 // Name: class CD3DFont
 // Desc: Texture-based font class for doing text in a 3D scene.
 //-----------------------------------------------------------------------------
 class environment_font
 {
+    friend class environment_atlas;
+
     TCHAR   strFontName[80];            // Font properties
     DWORD   dwFontHeight;
     DWORD   dwFontFlags;
     DWORD   dwFontWeight;
 
-    LPDIRECT3DDEVICE9       pd3dDevice; // A D3DDevice used for rendering
-    LPDIRECT3DTEXTURE9      pTexture;   // The d3d texture for this font
-    LPDIRECT3DVERTEXBUFFER9 pVB;        // VertexBuffer for rendering text
-    DWORD   dwTexWidth;                 // Texture dimensions
-    DWORD   dwTexHeight;
     FLOAT   fTextScale;
-    FLOAT   fTexCoords[128 - 32][4];
+    FLOAT   fTexCoords[128 - 32][4];    // Filled in by the atlas once the glyphs are packed
+    INT     iTexPage[128 - 32];         // Atlas page each glyph lives on
     DWORD   dwSpacing;                  // Character pixel spacing per side
+    FLOAT   fAdvance[128 - 32];         // Pen advance per glyph in pixels, fractional
+
+    // Kerning per (first, second) printable pair in pixels, empty when the font has none
+    std::vector<FLOAT> vKerning;
+
+    // Scratch for the single-pass layout, glyph quads merged into runs per atlas page
+    struct layout_run
+    {
+        INT iPage;
+        INT iFirst;
+        INT iCount;
+    };
+
+    std::vector<FONT2DVERTEX> vLayoutVertices;
+    std::vector<layout_run>   vLayoutRuns;
+
+    // Glyph cells rasterized before packing, also used for the cell size in pixels
+    atlas_bitmap glyphs[128 - 32];
 
-    // Stateblocks for setting and restoring render states
-    LPDIRECT3DSTATEBLOCK9 pStateBlockSaved;
-    LPDIRECT3DSTATEBLOCK9 pStateBlockDrawString;
+    // Measures the text and, with bEmit, lays out its glyph quads in one pass
+    void layout(const char* strText, color dwColor, DWORD dwFlags, bool bEmit, FLOAT* pWidth, FLOAT* pHeight);
 
 public:
     // 2D text drawing functions
     HRESULT text(int x, int y, const char* strText, color dwColor, DWORD dwFlags = 0L);
     HRESULT text(FLOAT x, FLOAT y, const char* strText, color dwColor, DWORD dwFlags = 0L);
+#ifdef _WIN32
     HRESULT text_scaled(FLOAT x, FLOAT y, FLOAT fXScale, FLOAT fYScale, const char* strText, color dwColor, DWORD dwFlags = 0L);
+#endif
 
     // text size function.
     dimension text_size(const char* text);
@@ -68,11 +89,11 @@ public:
     // Function to get extent of text
     HRESULT GetTextExtent(const char* strText, SIZE* pSize);
 
-    // Initializing and destroying device-dependent objects
-    HRESULT setup_device_objects(LPDIRECT3DDEVICE9 pd3dDevice);
-    HRESULT restore_device_objects();
-    HRESULT invalidate_device_objects();
-    HRESULT delete_device_objects();
+    // Rasterize the printable characters into glyph cells, the atlas packs and uploads them
+#ifdef _WIN32
+    HRESULT setup_glyphs();
+#endif
+    HRESULT setup_glyphs(const truetype_font& face);
 
     // Constructor / destructor
     environment_font(const TCHAR* strFontName, DWORD dwHeight, DWORD dwWeight, DWORD dwFlags = 0L);
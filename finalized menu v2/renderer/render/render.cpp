@@ -1,10 +1,24 @@
 #include "render.h"
+#include "../other/profiler.h"
+#include "../other/worker_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 
 environment_render* render	= new environment_render;
 render_font* fonts			= new render_font;
 
+#ifdef _WIN32
+// milliseconds since a steady clock time point.
+static double elapsed(std::chrono::steady_clock::time_point since)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
 void environment_render::setup(IDirect3DDevice9* handle_device)
 {
+	const auto setup_start = std::chrono::steady_clock::now();
+
 	this->device = handle_device;
 
 	// setup viewport.
@@ -17,33 +31,69 @@ void environment_render::setup(IDirect3DDevice9* handle_device)
 	font.push_back(&fonts->segoe_ui);
 	font.push_back(&fonts->segoe_ui_bold);
 
-	// setup our fonts.
+	// everything up to the upload is cpu work, so spread it over a pool for the duration of setup.
+	worker_pool workers;
+	this->startup.threads = workers.size();
+
+	// rasterize our fonts in parallel and share one atlas between them.
+	auto phase_start = std::chrono::steady_clock::now();
+	std::atomic<long long> rasterize_cpu{ 0 };
+
+	workers.for_each(int(this->font.size()), [this, &rasterize_cpu](int index) {
+		const auto font_start = std::chrono::steady_clock::now();
+		this->font[index]->setup_glyphs();
+		rasterize_cpu += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - font_start).count();
+		});
+
+	this->startup.rasterize		= elapsed(phase_start);
+	this->startup.rasterize_cpu	= rasterize_cpu / 1000.0;
+
 	for (auto f : this->font)
-	{
-		f->setup_device_objects(this->device);
-		f->restore_device_objects();
-	}
+		atlas->add(f);
+
+	// pack every font into as few pages as the device allows.
+	phase_start = std::chrono::steady_clock::now();
+
+	D3DCAPS9 caps;
+	this->device->GetDeviceCaps(&caps);
+	atlas->build(std::min<int>(2048, caps.MaxTextureWidth));
+
+	this->startup.pack = elapsed(phase_start);
+
+	// convert the pages into their texture format off the device thread.
+	phase_start = std::chrono::steady_clock::now();
+	atlas->convert(&workers);
+	this->startup.convert = elapsed(phase_start);
+
+	// only the upload touches the device.
+	phase_start = std::chrono::steady_clock::now();
+	atlas->setup_device_objects(this->device);
+	atlas->restore_device_objects();
+	this->startup.upload = elapsed(phase_start);
+
+	this->startup.total = elapsed(setup_start);
 }
 
 void environment_render::restore()
 {
+	// destroy atlas.
+	atlas->invalidate_device_objects();
+	atlas->delete_device_objects();
+
 	// destroy font.
 	for (auto f : this->font)
-	{
-		f->invalidate_device_objects();
-		f->delete_device_objects();
 		SAFE_DELETE(f);
-	}
 }
 
 void environment_render::lost_device()
 {
-	// destroy font if device not located.
-	for (auto f : this->font)
-	{
-		f->invalidate_device_objects();
-		f->delete_device_objects();
-	}
+	// render targets live in the default pool, they have to go before the reset.
+	while (!this->surfaces.empty())
+		this->release_surface(*this->surfaces.back());
+
+	// destroy atlas if device not located.
+	atlas->invalidate_device_objects();
+	atlas->delete_device_objects();
 }
 
 void environment_render::reset_device()
@@ -51,28 +101,63 @@ void environment_render::reset_device()
 	// re-setup our viewport.
 	this->handle();
 
-	// re-setup our fonts.
-	for (auto f : this->font)
-	{
-		f->setup_device_objects(this->device);
-		f->restore_device_objects();
-	}
+	// re-upload our atlas, glyphs are kept so nothing gets rasterized again.
+	atlas->setup_device_objects(this->device);
+	atlas->restore_device_objects();
+}
+#else
+// headless, the device is the null one from platform.h. there is no system font to rasterize, whoever
+// sets up the renderer gives the fonts their glyphs from a truetype face and builds the atlas.
+void environment_render::setup(IDirect3DDevice9* handle_device)
+{
+	this->device = handle_device;
+	this->handle();
+	this->setup_screen();
 }
 
+void environment_render::restore()
+{
+}
+
+void environment_render::lost_device()
+{
+	while (!this->surfaces.empty())
+		this->release_surface(*this->surfaces.back());
+}
+
+void environment_render::reset_device()
+{
+	this->handle();
+}
+#endif
+
 void environment_render::line(int x, int y, int w, int h, color color)
 {
+	// queued text goes first so draw order is kept.
+	atlas->flush();
+
 	std::vector<vertex> vertices = { };
 
 	vertices.emplace_back(vertex({ float(x), float(y) }, { 0.f, 1.f }, color.argb()));
 	vertices.emplace_back(vertex({ float(w), float(h) }, { 0.f, 1.f }, color.argb()));
 
+	if (this->capture)
+	{
+		this->capture->add_line(vertices.data());
+		return;
+	}
+
 	this->device->DrawPrimitiveUP(D3DPT_LINELIST, 1, vertices.data(), sizeof(vertex));
+	statistics->draw(2, sizeof(vertex));
 
 	vertices.clear();
 }
 
 void environment_render::filled_rect(int x, int y, int w, int h, color color)
 {
+	// queued text goes first so draw order is kept.
+	atlas->flush();
+
 	std::vector<vertex> vertices = { };
 
 	vertices.emplace_back(vertex({ x - 0.5f, y - 0.5f }, { 0.f, 1.f }, color.argb()));
@@ -80,7 +165,14 @@ void environment_render::filled_rect(int x, int y, int w, int h, color color)
 	vertices.emplace_back(vertex({ x - 0.5f, y + h - 0.5f }, { 0.f, 1.f }, color.argb()));
 	vertices.emplace_back(vertex({ x + w - 0.5f, y + h - 0.5f }, { 0.f, 1.f }, color.argb()));
 
+	if (this->capture)
+	{
+		this->capture->add_quad(vertices.data());
+		return;
+	}
+
 	this->device->DrawPrimitiveUP(D3DPT_TRIANGLESTRIP, 2, vertices.data(), sizeof(vertex));
+	statistics->draw(4, sizeof(vertex));
 
 	vertices.clear();
 }
@@ -121,6 +213,9 @@ void environment_render::gradient(int x, int y, int w, int h, color first, color
 		break;
 	}
 
+	// queued text goes first so draw order is kept.
+	atlas->flush();
+
 	std::vector<vertex> vertices = { };
 
 	vertices.emplace_back(vertex({ x - 0.5f, y - 0.5f }, { 0.f, 1.f }, colour[0].argb()));
@@ -128,11 +223,353 @@ void environment_render::gradient(int x, int y, int w, int h, color first, color
 	vertices.emplace_back(vertex({ x - 0.5f, y + h - 0.5f }, { 0.f, 1.f }, colour[2].argb()));
 	vertices.emplace_back(vertex({ x + w - 0.5f, y + h - 0.5f }, { 0.f, 1.f }, colour[3].argb()));
 
+	if (this->capture)
+	{
+		this->capture->add_quad(vertices.data());
+		return;
+	}
+
 	this->device->DrawPrimitiveUP(D3DPT_TRIANGLESTRIP, 2, vertices.data(), sizeof(vertex));
+	statistics->draw(4, sizeof(vertex));
 
 	vertices.clear();
 }
 
+void environment_render::filled_rects(const rect_instance* rects, std::size_t count)
+{
+	this->quads.clear();
+	rect_batch::filled(rects, count, this->quads);
+	this->draw_quads();
+}
+
+void environment_render::outlined_rects(const rect_instance* rects, std::size_t count)
+{
+	this->quads.clear();
+	rect_batch::outlined(rects, count, this->quads);
+	this->draw_quads();
+}
+
+void environment_render::draw_quads()
+{
+	if (this->quads.empty())
+		return;
+
+	if (this->capture)
+	{
+		for (std::size_t i = 0; i < this->quads.size(); i += 4)
+			this->capture->add_quad(this->quads.data() + i);
+
+		return;
+	}
+
+	// queued text goes first so draw order is kept.
+	atlas->flush();
+
+	this->submit_quads(this->quads.data(), this->quads.size() / 4);
+}
+
+void environment_render::submit_quads(const vertex* vertices, std::size_t total)
+{
+	const std::vector<std::uint16_t>& indices = rect_batch::quad_indices();
+
+	// 16-bit indices only reach max_batch_quads, larger batches are split.
+	for (std::size_t first = 0; first < total; first += max_batch_quads)
+	{
+		const UINT count = UINT(std::min<std::size_t>(max_batch_quads, total - first));
+		this->device->DrawIndexedPrimitiveUP(D3DPT_TRIANGLELIST, 0, count * 4, count * 2, indices.data(), D3DFMT_INDEX16, vertices + first * 4, sizeof(vertex));
+		statistics->draw(count * 4, sizeof(vertex), count * 6);
+	}
+}
+
+void environment_render::polyline(const vector_2d* points, std::size_t count, float thickness, color color, bool closed)
+{
+	const std::size_t segments = line_batch::segment_count(count, closed);
+
+	// pieces share their boundary point, so each covers up to max_polyline_points - 1 segments.
+	for (std::size_t first = 0; first < segments; first += max_polyline_points - 1)
+	{
+		const std::size_t last = std::min<std::size_t>(segments, first + max_polyline_points - 1);
+
+		this->geometry.clear();
+		this->geometry_indices.clear();
+		line_batch::polyline(points, count, first, last, thickness, color, closed, this->geometry, this->geometry_indices);
+		this->draw_geometry();
+	}
+}
+
+void environment_render::thick_line(float x0, float y0, float x1, float y1, float thickness, color color)
+{
+	const vector_2d points[2] = { { x0, y0 }, { x1, y1 } };
+	this->polyline(points, 2, thickness, color);
+}
+
+void environment_render::filled_circle(float x, float y, float radius, color color, int segments)
+{
+	this->geometry.clear();
+	this->geometry_indices.clear();
+	shapes->filled_circle({ x, y }, radius, segments, color, this->geometry, this->geometry_indices);
+	this->draw_geometry();
+}
+
+void environment_render::circle(float x, float y, float radius, color color, float thickness, int segments)
+{
+	this->geometry.clear();
+	this->geometry_indices.clear();
+	shapes->circle({ x, y }, radius, segments, thickness, color, this->geometry, this->geometry_indices);
+	this->draw_geometry();
+}
+
+void environment_render::arc(float x, float y, float radius, float start, float end, color color, float thickness, int segments)
+{
+	this->geometry.clear();
+	this->geometry_indices.clear();
+	shapes->arc({ x, y }, radius, start, end, segments, thickness, color, this->geometry, this->geometry_indices);
+	this->draw_geometry();
+}
+
+void environment_render::filled_rounded_rect(int x, int y, int w, int h, float radius, color color)
+{
+	this->geometry.clear();
+	this->geometry_indices.clear();
+	shapes->filled_rounded_rect(rect(x, y, w, h), radius, color, this->geometry, this->geometry_indices);
+	this->draw_geometry();
+}
+
+void environment_render::outlined_rounded_rect(int x, int y, int w, int h, float radius, color color, float thickness)
+{
+	this->geometry.clear();
+	this->geometry_indices.clear();
+	shapes->outlined_rounded_rect(rect(x, y, w, h), radius, thickness, color, this->geometry, this->geometry_indices);
+	this->draw_geometry();
+}
+
+void environment_render::draw_geometry()
+{
+	if (this->geometry_indices.empty())
+		return;
+
+	if (this->capture)
+	{
+		this->capture->add_geometry(this->geometry, this->geometry_indices);
+		return;
+	}
+
+	// queued text goes first so draw order is kept.
+	atlas->flush();
+
+	this->device->DrawIndexedPrimitiveUP(D3DPT_TRIANGLELIST, 0, UINT(this->geometry.size()), UINT(this->geometry_indices.size() / 3), this->geometry_indices.data(), D3DFMT_INDEX16, this->geometry.data(), sizeof(vertex));
+	statistics->draw(this->geometry.size(), sizeof(vertex), this->geometry_indices.size());
+}
+
+void environment_render::begin_capture(draw_list* list)
+{
+	// text queued before the capture belongs to the frame, not to the list.
+	atlas->flush();
+
+	this->captures.push_back(this->capture);
+	this->capture = list;
+	atlas->set_capture(list);
+}
+
+void environment_render::end_capture()
+{
+	if (this->captures.empty())
+		return;
+
+	this->capture = this->captures.back();
+	this->captures.pop_back();
+	atlas->set_capture(this->capture);
+}
+
+void environment_render::replay(const draw_list& list)
+{
+	// a list replayed into another capture becomes part of it.
+	if (this->capture)
+	{
+		this->capture->append(list);
+		return;
+	}
+
+	PROFILE_SCOPE("replay", "render");
+
+	for (const auto& command : list.commands)
+	{
+		// text is handed to the atlas batch, anything else has to wait until it's drawn.
+		if (command.type != draw_command_type::text)
+			atlas->flush();
+
+		switch (command.type)
+		{
+		case draw_command_type::quads:
+			this->submit_quads(list.vertices.data() + command.first, command.count / 4);
+			break;
+
+		case draw_command_type::lines:
+			this->device->DrawPrimitiveUP(D3DPT_LINELIST, UINT(command.count / 2), list.vertices.data() + command.first, sizeof(vertex));
+			statistics->draw(command.count, sizeof(vertex));
+			break;
+
+		case draw_command_type::geometry:
+			this->device->DrawIndexedPrimitiveUP(D3DPT_TRIANGLELIST, 0, UINT(command.count), UINT(command.index_count / 3), list.indices.data() + command.first_index, D3DFMT_INDEX16, list.vertices.data() + command.first, sizeof(vertex));
+			statistics->draw(command.count, sizeof(vertex), command.index_count);
+			break;
+
+		case draw_command_type::text:
+			atlas->push(command.page, command.filtered, list.glyphs.data() + command.first, int(command.count));
+			break;
+
+		case draw_command_type::clip_start:
+			this->start_clip(command.clip);
+			break;
+
+		case draw_command_type::clip_end:
+			this->end_clip();
+			break;
+
+		case draw_command_type::surface:
+			this->draw_texture(static_cast<LPDIRECT3DTEXTURE9>(command.texture), command.clip);
+			break;
+		}
+	}
+}
+
+bool environment_render::acquire_surface(render_surface& surface, int w, int h)
+{
+	if (w <= 0 || h <= 0)
+		return false;
+
+	if (surface.texture && surface.size.w == w && surface.size.h == h)
+		return true;
+
+	this->release_surface(surface);
+
+	const std::size_t bytes = std::size_t(w) * std::size_t(h) * 4;
+
+	if (this->surface_bytes + bytes > this->surface_budget)
+		return false;
+
+	if (FAILED(this->device->CreateTexture(UINT(w), UINT(h), 1, D3DUSAGE_RENDERTARGET, D3DFMT_A8R8G8B8, D3DPOOL_DEFAULT, &surface.texture, nullptr)))
+	{
+		surface.texture = nullptr;
+		return false;
+	}
+
+	surface.size	= { w, h };
+	surface.valid	= false;
+
+	this->surface_bytes += bytes;
+	this->surfaces.push_back(&surface);
+	return true;
+}
+
+void environment_render::release_surface(render_surface& surface)
+{
+	surface.valid = false;
+
+	if (!surface.texture)
+		return;
+
+	SAFE_RELEASE(surface.texture);
+	this->surface_bytes -= std::size_t(surface.size.w) * std::size_t(surface.size.h) * 4;
+	this->surfaces.erase(std::remove(this->surfaces.begin(), this->surfaces.end(), &surface), this->surfaces.end());
+}
+
+bool environment_render::begin_surface(render_surface& surface)
+{
+	if (!surface.texture || this->surface_saved)
+		return false;
+
+	LPDIRECT3DSURFACE9 level = nullptr;
+
+	if (FAILED(surface.texture->GetSurfaceLevel(0, &level)))
+		return false;
+
+	// the surface is drawn right away, even while a frame is being captured.
+	this->begin_capture(nullptr);
+	surface.version++;
+
+	this->surface_viewport = this->handle();
+	this->device->GetRenderTarget(0, &this->surface_saved);
+
+	// setting a target also resets the viewport and scissor rect to cover it.
+	this->device->SetRenderTarget(0, level);
+	statistics->current().state_changes++;
+	level->Release();
+
+	this->device->Clear(0, nullptr, D3DCLEAR_TARGET, 0, 1.f, 0);
+	return true;
+}
+
+void environment_render::end_surface()
+{
+	if (!this->surface_saved)
+		return;
+
+	// text queued inside the surface has to land there.
+	atlas->flush();
+
+	this->device->SetRenderTarget(0, this->surface_saved);
+	statistics->current().state_changes++;
+	SAFE_RELEASE(this->surface_saved);
+
+	this->set_viewport(this->surface_viewport);
+	this->end_capture();
+}
+
+void environment_render::draw_surface(const render_surface& surface, int x, int y)
+{
+	if (!surface.texture)
+		return;
+
+	const rect area = { x, y, surface.size.w, surface.size.h };
+
+	if (this->capture)
+	{
+		this->capture->add_surface(surface.texture, surface.version, area);
+		return;
+	}
+
+	this->draw_texture(surface.texture, area);
+}
+
+void environment_render::draw_texture(LPDIRECT3DTEXTURE9 texture, const rect& area)
+{
+	// queued text goes first so draw order is kept.
+	atlas->flush();
+
+	const float x = float(area.x), y = float(area.y), w = float(area.w), h = float(area.h);
+
+	// texels line up with pixels, so point sampling copies the surface as it was drawn.
+	const FONT2DVERTEX vertices[4] = {
+		InitFont2DVertex(x - 0.5f, y - 0.5f, 0xffffffff, 0.f, 0.f),
+		InitFont2DVertex(x + w - 0.5f, y - 0.5f, 0xffffffff, 1.f, 0.f),
+		InitFont2DVertex(x - 0.5f, y + h - 0.5f, 0xffffffff, 0.f, 1.f),
+		InitFont2DVertex(x + w - 0.5f, y + h - 0.5f, 0xffffffff, 1.f, 1.f)
+	};
+
+	this->device->SetTexture(0, texture);
+	this->device->SetFVF(D3DFVF_FONT2DVERTEX);
+
+#ifdef _WIN32
+	// a surface starts cleared to alpha 0 and is drawn with set_state's separate alpha blend, so its color
+	// already has its alpha applied. blending it with src alpha again would darken every translucent pixel.
+	this->device->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_ONE);
+#endif
+
+	this->device->DrawPrimitiveUP(D3DPT_TRIANGLESTRIP, 2, vertices, sizeof(FONT2DVERTEX));
+
+	// back to the untextured state set_state leaves.
+#ifdef _WIN32
+	this->device->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
+#endif
+	this->device->SetTexture(0, nullptr);
+	this->device->SetFVF(D3DFVF_XYZRHW | D3DFVF_DIFFUSE);
+
+	statistics->draw(4, sizeof(FONT2DVERTEX));
+	statistics->current().texture_switches	+= 2;
+	statistics->current().state_changes		+= 4;
+}
+
 void environment_render::set_viewport(D3DVIEWPORT9 viewport_handle)
 {
 	if (!this->device)
@@ -150,16 +587,36 @@ D3DVIEWPORT9 environment_render::handle()
 
 const void environment_render::start_clip(const rect area)
 {
+	if (this->capture)
+	{
+		this->capture->start_clip(area);
+		return;
+	}
+
+	// text queued so far belongs to the previous clip.
+	atlas->flush();
+
 	// save the original viewport to use it later.
 	this->old_viewport		= this->handle();
-	D3DVIEWPORT9 handle		= { area.x, area.y, area.w, area.h, 0.f, 1.f };
+	D3DVIEWPORT9 handle		= { DWORD(area.x), DWORD(area.y), DWORD(area.w), DWORD(area.h), 0.f, 1.f };
 	this->set_viewport(handle);
+	statistics->current().clip_changes++;
 }
 
 const void environment_render::end_clip()
 {
+	if (this->capture)
+	{
+		this->capture->end_clip();
+		return;
+	}
+
+	// text queued inside the clip has to be drawn before it goes away.
+	atlas->flush();
+
 	// reset our clipping.
 	this->set_viewport(this->old_viewport);
+	statistics->current().clip_changes++;
 }
 
 void environment_render::setup_screen()
@@ -171,6 +628,7 @@ void environment_render::setup_screen()
 
 void environment_render::set_state()
 {
+#ifdef _WIN32
 	this->device->SetVertexShader(nullptr);
 	this->device->SetPixelShader(nullptr);
 	this->device->SetTexture(NULL, nullptr);
@@ -199,4 +657,5 @@ void environment_render::set_state()
 
 	this->device->SetRenderState(D3DRS_SRGBWRITEENABLE, FALSE);
 	this->device->SetRenderState(D3DRS_COLORWRITEENABLE, D3DCOLORWRITEENABLE_RED | D3DCOLORWRITEENABLE_GREEN | D3DCOLORWRITEENABLE_BLUE | D3DCOLORWRITEENABLE_ALPHA);
-}
+#endif
+}
\ No newline at end of file
@@ -1,7 +1,15 @@
 #pragma once
 #include <vector>
+#ifdef _WIN32
 #include "../include.h"
+#else
+#include "../other/platform.h"
+#endif
 #include "font.h"
+#include "batch.h"
+#include "draw_list.h"
+#include "stats.h"
+#include "shape.h"
 
 enum gradient_direction : bool
 {
@@ -17,6 +25,27 @@ struct render_font
 
 extern render_font* fonts;
 
+// where renderer setup spent its time, in milliseconds.
+struct render_startup
+{
+	unsigned	threads			= 0;
+	double		rasterize		= 0.0;	// wall time for every font, rasterized in parallel.
+	double		rasterize_cpu	= 0.0;	// the same work summed per font, roughly what a serial setup would take.
+	double		pack			= 0.0;
+	double		convert			= 0.0;
+	double		upload			= 0.0;
+	double		total			= 0.0;
+};
+
+// offscreen copy of something drawn, composited back as one textured quad.
+struct render_surface
+{
+	LPDIRECT3DTEXTURE9	texture	= nullptr;
+	dimension			size;
+	bool				valid	= false;	// the texture holds what the owner would draw now.
+	std::uint32_t		version	= 0;		// bumped by every begin_surface, captured frames compare it.
+};
+
 class environment_render
 {
 public:
@@ -34,6 +63,49 @@ public:
 	void outlined_rect(int x, int y, int w, int h, color color);
 	void gradient(int x, int y, int w, int h, color first, color second, gradient_direction direction = horizontal);
 
+	// bulk versions for large counts, every rect of a call goes out in one indexed draw per max_batch_quads.
+	void filled_rects(const rect_instance* rects, std::size_t count);
+	void filled_rects(const std::vector<rect_instance>& rects) { this->filled_rects(rects.data(), rects.size()); }
+	void outlined_rects(const rect_instance* rects, std::size_t count);
+	void outlined_rects(const std::vector<rect_instance>& rects) { this->outlined_rects(rects.data(), rects.size()); }
+
+	// anti-aliased lines of any thickness, a whole polyline (or graph) goes out in one draw per max_polyline_points.
+	void polyline(const vector_2d* points, std::size_t count, float thickness, color color, bool closed = false);
+	void polyline(const std::vector<vector_2d>& points, float thickness, color color, bool closed = false) { this->polyline(points.data(), points.size(), thickness, color, closed); }
+	void thick_line(float x0, float y0, float x1, float y1, float thickness, color color);
+
+	// curved shapes from the cached rings in shape.h, segments = 0 picks a count from the radius.
+	// angles are radians, clockwise from +x.
+	void filled_circle(float x, float y, float radius, color color, int segments = 0);
+	void circle(float x, float y, float radius, color color, float thickness = 1.f, int segments = 0);
+	void arc(float x, float y, float radius, float start, float end, color color, float thickness = 1.f, int segments = 0);
+	void filled_rounded_rect(int x, int y, int w, int h, float radius, color color);
+	void outlined_rounded_rect(int x, int y, int w, int h, float radius, color color, float thickness = 1.f);
+
+public:
+	// while capturing, every primitive, clip and glyph is recorded into the list instead of drawn.
+	// captures nest, end_capture goes back to the previous one. a null list draws directly again.
+	void begin_capture(draw_list* list);
+	void end_capture();
+	bool capturing() const { return this->capture != nullptr; }
+	draw_list* capture_list() const { return this->capture; }
+
+	// draws a recorded list, merged commands go out as one draw call each. while capturing, the list is
+	// appended to the capture instead.
+	void replay(const draw_list& list);
+
+	// render target textures. acquire (re)creates the texture at the given size and fails once the surfaces
+	// would take more than the budget, callers then draw directly. begin_surface redirects drawing into a
+	// cleared surface until end_surface. every surface is released on device loss, owners find out through valid.
+	bool acquire_surface(render_surface& surface, int w, int h);
+	void release_surface(render_surface& surface);
+	bool begin_surface(render_surface& surface);
+	void end_surface();
+	void draw_surface(const render_surface& surface, int x, int y);
+
+	void set_surface_budget(std::size_t bytes) { this->surface_budget = bytes; }
+	std::size_t surface_memory() const { return this->surface_bytes; }
+
 public:
 	void set_viewport(D3DVIEWPORT9 viewport_handle);
 	D3DVIEWPORT9 handle();
@@ -41,15 +113,35 @@ public:
 	const void start_clip(const rect area);
 	const void end_clip();
 
+	// counters of the last finished frame, statistics keeps the rolling history.
+	const render_stats& stats() const { return statistics->history(0); }
+	const environment_stats& stats_history() const { return *statistics; }
+
 	dimension screen;
+	render_startup startup;
 
 private:
 	void setup_screen();
+	void draw_quads();
+	void submit_quads(const vertex* vertices, std::size_t total);
+	void draw_texture(LPDIRECT3DTEXTURE9 texture, const rect& area);
+	void draw_geometry();
 
 private:
 	std::vector<environment_font*>	font;
 	IDirect3DDevice9*				device = nullptr;
 	D3DVIEWPORT9					old_viewport;
+	std::vector<vertex>				quads;			// bulk rect scratch, kept so its capacity is reused.
+	std::vector<vertex>				geometry;		// polyline and shape scratch, indexed.
+	std::vector<std::uint16_t>		geometry_indices;
+	draw_list*						capture = nullptr;
+	std::vector<draw_list*>			captures;		// captures begin_capture interrupted.
+
+	std::vector<render_surface*>	surfaces;
+	std::size_t						surface_bytes	= 0;
+	std::size_t						surface_budget	= 16 * 1024 * 1024;
+	LPDIRECT3DSURFACE9				surface_saved	= nullptr;	// back buffer while drawing into a surface.
+	D3DVIEWPORT9					surface_viewport;
 };
 
 extern environment_render* render;
\ No newline at end of file
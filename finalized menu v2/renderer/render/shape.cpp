@@ -0,0 +1,253 @@
+#include "shape.h"
+#include <algorithm>
+#include <cmath>
+
+environment_shapes* shapes = new environment_shapes;
+
+static const float pi = 3.14159265358979f;
+
+// rings and templates are small, but an animated radius would otherwise keep adding new ones.
+static const std::size_t max_rings		= 1024;
+static const std::size_t max_templates	= 1024;
+
+// cache keys hold radii and thicknesses in 1/8 px.
+static std::uint32_t eighths(float value)
+{
+	return std::uint32_t(std::lround(std::max<float>(value, 0.f) * 8.f));
+}
+
+int environment_shapes::segments_for(float radius)
+{
+	// largest chord deviation from the true circle, in pixels.
+	const float tolerance = 0.25f;
+
+	int segments = 12;
+
+	if (radius > tolerance)
+		segments = int(std::ceil(pi / std::acos(1.f - tolerance / radius)));
+
+	segments = std::min<int>(std::max<int>(segments, 12), 512);
+	return (segments + 3) & ~3;
+}
+
+const std::vector<vector_2d>& environment_shapes::unit_circle(int segments)
+{
+	auto found = this->tables.find(segments);
+
+	if (found != this->tables.end())
+		return found->second;
+
+	std::vector<vector_2d>& table = this->tables[segments];
+	table.resize(std::size_t(segments));
+
+	for (int i = 0; i < segments; i++)
+	{
+		const float angle = 2.f * pi * float(i) / float(segments);
+		table[i] = vector_2d(std::cos(angle), std::sin(angle));
+	}
+
+	return table;
+}
+
+const std::vector<vector_2d>& environment_shapes::ring(float radius, int segments)
+{
+	const std::uint64_t key = (std::uint64_t(eighths(radius)) << 32) | std::uint32_t(segments);
+
+	auto found = this->rings.find(key);
+
+	if (found != this->rings.end())
+		return found->second;
+
+	if (this->rings.size() >= max_rings)
+		this->rings.clear();
+
+	const std::vector<vector_2d>& table = this->unit_circle(segments);
+	const float scale = float(key >> 32) / 8.f;
+
+	std::vector<vector_2d>& scaled = this->rings[key];
+	scaled.resize(table.size());
+
+	for (std::size_t i = 0; i < table.size(); i++)
+		scaled[i] = table[i] * scale;
+
+	return scaled;
+}
+
+// explicit segment counts are kept within what one draw can hold.
+static int pick_segments(float radius, int segments)
+{
+	return segments > 0 ? std::min<int>(std::max<int>(segments, 3), 1024) : environment_shapes::segments_for(radius);
+}
+
+template <class build_t>
+const environment_shapes::shape_template& environment_shapes::find_template(const template_key& key, build_t build)
+{
+	auto found = this->templates.find(key);
+
+	if (found != this->templates.end())
+		return found->second;
+
+	if (this->templates.size() >= max_templates)
+		this->templates.clear();
+
+	this->build_vertices.clear();
+	this->build_indices.clear();
+	// templates are built opaque white, emit() fills in the real colour.
+	build(this->build_vertices, this->build_indices);
+
+	shape_template& shape = this->templates[key];
+	shape.positions.resize(this->build_vertices.size());
+	shape.solid.resize(this->build_vertices.size());
+	shape.indices = this->build_indices;
+
+	for (std::size_t i = 0; i < this->build_vertices.size(); i++)
+	{
+		shape.positions[i]	= this->build_vertices[i].position;
+		shape.solid[i]		= (this->build_vertices[i].colour >> 24) != 0;
+	}
+
+	return shape;
+}
+
+void environment_shapes::emit(const shape_template& shape, vector_2d offset, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices)
+{
+	const DWORD solid	= colour.argb();
+	const DWORD clear	= colour.alpha(0).argb();
+
+	const std::size_t base = vertices.size();
+	vertices.resize(base + shape.positions.size());
+
+	vertex* out = vertices.data() + base;
+
+	for (std::size_t i = 0; i < shape.positions.size(); i++)
+		out[i] = vertex(shape.positions[i] + offset, { 0.f, 1.f }, shape.solid[i] ? solid : clear);
+
+	const std::size_t index_base = indices.size();
+	indices.resize(index_base + shape.indices.size());
+
+	for (std::size_t i = 0; i < shape.indices.size(); i++)
+		indices[index_base + i] = std::uint16_t(base + shape.indices[i]);
+}
+
+void environment_shapes::filled_circle(vector_2d centre, float radius, int segments, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices)
+{
+	segments = pick_segments(radius, segments);
+
+	const template_key key = { shape_kind::filled_circle, segments, eighths(radius), 0, 0, 0 };
+	const shape_template& shape = this->find_template(key, [&](std::vector<vertex>& v, std::vector<std::uint16_t>& i) {
+		const std::vector<vector_2d>& points = this->ring(radius, segments);
+		fill_batch::convex(points.data(), points.size(), color(255, 255, 255), v, i);
+		});
+
+	emit(shape, centre, colour, vertices, indices);
+}
+
+void environment_shapes::circle(vector_2d centre, float radius, int segments, float thickness, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices)
+{
+	segments = pick_segments(radius, segments);
+
+	const template_key key = { shape_kind::circle, segments, eighths(radius), eighths(thickness), 0, 0 };
+	const shape_template& shape = this->find_template(key, [&](std::vector<vertex>& v, std::vector<std::uint16_t>& i) {
+		const std::vector<vector_2d>& points = this->ring(radius, segments);
+		line_batch::polyline(points.data(), points.size(), 0, points.size(), float(key.thickness) / 8.f, color(255, 255, 255), true, v, i);
+		});
+
+	emit(shape, centre, colour, vertices, indices);
+}
+
+void environment_shapes::arc(vector_2d centre, float radius, float start, float end, int segments, float thickness, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices)
+{
+	if (end < start)
+		std::swap(start, end);
+
+	if (end - start >= 2.f * pi - 1e-4f)
+	{
+		this->circle(centre, radius, segments, thickness, colour, vertices, indices);
+		return;
+	}
+
+	segments = pick_segments(radius, segments);
+
+	const std::vector<vector_2d>& points = this->ring(radius, segments);
+	const float step = 2.f * pi / float(segments);
+
+	// exact end points, the ring points strictly between them come from the cache.
+	this->path.clear();
+	this->path.push_back(centre + vector_2d(std::cos(start), std::sin(start)) * radius);
+
+	const int first	= int(std::floor(start / step)) + 1;
+	const int last	= int(std::ceil(end / step)) - 1;
+
+	for (int i = first; i <= last; i++)
+		this->path.push_back(centre + points[std::size_t(((i % segments) + segments) % segments)]);
+
+	this->path.push_back(centre + vector_2d(std::cos(end), std::sin(end)) * radius);
+
+	line_batch::polyline(this->path.data(), this->path.size(), 0, this->path.size() - 1, thickness, colour, false, vertices, indices);
+}
+
+void environment_shapes::rounded_path(float x, float y, float w, float h, float radius)
+{
+	this->path.clear();
+
+	// match the radius the ring is cached at so corners meet the straight edges exactly.
+	radius = std::min<float>(radius, std::min<float>(w, h) * 0.5f);
+	radius = std::floor(radius * 8.f) / 8.f;
+
+	if (radius < 0.5f)
+	{
+		this->path.push_back({ x, y });
+		this->path.push_back({ x + w, y });
+		this->path.push_back({ x + w, y + h });
+		this->path.push_back({ x, y + h });
+		return;
+	}
+
+	const int segments	= segments_for(radius);
+	const int quarter	= segments / 4;
+
+	const std::vector<vector_2d>& points = this->ring(radius, segments);
+
+	// corner centres in path order, each walks a quarter of the ring starting at the given index.
+	const vector_2d centres[4] = { { x + radius, y + radius }, { x + w - radius, y + radius }, { x + w - radius, y + h - radius }, { x + radius, y + h - radius } };
+	const int starts[4] = { quarter * 2, quarter * 3, 0, quarter };
+
+	for (int corner = 0; corner < 4; corner++)
+	{
+		for (int i = 0; i <= quarter; i++)
+			this->path.push_back(centres[corner] + points[std::size_t((starts[corner] + i) % segments)]);
+	}
+}
+
+void environment_shapes::filled_rounded_rect(const rect& area, float radius, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices)
+{
+	const template_key key = { shape_kind::filled_rounded_rect, 0, eighths(radius), 0, area.w, area.h };
+	const shape_template& shape = this->find_template(key, [&](std::vector<vertex>& v, std::vector<std::uint16_t>& i) {
+		this->rounded_path(0.f, 0.f, float(area.w), float(area.h), float(key.radius) / 8.f);
+		fill_batch::convex(this->path.data(), this->path.size(), color(255, 255, 255), v, i);
+		});
+
+	emit(shape, vector_2d(float(area.x), float(area.y)), colour, vertices, indices);
+}
+
+void environment_shapes::outlined_rounded_rect(const rect& area, float radius, float thickness, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices)
+{
+	const template_key key = { shape_kind::outlined_rounded_rect, 0, eighths(radius), eighths(thickness), area.w, area.h };
+	const shape_template& shape = this->find_template(key, [&](std::vector<vertex>& v, std::vector<std::uint16_t>& i) {
+		// the stroke is centred half a thickness inside, so it covers the same pixels outlined_rect would.
+		const float stroke	= float(key.thickness) / 8.f;
+		const float inset	= stroke * 0.5f;
+
+		this->rounded_path(inset, inset, area.w - stroke, area.h - stroke, float(key.radius) / 8.f - inset);
+		line_batch::polyline(this->path.data(), this->path.size(), 0, this->path.size(), stroke, color(255, 255, 255), true, v, i);
+		});
+
+	emit(shape, vector_2d(float(area.x), float(area.y)), colour, vertices, indices);
+}
+
+void environment_shapes::clear()
+{
+	this->tables.clear();
+	this->rings.clear();
+	this->templates.clear();
+}
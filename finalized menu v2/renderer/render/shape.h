@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "batch.h"
+
+/*
+* rounded rects, circles and arcs.
+* every shape is built from a ring: the unit circle at a segment count, scaled by a radius. unit circles are
+* cached per segment count and rings per radius and segment count. circles and rounded rects go one step
+* further and cache their tessellated vertices around the origin, so drawing the same knob or rounded
+* control again is a translated copy instead of a round of sin/cos and joins. arcs change every frame with
+* their value, they only reuse the ring. the geometry goes through fill_batch / line_batch, so it gets the
+* same anti-aliased edges as polylines.
+*/
+class environment_shapes
+{
+public:
+	// segments for a radius so a chord never strays more than a quarter pixel from the circle,
+	// always a multiple of 4 so the quarters of a ring are the corners of a rounded rect.
+	static int segments_for(float radius);
+
+	// cos/sin of segments angles evenly spaced from 0, clockwise on screen.
+	const std::vector<vector_2d>& unit_circle(int segments);
+
+	// unit_circle scaled by radius, radius is quantized to 1/8 px for the cache key.
+	const std::vector<vector_2d>& ring(float radius, int segments);
+
+	// geometry builders, segments = 0 picks segments_for(radius). angles are radians, clockwise from +x.
+	void filled_circle(vector_2d centre, float radius, int segments, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices);
+	void circle(vector_2d centre, float radius, int segments, float thickness, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices);
+	void arc(vector_2d centre, float radius, float start, float end, int segments, float thickness, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices);
+	void filled_rounded_rect(const rect& area, float radius, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices);
+	void outlined_rounded_rect(const rect& area, float radius, float thickness, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices);
+
+	// drops every cached table, ring and template.
+	void clear();
+	std::size_t cached() const { return this->tables.size() + this->rings.size() + this->templates.size(); }
+
+private:
+	enum class shape_kind : int
+	{
+		filled_circle,
+		circle,
+		filled_rounded_rect,
+		outlined_rounded_rect
+	};
+
+	// radius and thickness are in 1/8 px, w and h only matter for rounded rects.
+	struct template_key
+	{
+		shape_kind		kind;
+		int				segments;
+		std::uint32_t	radius;
+		std::uint32_t	thickness;
+		int				w, h;
+
+		bool operator==(const template_key& k) const { return k.kind == this->kind && k.segments == this->segments && k.radius == this->radius && k.thickness == this->thickness && k.w == this->w && k.h == this->h; }
+	};
+
+	struct template_hash
+	{
+		std::size_t operator()(const template_key& k) const
+		{
+			std::uint64_t hash = std::uint64_t(k.kind) * 0x9e3779b97f4a7c15ull;
+			hash = (hash ^ std::uint64_t(k.segments)) * 0x100000001b3ull;
+			hash = (hash ^ k.radius) * 0x100000001b3ull;
+			hash = (hash ^ k.thickness) * 0x100000001b3ull;
+			hash = (hash ^ std::uint32_t(k.w)) * 0x100000001b3ull;
+			hash = (hash ^ std::uint32_t(k.h)) * 0x100000001b3ull;
+			return std::size_t(hash ^ (hash >> 32));
+		}
+	};
+
+	// tessellated shape around the origin, solid marks the vertices that take the colour's alpha.
+	struct shape_template
+	{
+		std::vector<vector_2d>		positions;
+		std::vector<std::uint8_t>	solid;
+		std::vector<std::uint16_t>	indices;
+	};
+
+	// finds or builds a template, build fills vertices / indices with the shape at the origin in any colour.
+	template <class build_t>
+	const shape_template& find_template(const template_key& key, build_t build);
+
+	// appends a template translated by offset.
+	static void emit(const shape_template& shape, vector_2d offset, color colour, std::vector<vertex>& vertices, std::vector<std::uint16_t>& indices);
+
+	// the outline of a rounded rect, clockwise from the top left corner.
+	void rounded_path(float x, float y, float w, float h, float radius);
+
+	std::unordered_map<int, std::vector<vector_2d>>					tables;
+	std::unordered_map<std::uint64_t, std::vector<vector_2d>>		rings;
+	std::unordered_map<template_key, shape_template, template_hash>	templates;
+	std::vector<vector_2d>											path;			// scratch for the points of the shape being built.
+	std::vector<vertex>												build_vertices;	// scratch while a template is built.
+	std::vector<std::uint16_t>										build_indices;
+};
+
+extern environment_shapes* shapes;
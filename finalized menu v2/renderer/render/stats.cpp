@@ -0,0 +1,159 @@
+#include "stats.h"
+#include "../other/allocations.h"
+#include <algorithm>
+
+environment_stats* statistics = new environment_stats;
+
+render_stats& render_stats::operator+=(const render_stats& s)
+{
+	this->draw_calls		+= s.draw_calls;
+	this->vertices			+= s.vertices;
+	this->indices			+= s.indices;
+	this->state_changes		+= s.state_changes;
+	this->texture_switches	+= s.texture_switches;
+	this->clip_changes		+= s.clip_changes;
+	this->glyphs			+= s.glyphs;
+	this->overflow_flushes	+= s.overflow_flushes;
+	this->bytes_uploaded	+= s.bytes_uploaded;
+	this->allocations		+= s.allocations;
+	this->frame_time		+= s.frame_time;
+	return *this;
+}
+
+void environment_stats::end_frame()
+{
+	const auto now				= std::chrono::steady_clock::now();
+	const std::uint64_t count	= allocation_count();
+
+	this->frame.frame_time		= std::chrono::duration<float, std::milli>(now - this->frame_end).count();
+	this->frame.allocations		= std::uint32_t(count - this->allocations_before);
+	this->frame_end				= now;
+	this->allocations_before	= count;
+
+	for (std::size_t i = 0; i <= memory_tags; i++)
+	{
+		const memory_usage usage = i < memory_tags ? memory_usage_of(memory_tag(i)) : memory_total();
+
+		this->memory_frames[i].live			= usage.live;
+		this->memory_frames[i].peak			= usage.frame_peak;
+		this->memory_frames[i].allocations	= std::uint32_t(usage.allocations - this->tag_allocations_before[i]);
+		this->tag_allocations_before[i]		= usage.allocations;
+	}
+
+	memory_new_frame();
+
+	this->ring[this->next] = this->frame;
+	this->ended++;
+	this->next = (this->next + 1) % history_length;
+	this->filled = std::min<std::size_t>(this->filled + 1, history_length);
+
+	this->frame = render_stats();
+}
+
+const render_stats& environment_stats::history(std::size_t age) const
+{
+	static const render_stats empty;
+
+	if (age >= this->filled)
+		return empty;
+
+	return this->ring[(this->next + history_length - 1 - age) % history_length];
+}
+
+render_stats environment_stats::average() const
+{
+	render_stats sum;
+	std::uint64_t totals[10] = { };
+	double frame_time = 0.0;
+
+	// summed wide so a long history of large frames can't overflow the 32-bit counters.
+	for (std::size_t age = 0; age < this->filled; age++)
+	{
+		const render_stats& s = this->history(age);
+		totals[0] += s.draw_calls;
+		totals[1] += s.vertices;
+		totals[2] += s.indices;
+		totals[3] += s.state_changes;
+		totals[4] += s.texture_switches;
+		totals[5] += s.clip_changes;
+		totals[6] += s.glyphs;
+		totals[7] += s.overflow_flushes;
+		totals[8] += s.bytes_uploaded;
+		totals[9] += s.allocations;
+		frame_time += s.frame_time;
+	}
+
+	if (this->filled == 0)
+		return sum;
+
+	const std::uint64_t n = this->filled;
+	sum.draw_calls			= std::uint32_t(totals[0] / n);
+	sum.vertices			= std::uint32_t(totals[1] / n);
+	sum.indices				= std::uint32_t(totals[2] / n);
+	sum.state_changes		= std::uint32_t(totals[3] / n);
+	sum.texture_switches	= std::uint32_t(totals[4] / n);
+	sum.clip_changes		= std::uint32_t(totals[5] / n);
+	sum.glyphs				= std::uint32_t(totals[6] / n);
+	sum.overflow_flushes	= std::uint32_t(totals[7] / n);
+	sum.bytes_uploaded		= totals[8] / n;
+	sum.allocations			= std::uint32_t(totals[9] / n);
+	sum.frame_time			= float(frame_time / double(n));
+	return sum;
+}
+
+render_stats environment_stats::peak() const
+{
+	render_stats most;
+
+	for (std::size_t age = 0; age < this->filled; age++)
+	{
+		const render_stats& s = this->history(age);
+		most.draw_calls			= std::max<std::uint32_t>(most.draw_calls, s.draw_calls);
+		most.vertices			= std::max<std::uint32_t>(most.vertices, s.vertices);
+		most.indices			= std::max<std::uint32_t>(most.indices, s.indices);
+		most.state_changes		= std::max<std::uint32_t>(most.state_changes, s.state_changes);
+		most.texture_switches	= std::max<std::uint32_t>(most.texture_switches, s.texture_switches);
+		most.clip_changes		= std::max<std::uint32_t>(most.clip_changes, s.clip_changes);
+		most.glyphs				= std::max<std::uint32_t>(most.glyphs, s.glyphs);
+		most.overflow_flushes	= std::max<std::uint32_t>(most.overflow_flushes, s.overflow_flushes);
+		most.bytes_uploaded		= std::max<std::uint64_t>(most.bytes_uploaded, s.bytes_uploaded);
+		most.allocations		= std::max<std::uint32_t>(most.allocations, s.allocations);
+		most.frame_time			= std::max<float>(most.frame_time, s.frame_time);
+	}
+
+	return most;
+}
+
+float environment_stats::frame_time_percentile(float fraction) const
+{
+	if (this->filled == 0)
+		return 0.f;
+
+	// the history is small and fixed, a copy and a partial sort per call is all it takes.
+	std::array<float, history_length> times;
+
+	for (std::size_t age = 0; age < this->filled; age++)
+		times[age] = this->history(age).frame_time;
+
+	const std::size_t rank = std::min<std::size_t>(this->filled - 1, std::size_t(std::max<float>(fraction, 0.f) * float(this->filled - 1) + 0.5f));
+	std::nth_element(times.begin(), times.begin() + rank, times.begin() + this->filled);
+	return times[rank];
+}
+
+void environment_stats::reset()
+{
+	this->frame		= render_stats();
+	this->next		= 0;
+	this->filled	= 0;
+
+	this->frame_end				= std::chrono::steady_clock::now();
+	this->allocations_before	= allocation_count();
+
+	for (std::size_t i = 0; i <= memory_tags; i++)
+	{
+		this->memory_frames[i]			= memory_frame();
+		this->tag_allocations_before[i]	= (i < memory_tags ? memory_usage_of(memory_tag(i)) : memory_total()).allocations;
+	}
+
+	memory_new_frame();
+}
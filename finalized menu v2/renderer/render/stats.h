@@ -0,0 +1,95 @@
+#pragma once
+#include "../other/allocations.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*
+* render statistics.
+* the renderer and the atlas count what they hand to the device into the current frame, end_frame moves
+* the frame into a rolling history. only work that reaches the device counts, primitives captured into a
+* draw list are counted when the list is replayed.
+*/
+
+struct render_stats
+{
+	std::uint32_t	draw_calls			= 0;
+	std::uint32_t	vertices			= 0;
+	std::uint32_t	indices				= 0;
+	std::uint32_t	state_changes		= 0;	// state block applies, fvf and render target switches.
+	std::uint32_t	texture_switches	= 0;
+	std::uint32_t	clip_changes		= 0;
+	std::uint32_t	glyphs				= 0;
+	std::uint32_t	overflow_flushes	= 0;	// extra draws because a text batch outgrew the vertex buffer.
+	std::uint64_t	bytes_uploaded		= 0;	// vertex and index data copied to the device.
+	std::uint32_t	allocations			= 0;	// heap allocations made during the frame.
+	float			frame_time			= 0.f;	// milliseconds since the previous frame ended.
+
+	render_stats& operator+=(const render_stats& s);
+};
+
+// one subsystem's heap use over a finished frame.
+struct memory_frame
+{
+	std::int64_t	live		= 0;	// bytes held when the frame ended.
+	std::int64_t	peak		= 0;	// most bytes held at any point during the frame.
+	std::uint32_t	allocations	= 0;	// allocations made during the frame.
+};
+
+class environment_stats
+{
+public:
+	// frames the history keeps.
+	static constexpr std::size_t history_length = 240;
+
+	render_stats& current() { return this->frame; }
+
+	// one draw of count vertices of the given size, plus its 16-bit indices.
+	void draw(std::size_t count, std::size_t vertex_size, std::size_t index_count = 0)
+	{
+		this->frame.draw_calls++;
+		this->frame.vertices		+= std::uint32_t(count);
+		this->frame.indices			+= std::uint32_t(index_count);
+		this->frame.bytes_uploaded	+= count * vertex_size + index_count * sizeof(std::uint16_t);
+	}
+
+	// closes the current frame and starts counting the next one.
+	void end_frame();
+
+	// frames ended since startup, unlike frames() it keeps counting once the history is full.
+	std::uint64_t frame_count() const { return this->ended; }
+
+	// finished frames, age 0 is the newest. frames() of them are held.
+	std::size_t frames() const { return this->filled; }
+	const render_stats& history(std::size_t age) const;
+
+	// per frame average and the largest value of each counter over the history.
+	render_stats average() const;
+	render_stats peak() const;
+
+	// frame time below which the given fraction (0..1) of the history falls.
+	float frame_time_percentile(float fraction) const;
+
+	// heap use of the newest finished frame by tag, and of every tag together.
+	const memory_frame& memory(memory_tag tag) const { return this->memory_frames[std::min<std::size_t>(std::size_t(tag), memory_tags)]; }
+	const memory_frame& memory() const { return this->memory_frames[memory_tags]; }
+
+	void reset();
+
+private:
+	render_stats								frame;
+	std::array<render_stats, history_length>	ring;
+	std::size_t									next	= 0;
+	std::size_t									filled	= 0;
+	std::uint64_t								ended	= 0;
+
+	std::chrono::steady_clock::time_point		frame_end			= std::chrono::steady_clock::now();
+	std::uint64_t								allocations_before	= 0;	// allocation_count() when the frame started.
+
+	std::array<memory_frame, memory_tags + 1>	memory_frames;
+	std::array<std::uint64_t, memory_tags + 1>	tag_allocations_before	= { };
+};
+
+extern environment_stats* statistics;
@@ -0,0 +1,136 @@
+#include "telemetry.h"
+#include <chrono>
+
+environment_telemetry* telemetry = new environment_telemetry;
+
+static const std::chrono::steady_clock::time_point telemetry_epoch = std::chrono::steady_clock::now();
+
+std::uint64_t environment_telemetry::now() const
+{
+	// offset by one so a timestamp is never 0, which marks "not set".
+	return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - telemetry_epoch).count()) + 1;
+}
+
+void environment_telemetry::begin_frame()
+{
+	const std::uint64_t time = this->now();
+
+	if (this->frame_end)
+		this->record(frame_phase::poll, time - this->frame_end);
+
+	// a frame that wasn't presented keeps its start, the input it read is still on its way to the screen.
+	if (!this->frame_begin)
+		this->frame_begin = time;
+}
+
+void environment_telemetry::end_frame(bool presented)
+{
+	const std::uint64_t time = this->now();
+
+	if (this->frame_end)
+		this->frames.record(time - this->frame_end);
+
+	this->frame_end = time;
+
+	if (!presented)
+		return;
+
+	// input is read once the pump is done, what it changed reaches the screen when present returns.
+	if (this->frame_begin)
+		this->input_latency.record(time - this->frame_begin);
+
+	for (const auto& stamp : this->read)
+		this->events[int(stamp.type)].record(time - stamp.time);
+
+	this->read.clear();
+	this->frame_begin = 0;
+}
+
+void environment_telemetry::input_arrived(input_event type)
+{
+	this->arrived.push_back({ type, this->now() });
+}
+
+void environment_telemetry::input_read()
+{
+	// a frame that never got presented hands what it read on to the next one.
+	this->read.insert(this->read.end(), this->arrived.begin(), this->arrived.end());
+	this->arrived.clear();
+}
+
+void environment_telemetry::record(frame_phase phase, std::uint64_t nanoseconds)
+{
+	this->phases[int(phase)].record(nanoseconds);
+}
+
+const char* environment_telemetry::phase_name(frame_phase phase)
+{
+	switch (phase)
+	{
+	case frame_phase::poll:		return "poll";
+	case frame_phase::think:	return "think";
+	case frame_phase::draw:		return "draw";
+	case frame_phase::present:	return "present";
+	default:					return "-";
+	}
+}
+
+const char* environment_telemetry::event_name(input_event type)
+{
+	switch (type)
+	{
+	case input_event::mouse_move:	return "mouse move";
+	case input_event::mouse_button:	return "mouse button";
+	case input_event::mouse_wheel:	return "mouse wheel";
+	case input_event::key:			return "key";
+	default:						return "-";
+	}
+}
+
+bool environment_telemetry::export_histograms(const char* path) const
+{
+	std::FILE* file = std::fopen(path, "w");
+
+	if (!file)
+		return false;
+
+	const double milliseconds = 1e6;
+
+	std::fputs("# frame time (ms)\n", file);
+	this->frames.print(file, milliseconds);
+
+	std::fputs("\n# input to present (ms)\n", file);
+	this->input_latency.print(file, milliseconds);
+
+	for (int i = 0; i < int(frame_phase::count); i++)
+	{
+		std::fprintf(file, "\n# %s (ms)\n", phase_name(frame_phase(i)));
+		this->phases[i].print(file, milliseconds);
+	}
+
+	for (int i = 0; i < int(input_event::count); i++)
+	{
+		std::fprintf(file, "\n# %s to present (ms)\n", event_name(input_event(i)));
+		this->events[i].print(file, milliseconds);
+	}
+
+	return std::fclose(file) == 0;
+}
+
+void environment_telemetry::reset()
+{
+	this->frames.reset();
+	this->input_latency.reset();
+
+	for (auto& phase : this->phases)
+		phase.reset();
+
+	for (auto& event : this->events)
+		event.reset();
+
+	this->arrived.clear();
+	this->read.clear();
+
+	this->frame_begin	= 0;
+	this->frame_end		= 0;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "../other/histogram.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/*
+* frame time telemetry.
+* the main loop marks each frame and times its phases, every value goes into a histogram that covers the
+* whole session, not just the recent history render stats keep. percentiles can be read at any time, on
+* exit the histograms are written out so the hitches behind a good average show up.
+*/
+
+enum class frame_phase : int
+{
+	poll,		// the message pump, from the end of the last frame to the start of this one.
+	think,
+	draw,		// everything drawn into the frame, after render_start cleared and began the scene.
+	present,	// render_end: replay, flush, end scene and present.
+	count
+};
+
+// what reached the window. buttons and keys are polled by the gui, their messages only stamp the time.
+enum class input_event : int
+{
+	mouse_move,
+	mouse_button,
+	mouse_wheel,
+	key,
+	count
+};
+
+class environment_telemetry
+{
+public:
+	// nanoseconds on the telemetry's clock.
+	std::uint64_t now() const;
+
+	// the message pump is done and the frame's input is in.
+	void begin_frame();
+
+	// present returned. records the frame time, and when the frame was presented how long the input it read
+	// took to get there. a frame that wasn't, skipped as identical or lost, hands its input to the next one.
+	void end_frame(bool presented = true);
+
+	// an input message reached the window, its latency runs from now.
+	void input_arrived(input_event type);
+
+	// the gui polled its input, everything that arrived until now first affects this frame.
+	void input_read();
+
+	void record(frame_phase phase, std::uint64_t nanoseconds);
+
+	const histogram& frame_time() const { return this->frames; }
+	const histogram& latency() const { return this->input_latency; }
+	const histogram& phase(frame_phase phase) const { return this->phases[int(phase)]; }
+
+	// from the message to the present of the first frame that read it.
+	const histogram& event_latency(input_event type) const { return this->events[int(type)]; }
+
+	static const char* phase_name(frame_phase phase);
+	static const char* event_name(input_event type);
+
+	// every histogram as hdr histogram percentile text, in milliseconds.
+	bool export_histograms(const char* path) const;
+
+	void reset();
+
+private:
+	histogram												frames;
+	histogram												input_latency;
+	std::array<histogram, std::size_t(frame_phase::count)>	phases;
+	std::array<histogram, std::size_t(input_event::count)>	events;
+
+	struct input_stamp
+	{
+		input_event		type;
+		std::uint64_t	time;
+	};
+
+	// waiting for a poll, and read by the frame in flight. both keep their capacity between frames.
+	std::vector<input_stamp>	arrived;
+	std::vector<input_stamp>	read;
+
+	std::uint64_t	frame_begin	= 0;	// when the oldest frame not presented yet began, 0 when there is none.
+	std::uint64_t	frame_end	= 0;	// when the last frame ended, 0 before the first.
+};
+
+extern environment_telemetry* telemetry;
+
+// records its own lifetime as a phase of the current frame.
+class telemetry_scope
+{
+public:
+	telemetry_scope(frame_phase phase) : phase(phase), start(telemetry->now()) { }
+	~telemetry_scope() { telemetry->record(this->phase, telemetry->now() - this->start); }
+
+	telemetry_scope(const telemetry_scope&) = delete;
+	telemetry_scope& operator=(const telemetry_scope&) = delete;
+
+private:
+	frame_phase		phase;
+	std::uint64_t	start;
+};
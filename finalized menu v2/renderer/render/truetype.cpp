@@ -0,0 +1,801 @@
+#include "truetype.h"
+#include "atlas.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// composite glyphs referencing composite glyphs deeper than this are treated as broken.
+#define MAX_COMPOSITE_DEPTH 8
+
+// composite glyph component flags.
+#define ARG_1_AND_2_ARE_WORDS		0x0001
+#define ARGS_ARE_XY_VALUES			0x0002
+#define WE_HAVE_A_SCALE				0x0008
+#define MORE_COMPONENTS				0x0020
+#define WE_HAVE_AN_X_AND_Y_SCALE	0x0040
+#define WE_HAVE_A_TWO_BY_TWO		0x0080
+
+// truetype data is big endian.
+static std::uint16_t read_u16(const std::uint8_t* p) { return std::uint16_t((p[0] << 8) | p[1]); }
+static std::int16_t read_s16(const std::uint8_t* p) { return std::int16_t(read_u16(p)); }
+static std::uint32_t read_u32(const std::uint8_t* p) { return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | p[3]; }
+
+// 2.14 fixed point used by composite transforms.
+static float read_f2dot14(const std::uint8_t* p) { return read_s16(p) / 16384.f; }
+
+bool truetype_font::load(const std::uint8_t* data, std::size_t size)
+{
+	*this = truetype_font();
+
+	if (!data || size < 12)
+		return false;
+
+	this->data.assign(data, data + size);
+
+	std::uint32_t head_length = 0, hhea_length = 0, maxp_length = 0, os2_length = 0, cmap_length = 0, loca_length = 0, kern_length = 0;
+
+	const std::uint32_t head = this->find_table("head", head_length);
+	const std::uint32_t hhea = this->find_table("hhea", hhea_length);
+	const std::uint32_t maxp = this->find_table("maxp", maxp_length);
+	const std::uint32_t os2 = this->find_table("OS/2", os2_length);
+	const std::uint32_t cmap = this->find_table("cmap", cmap_length);
+
+	this->loca = this->find_table("loca", loca_length);
+	this->hmtx = this->find_table("hmtx", this->hmtx_length);
+
+	// cff flavoured fonts have no glyf table, only plain truetype outlines are supported. the fixed fields
+	// read below have to be inside their tables.
+	if (!head || head_length < 54 || !hhea || hhea_length < 36 || !maxp || maxp_length < 6 || !cmap || cmap_length < 4 || !this->loca || !this->hmtx ||
+		!this->find_table("glyf", this->glyf_length))
+	{
+		*this = truetype_font();
+		return false;
+	}
+
+	const std::uint8_t* base = this->data.data();
+
+	this->units_per_em	= read_u16(base + head + 18);
+	this->loca_format	= read_s16(base + head + 50);
+	this->glyphs		= read_u16(base + maxp + 4);
+	this->long_metrics	= read_u16(base + hhea + 34);
+
+	// a short loca or hmtx only covers the glyphs it has room for.
+	const std::uint32_t loca_entry = this->loca_format == 0 ? 2 : 4;
+	this->glyphs		= std::min<int>(this->glyphs, int(loca_length / loca_entry) - 1);
+	this->long_metrics	= std::min<int>(this->long_metrics, int(this->hmtx_length / 4));
+
+	// gdi sizes the cell from the windows metrics, fall back to hhea when there are none.
+	if (os2 && os2_length >= 78)
+	{
+		this->ascender	= read_u16(base + os2 + 74);
+		this->descender	= read_u16(base + os2 + 76);
+	}
+	else
+	{
+		this->ascender	= read_s16(base + hhea + 4);
+		this->descender	= -read_s16(base + hhea + 6);
+	}
+
+	// prefer a full unicode subtable, then the bmp one.
+	const std::uint32_t cmap_end = cmap + cmap_length;
+	const int subtables = std::min<int>(read_u16(base + cmap + 2), int((cmap_length - 4) / 8));
+	std::uint32_t bmp = 0, full = 0;
+
+	for (int i = 0; i < subtables; i++)
+	{
+		const std::uint8_t* record = base + cmap + 4 + i * 8;
+		const int platform = read_u16(record);
+		const int encoding = read_u16(record + 2);
+		const std::uint32_t offset = read_u32(record + 4);
+
+		if (offset >= cmap_length || cmap_length - offset < 16)
+			continue;
+
+		const std::uint32_t subtable = cmap + offset;
+		const int format = read_u16(base + subtable);
+		const bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+
+		if (!unicode)
+			continue;
+
+		// the whole segment or group array has to be inside the table, glyph_index reads it unchecked.
+		if (format == 12 && !full)
+		{
+			if (std::uint64_t(subtable) + 16 + std::uint64_t(read_u32(base + subtable + 12)) * 12 <= cmap_end)
+				full = subtable;
+		}
+		else if (format == 4 && !bmp)
+		{
+			if (subtable + 16 + std::uint32_t(read_u16(base + subtable + 6) / 2) * 8 <= cmap_end)
+				bmp = subtable;
+		}
+	}
+
+	this->cmap		= full ? full : bmp;
+	this->cmap_end	= cmap_end;
+	this->glyf		= this->find_table("glyf", this->glyf_length);
+
+	// only the classic windows kern layout (version 0, format 0 horizontal pairs) is read, gpos kerning isn't.
+	const std::uint32_t kern = this->find_table("kern", kern_length);
+	const std::uint32_t kern_end = kern + kern_length;
+
+	if (kern && kern_length >= 4 && read_u16(base + kern) == 0)
+	{
+		const int kern_tables = read_u16(base + kern + 2);
+		std::uint32_t subtable = kern + 4;
+
+		for (int i = 0; i < kern_tables && subtable + 14 <= kern_end; i++)
+		{
+			const std::uint32_t length = read_u16(base + subtable + 2);
+			const int coverage = read_u16(base + subtable + 4);
+
+			// format 0 in the high byte, horizontal and not minimum/cross-stream in the low bits.
+			if ((coverage >> 8) == 0 && (coverage & 0x7) == 0x1)
+			{
+				const std::uint32_t pairs = read_u16(base + subtable + 6);
+
+				if (subtable + 14 + pairs * 6 <= kern_end)
+					this->kern = subtable + 6;
+
+				break;
+			}
+
+			if (length == 0)
+				break;
+
+			subtable += length;
+		}
+	}
+
+	if (!this->cmap || this->units_per_em <= 0 || this->glyphs <= 0)
+	{
+		*this = truetype_font();
+		return false;
+	}
+
+	return true;
+}
+
+bool truetype_font::load_file(const char* path)
+{
+	FILE* file = std::fopen(path, "rb");
+
+	if (!file)
+		return false;
+
+	std::vector<std::uint8_t> buffer;
+	std::uint8_t chunk[4096];
+	std::size_t read = 0;
+
+	while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+		buffer.insert(buffer.end(), chunk, chunk + read);
+
+	std::fclose(file);
+
+	return this->load(buffer.data(), buffer.size());
+}
+
+std::uint32_t truetype_font::find_table(const char* tag, std::uint32_t& length) const
+{
+	length = 0;
+
+	const std::uint8_t* base = this->data.data();
+	const int tables = read_u16(base + 4);
+
+	for (int i = 0; i < tables; i++)
+	{
+		const std::size_t record = 12 + std::size_t(i) * 16;
+
+		if (record + 16 > this->data.size())
+			break;
+
+		if (std::memcmp(base + record, tag, 4) != 0)
+			continue;
+
+		const std::uint32_t offset = read_u32(base + record + 8);
+		const std::uint32_t size = read_u32(base + record + 12);
+
+		// a table pointing outside the file is as good as missing.
+		if (std::uint64_t(offset) + size > this->data.size())
+			return 0;
+
+		length = size;
+		return offset;
+	}
+
+	return 0;
+}
+
+int truetype_font::glyph_index(std::uint32_t codepoint) const
+{
+	if (!this->valid())
+		return 0;
+
+	const std::uint8_t* table = this->data.data() + this->cmap;
+	const int format = read_u16(table);
+
+	if (format == 12)
+	{
+		const std::uint32_t groups = read_u32(table + 12);
+
+		// groups are sorted by start code.
+		std::uint32_t low = 0, high = groups;
+
+		while (low < high)
+		{
+			const std::uint32_t middle = (low + high) / 2;
+			const std::uint8_t* group = table + 16 + middle * 12;
+			const std::uint32_t start = read_u32(group);
+			const std::uint32_t end = read_u32(group + 4);
+
+			if (codepoint < start)
+				high = middle;
+			else if (codepoint > end)
+				low = middle + 1;
+			else
+				return int(read_u32(group + 8) + codepoint - start);
+		}
+
+		return 0;
+	}
+
+	// format 4, segmented bmp mapping.
+	if (codepoint > 0xffff)
+		return 0;
+
+	const int segments = read_u16(table + 6) / 2;
+	const std::uint8_t* end_codes = table + 14;
+	const std::uint8_t* start_codes = end_codes + segments * 2 + 2;
+	const std::uint8_t* deltas = start_codes + segments * 2;
+	const std::uint8_t* range_offsets = deltas + segments * 2;
+
+	for (int i = 0; i < segments; i++)
+	{
+		if (codepoint > read_u16(end_codes + i * 2))
+			continue;
+
+		const std::uint32_t start = read_u16(start_codes + i * 2);
+
+		if (codepoint < start)
+			return 0;
+
+		const int delta = read_s16(deltas + i * 2);
+		const int range_offset = read_u16(range_offsets + i * 2);
+
+		if (range_offset == 0)
+			return (codepoint + delta) & 0xffff;
+
+		// the range offset is relative to its own slot in the array.
+		const std::size_t entry_offset = std::size_t(range_offsets - this->data.data()) + i * 2 + range_offset + (codepoint - start) * 2;
+
+		if (entry_offset + 2 > this->cmap_end)
+			return 0;
+
+		const std::uint8_t* entry = this->data.data() + entry_offset;
+
+		const int glyph = read_u16(entry);
+		return glyph ? (glyph + delta) & 0xffff : 0;
+	}
+
+	return 0;
+}
+
+float truetype_font::scale_for_em(float pixels) const
+{
+	return this->units_per_em ? pixels / this->units_per_em : 0.f;
+}
+
+int truetype_font::advance(int glyph) const
+{
+	if (!this->valid() || this->long_metrics <= 0 || glyph < 0)
+		return 0;
+
+	// glyphs past the last long metric share its advance.
+	const int index = std::min<int>(glyph, this->long_metrics - 1);
+	return read_u16(this->data.data() + this->hmtx + index * 4);
+}
+
+int truetype_font::left_bearing(int glyph) const
+{
+	if (!this->valid() || this->long_metrics <= 0 || glyph < 0)
+		return 0;
+
+	const std::uint8_t* base = this->data.data() + this->hmtx;
+
+	if (glyph < this->long_metrics)
+		return read_s16(base + glyph * 4 + 2);
+
+	// the trailing bearings may stop short of the glyph count.
+	const std::size_t bearing = std::size_t(this->long_metrics) * 4 + std::size_t(glyph - this->long_metrics) * 2;
+
+	if (bearing + 2 > this->hmtx_length)
+		return 0;
+
+	return read_s16(base + bearing);
+}
+
+int truetype_font::kerning(int left, int right) const
+{
+	if (!this->valid() || !this->kern)
+		return 0;
+
+	const std::uint8_t* table = this->data.data() + this->kern;
+	const std::uint32_t key = (std::uint32_t(left) << 16) | std::uint32_t(right);
+
+	// pairs are sorted by the combined left/right key.
+	std::uint32_t low = 0, high = read_u16(table);
+
+	while (low < high)
+	{
+		const std::uint32_t middle = (low + high) / 2;
+		const std::uint8_t* pair = table + 8 + middle * 6;
+		const std::uint32_t pair_key = read_u32(pair);
+
+		if (key < pair_key)
+			high = middle;
+		else if (key > pair_key)
+			low = middle + 1;
+		else
+			return read_s16(pair + 4);
+	}
+
+	return 0;
+}
+
+std::uint32_t truetype_font::glyph_offset(int glyph, std::uint32_t& length) const
+{
+	length = 0;
+
+	if (glyph < 0 || glyph >= this->glyphs)
+		return 0;
+
+	const std::uint8_t* base = this->data.data() + this->loca;
+	std::uint32_t start, end;
+
+	if (this->loca_format == 0)
+	{
+		start	= read_u16(base + glyph * 2) * 2u;
+		end		= read_u16(base + glyph * 2 + 2) * 2u;
+	}
+	else
+	{
+		start	= read_u32(base + glyph * 4);
+		end		= read_u32(base + glyph * 4 + 4);
+	}
+
+	// load made sure loca holds glyphs + 1 entries, the glyph itself has to fit in glyf.
+	if (end <= start || end > this->glyf_length)
+		return 0;
+
+	length = end - start;
+	return this->glyf + start;
+}
+
+void truetype_font::outline(int glyph, std::vector<outline_point>& points, std::vector<int>& ends, int depth) const
+{
+	std::uint32_t length = 0;
+	const std::uint32_t offset = this->glyph_offset(glyph, length);
+
+	// empty glyphs (space) have no outline at all.
+	if (!offset || length < 10 || depth > MAX_COMPOSITE_DEPTH)
+		return;
+
+	const std::uint8_t* base = this->data.data();
+	const std::uint8_t* limit = base + offset + length;
+	const int contours = read_s16(base + offset);
+
+	if (contours >= 0)
+	{
+		const std::uint8_t* p = base + offset + 10;
+
+		if (p + contours * 2 + 2 > limit)
+			return;
+
+		const int first = int(points.size());
+		const int count = contours ? read_u16(p + (contours - 1) * 2) + 1 : 0;
+
+		// contour ends have to climb and stay inside the points, a glyph where they don't is dropped whole.
+		for (int i = 0, previous = -1; i < contours; i++)
+		{
+			const int end = read_u16(p + i * 2);
+
+			if (end < previous || end >= count)
+				return;
+
+			previous = end;
+		}
+
+		for (int i = 0; i < contours; i++)
+			ends.push_back(first + read_u16(p + i * 2) + 1);
+
+		// skip the hinting instructions, we rasterize unhinted.
+		p += contours * 2;
+		p += 2 + read_u16(p);
+
+		if (p > limit)
+			p = limit;
+
+		// flags come run-length encoded.
+		std::vector<std::uint8_t> flags(count);
+
+		for (int i = 0; i < count && p < limit;)
+		{
+			const std::uint8_t flag = *p++;
+			int repeat = 1;
+
+			if (flag & 8 && p < limit)
+				repeat += *p++;
+
+			for (; repeat > 0 && i < count; repeat--)
+				flags[i++] = flag;
+		}
+
+		points.resize(first + count);
+
+		// coordinates are deltas, either a byte with a sign flag or a signed word.
+		int value = 0;
+
+		for (int i = 0; i < count; i++)
+		{
+			const std::uint8_t flag = flags[i];
+
+			if (flag & 2)
+			{
+				const int delta = p < limit ? *p++ : 0;
+				value += (flag & 16) ? delta : -delta;
+			}
+			else if (!(flag & 16))
+			{
+				value += p + 2 <= limit ? read_s16(p) : 0;
+				p += 2;
+			}
+
+			points[first + i].x = float(value);
+			points[first + i].on_curve = (flag & 1) != 0;
+		}
+
+		value = 0;
+
+		for (int i = 0; i < count; i++)
+		{
+			const std::uint8_t flag = flags[i];
+
+			if (flag & 4)
+			{
+				const int delta = p < limit ? *p++ : 0;
+				value += (flag & 32) ? delta : -delta;
+			}
+			else if (!(flag & 32))
+			{
+				value += p + 2 <= limit ? read_s16(p) : 0;
+				p += 2;
+			}
+
+			points[first + i].y = float(value);
+		}
+
+		return;
+	}
+
+	// composite glyph, append each transformed component.
+	const std::uint8_t* p = base + offset + 10;
+	std::uint16_t flags = MORE_COMPONENTS;
+
+	while (flags & MORE_COMPONENTS && p + 4 <= limit)
+	{
+		flags = read_u16(p);
+		const int component = read_u16(p + 2);
+		p += 4;
+
+		// the offsets and the transform this component's flags announce.
+		const int arguments = (flags & ARG_1_AND_2_ARE_WORDS) ? 4 : 2;
+		const int transform = (flags & WE_HAVE_A_SCALE) ? 2 : (flags & WE_HAVE_AN_X_AND_Y_SCALE) ? 4 : (flags & WE_HAVE_A_TWO_BY_TWO) ? 8 : 0;
+
+		if (p + arguments + transform > limit)
+			return;
+
+		float dx = 0.f, dy = 0.f;
+
+		if (flags & ARG_1_AND_2_ARE_WORDS)
+		{
+			dx = read_s16(p);
+			dy = read_s16(p + 2);
+			p += 4;
+		}
+		else
+		{
+			dx = std::int8_t(p[0]);
+			dy = std::int8_t(p[1]);
+			p += 2;
+		}
+
+		// matching points instead of offsets is rare enough to ignore.
+		if (!(flags & ARGS_ARE_XY_VALUES))
+			dx = dy = 0.f;
+
+		float xx = 1.f, xy = 0.f, yx = 0.f, yy = 1.f;
+
+		if (flags & WE_HAVE_A_SCALE)
+		{
+			xx = yy = read_f2dot14(p);
+			p += 2;
+		}
+		else if (flags & WE_HAVE_AN_X_AND_Y_SCALE)
+		{
+			xx = read_f2dot14(p);
+			yy = read_f2dot14(p + 2);
+			p += 4;
+		}
+		else if (flags & WE_HAVE_A_TWO_BY_TWO)
+		{
+			xx = read_f2dot14(p);
+			xy = read_f2dot14(p + 2);
+			yx = read_f2dot14(p + 4);
+			yy = read_f2dot14(p + 6);
+			p += 8;
+		}
+
+		const std::size_t first = points.size();
+		this->outline(component, points, ends, depth + 1);
+
+		for (std::size_t i = first; i < points.size(); i++)
+		{
+			const float x = points[i].x;
+			const float y = points[i].y;
+
+			points[i].x = x * xx + y * yx + dx;
+			points[i].y = x * xy + y * yy + dy;
+		}
+	}
+}
+
+/*
+* coverage accumulation, every edge adds its signed area to the cells it crosses and a running sum
+* along each row turns that into exact coverage (same idea as font-rs / stb_truetype v2).
+* credit: https://medium.com/@raphlinus/inside-the-fastest-font-renderer-in-the-world-75ae5270c445
+*/
+struct coverage_accumulator
+{
+	int					w, h, stride;
+	std::vector<float>	cells;
+
+	coverage_accumulator(int w, int h) : w{ w }, h{ h }, stride{ w + 2 }, cells(std::size_t(w + 2) * h + 4, 0.f) { }
+
+	void line(float x0, float y0, float x1, float y1)
+	{
+		if (y0 == y1)
+			return;
+
+		// always walk downwards, the direction only flips the sign.
+		float direction = 1.f;
+
+		if (y0 > y1)
+		{
+			std::swap(x0, x1);
+			std::swap(y0, y1);
+			direction = -1.f;
+		}
+
+		const float dxdy = (x1 - x0) / (y1 - y0);
+		float x = x0;
+
+		if (y0 < 0.f)
+			x -= y0 * dxdy;
+
+		const int first_row = std::max<int>(0, int(y0));
+		const int last_row = std::min<int>(this->h, int(std::ceil(y1)));
+
+		// everything is clamped inside the row, the two spare columns soak up the right edge.
+		const float right = float(this->stride - 1) - 0.001f;
+
+		for (int y = first_row; y < last_row; y++)
+		{
+			float* row = &this->cells[std::size_t(y) * this->stride];
+			const float dy = std::min<float>(float(y + 1), y1) - std::max<float>(float(y), y0);
+			const float next = x + dxdy * dy;
+			const float d = dy * direction;
+
+			const float left_x = std::min<float>(std::max<float>(std::min<float>(x, next), 0.f), right);
+			const float right_x = std::min<float>(std::max<float>(std::max<float>(x, next), 0.f), right);
+
+			const float left_floor = std::floor(left_x);
+			const int left_i = int(left_floor);
+			const float right_ceil = std::ceil(right_x);
+			const int right_i = int(right_ceil);
+
+			if (right_i <= left_i + 1)
+			{
+				// edge stays inside one cell.
+				const float middle = 0.5f * (left_x + right_x) - left_floor;
+				row[left_i] += d - d * middle;
+				row[left_i + 1] += d * middle;
+			}
+			else
+			{
+				const float s = 1.f / (right_x - left_x);
+				const float left_f = left_x - left_floor;
+				const float a0 = 0.5f * s * (1.f - left_f) * (1.f - left_f);
+				const float right_f = right_x - right_ceil + 1.f;
+				const float am = 0.5f * s * right_f * right_f;
+
+				row[left_i] += d * a0;
+
+				if (right_i == left_i + 2)
+					row[left_i + 1] += d * (1.f - a0 - am);
+				else
+				{
+					const float a1 = s * (1.5f - left_f);
+					row[left_i + 1] += d * (a1 - a0);
+
+					for (int i = left_i + 2; i < right_i - 1; i++)
+						row[i] += d * s;
+
+					const float a2 = a1 + (right_i - left_i - 3) * s;
+					row[right_i - 1] += d * (1.f - a2 - am);
+				}
+
+				row[right_i] += d * am;
+			}
+
+			x = next;
+		}
+	}
+
+	void quadratic(float x0, float y0, float x1, float y1, float x2, float y2)
+	{
+		// subdivide based on how far the control point pulls the curve away from the chord.
+		const float dx = x0 - 2.f * x1 + x2;
+		const float dy = y0 - 2.f * y1 + y2;
+		const float deviation = dx * dx + dy * dy;
+
+		if (deviation < 0.333f)
+		{
+			this->line(x0, y0, x2, y2);
+			return;
+		}
+
+		const int steps = 1 + int(std::floor(std::sqrt(std::sqrt(3.f * deviation))));
+		float previous_x = x0, previous_y = y0;
+
+		for (int i = 1; i <= steps; i++)
+		{
+			const float t = float(i) / steps;
+			const float u = 1.f - t;
+			const float x = u * u * x0 + 2.f * u * t * x1 + t * t * x2;
+			const float y = u * u * y0 + 2.f * u * t * y1 + t * t * y2;
+
+			this->line(previous_x, previous_y, x, y);
+			previous_x = x;
+			previous_y = y;
+		}
+	}
+
+	void resolve(atlas_bitmap& bitmap)
+	{
+		// the sum runs across rows on purpose, closed contours always cancel out by the row end.
+		float sum = 0.f;
+
+		for (int y = 0; y < this->h; y++)
+		{
+			const float* row = &this->cells[std::size_t(y) * this->stride];
+			std::uint8_t* destination = &bitmap.pixels[std::size_t(y) * this->w];
+
+			for (int x = 0; x < this->stride; x++)
+			{
+				sum += row[x];
+
+				if (x < this->w)
+					destination[x] = std::uint8_t(std::min<float>(std::fabs(sum), 1.f) * 255.f + 0.5f);
+			}
+		}
+	}
+};
+
+void truetype_font::rasterize(int glyph, float scale, float origin_x, float baseline, atlas_bitmap& bitmap) const
+{
+	bitmap.pixels.assign(std::size_t(bitmap.w) * bitmap.h, 0);
+
+	if (!this->valid() || bitmap.w <= 0 || bitmap.h <= 0)
+		return;
+
+	std::vector<outline_point> points;
+	std::vector<int> ends;
+	this->outline(glyph, points, ends, 0);
+
+	if (points.empty())
+		return;
+
+	// font units are y-up, bitmap rows go down.
+	for (auto& point : points)
+	{
+		point.x = origin_x + point.x * scale;
+		point.y = baseline - point.y * scale;
+	}
+
+	coverage_accumulator accumulator(bitmap.w, bitmap.h);
+	int start = 0;
+
+	for (const int end : ends)
+	{
+		const int count = std::min<int>(end, int(points.size())) - start;
+
+		if (count < 2)
+		{
+			start = end;
+			continue;
+		}
+
+		const outline_point* contour = &points[start];
+
+		// begin on an on-curve point, or the implied one between two off-curve points.
+		int offset = 0;
+
+		while (offset < count && !contour[offset].on_curve)
+			offset++;
+
+		float start_x, start_y;
+
+		if (offset == count)
+		{
+			start_x = 0.5f * (contour[0].x + contour[count - 1].x);
+			start_y = 0.5f * (contour[0].y + contour[count - 1].y);
+			offset = 0;
+		}
+		else
+		{
+			start_x = contour[offset].x;
+			start_y = contour[offset].y;
+			offset++;
+		}
+
+		float x = start_x, y = start_y;
+		bool pending = false;
+		float control_x = 0.f, control_y = 0.f;
+
+		for (int i = 0; i <= count; i++)
+		{
+			// the final step closes the contour back onto the start.
+			const bool closing = i == count;
+			const outline_point& point = contour[(offset + i) % count];
+			const float px = closing ? start_x : point.x;
+			const float py = closing ? start_y : point.y;
+			const bool on_curve = closing || point.on_curve;
+
+			if (on_curve)
+			{
+				if (pending)
+					accumulator.quadratic(x, y, control_x, control_y, px, py);
+				else
+					accumulator.line(x, y, px, py);
+
+				x = px;
+				y = py;
+				pending = false;
+			}
+			else if (pending)
+			{
+				// two off-curve points in a row imply an on-curve point halfway between them.
+				const float middle_x = 0.5f * (control_x + px);
+				const float middle_y = 0.5f * (control_y + py);
+
+				accumulator.quadratic(x, y, control_x, control_y, middle_x, middle_y);
+
+				x = middle_x;
+				y = middle_y;
+				control_x = px;
+				control_y = py;
+			}
+			else
+			{
+				control_x = px;
+				control_y = py;
+				pending = true;
+			}
+		}
+
+		start = end;
+	}
+
+	accumulator.resolve(bitmap);
+}
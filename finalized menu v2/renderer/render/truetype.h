@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+* portable truetype reader and coverage rasterizer.
+* parses just the tables needed to lay out and draw glyphs (head, hhea, maxp, hmtx, loca, glyf, cmap, kern, os/2)
+* and rasterizes outlines with an exact-area accumulation buffer, no platform font api involved.
+* a loaded face is read-only, so glyphs can be rasterized from several threads at once.
+* reference: https://learn.microsoft.com/en-us/typography/opentype/spec/
+*/
+
+struct atlas_bitmap;
+
+class truetype_font
+{
+public:
+	// takes a copy of the font data, so embedded blobs and file buffers can go away afterwards.
+	bool load(const std::uint8_t* data, std::size_t size);
+	bool load_file(const char* path);
+
+	bool valid() const { return this->glyf != 0; }
+
+	// glyph index for a unicode codepoint, 0 (the missing glyph) if the font doesn't map it.
+	int glyph_index(std::uint32_t codepoint) const;
+
+	// pixels per font unit for an em of the given size, same as a negative lfHeight in gdi.
+	float scale_for_em(float pixels) const;
+
+	// vertical metrics in font units, windows ascent/descent when the font has an os/2 table.
+	int ascent() const { return this->ascender; }
+	int descent() const { return this->descender; }
+
+	// horizontal metrics in font units.
+	int advance(int glyph) const;
+	int left_bearing(int glyph) const;
+
+	// pair adjustment in font units from the legacy kern table, 0 when there is none.
+	int kerning(int left, int right) const;
+
+	// rasterize a glyph into 8-bit coverage, the pen sits at (origin_x, baseline) inside the bitmap.
+	// anything outside the bitmap is clipped, like gdi clips to the cell.
+	void rasterize(int glyph, float scale, float origin_x, float baseline, atlas_bitmap& bitmap) const;
+
+private:
+	struct outline_point
+	{
+		float	x, y;
+		bool	on_curve;
+	};
+
+	// a contour is a closed run of points, end holds the index one past its last point.
+	void outline(int glyph, std::vector<outline_point>& points, std::vector<int>& ends, int depth) const;
+
+	std::uint32_t glyph_offset(int glyph, std::uint32_t& length) const;
+
+	// offset of a table, 0 when it is missing or doesn't fit in the file.
+	std::uint32_t find_table(const char* tag, std::uint32_t& length) const;
+
+	std::vector<std::uint8_t>	data;
+
+	// every offset read out of the tables is checked against the end of the table it points into.
+	std::uint32_t				loca		= 0;
+	std::uint32_t				glyf		= 0;
+	std::uint32_t				glyf_length	= 0;
+	std::uint32_t				hmtx		= 0;
+	std::uint32_t				hmtx_length	= 0;
+	std::uint32_t				cmap		= 0;	// offset of the chosen cmap subtable.
+	std::uint32_t				cmap_end	= 0;	// end of the cmap table the subtable sits in.
+	std::uint32_t				kern		= 0;	// offset of the first horizontal format 0 kern subtable.
+
+	int							glyphs		= 0;
+	int							long_metrics = 0;
+	int							units_per_em = 0;
+	int							loca_format	= 0;
+	int							ascender	= 0;
+	int							descender	= 0;
+};